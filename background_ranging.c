@@ -1,16 +1,8 @@
-
-// #define VL53L5CX_DISABLE_AMBIENT_PER_SPAD
-// #define VL53L5CX_DISABLE_NB_SPADS_ENABLED
-// #define VL53L5CX_DISABLE_NB_TARGET_DETECTED
-// #define VL53L5CX_DISABLE_SIGNAL_PER_SPAD
-// #define VL53L5CX_DISABLE_RANGE_SIGMA_MM
-// #define VL53L5CX_DISABLE_DISTANCE_MM
-// #define VL53L5CX_DISABLE_REFLECTANCE_PERCENT
-// #define VL53L5CX_DISABLE_TARGET_STATUS
-// #define VL53L5CX_DISABLE_MOTION_INDICATOR
 #include <VL53L1X_api.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <linux/i2c-dev.h>
+#include <pthread.h>
 #include <semaphore.h>
 #include <signal.h>
 #include <stdint.h>
@@ -23,16 +15,69 @@
 #include <time.h>
 #include <unistd.h>
 #include <vl53l5cx_api.h>
+#include <vl53l5cx_plugin_detection_thresholds.h>
+#include <vl53l5cx_plugin_motion_indicator.h>
 #include <wiringPi.h>
+#ifdef SENSORS2SHM_SIM
+#include <sim_bus.h>
+#endif
+
+#include "change_gate.h"
+#include "history.h"
+#include "i2c_stats.h"
+#include "int_line.h"
+#include "metrics.h"
+#include "motion.h"
+#include "point_cloud.h"
+#include "polar_map.h"
+#include "rate_control.h"
+#include "record.h"
+#include "sector_map.h"
+#include "shm_layout.h"
+#include "target_stack.h"
+#include "trace.h"
+#include "zone_filter.h"
 
 // Константы для демона
 #define PID_FILE "/run/sensors2shm.pid"
 #define DAEMON_NAME "sensors2shm"
 
+// Отчёт профиля I2C по SIGUSR1 в режиме демона
+#define I2C_STATS_FILE "/run/sensors2shm.i2c"
+
+// Максимальное число датчиков в конфигурации
+#define MAX_SENSORS 64
+
+// Максимальный номер GPIO для XSHUT (заглушка wiringPi симулятора задаёт свой)
+#ifndef GPIO_PIN_MAX
+#define GPIO_PIN_MAX 40
+#endif
+
+// Выходы VL53L5CX по умолчанию: демон публикует только расстояния и статусы,
+// число целей нужно драйверу, чтобы пометить пустые зоны статусом 255
+#define L5CX_DEFAULT_OUTPUTS                                                   \
+  (VL53L5CX_OUTPUT_DISTANCE_MM | VL53L5CX_OUTPUT_TARGET_STATUS |               \
+   VL53L5CX_OUTPUT_NB_TARGET_DETECTED)
+
+// Порог режима mode=threshold по умолчанию: что-то ближе 1 м
+#define L5CX_DEFAULT_THRESHOLD_MM 1000
+
+// Параметры измерений по умолчанию (опции resolution=, frequency_hz=,
+// distance_mode=, timing_budget_ms=)
+#define L5CX_DEFAULT_RESOLUTION VL53L5CX_RESOLUTION_8X8
+#define L5CX_DEFAULT_FREQUENCY_HZ 10
+#define L1X_DEFAULT_DISTANCE_MODE 2 // long
+#define L1X_DEFAULT_TIMING_BUDGET_MS 100
+
+// Предельная частота VL53L5CX по разрешению
+#define L5CX_MAX_FREQUENCY_HZ_8X8 15
+#define L5CX_MAX_FREQUENCY_HZ_4X4 60
+
 typedef enum { SENSOR_VL53L1X, SENSOR_VL53L5CX, SENSOR_TCS34725 } SensorType;
 
 typedef struct {
   SensorType type;
+  uint8_t index; // Номер датчика в конфигурации
   int xshut_pin;
   uint8_t i2c_addr;
   char shm_name[256]; // Имя shared memory сегмента
@@ -41,36 +86,107 @@ typedef struct {
   // Указатель на конфигурацию датчика (используется только для VL53L5CX)
   void *sensor_config;
 
+  // Маска выходов VL53L5CX (VL53L5CX_OUTPUT_*), опция outputs= в конфиге
+  uint32_t l5cx_outputs;
+
+  // Транспорт VL53L5CX (опции transport= и dev= в конфиге)
+  uint8_t l5cx_transport; // VL53L5CX_TRANSPORT_I2C_DEV / _KERNEL / _CUSTOM
+  char dev_path[64];      // /dev/i2c-1 или /dev/stmvl53l5cx<N>
+
+  // Разрешение VL53L5CX (опция resolution=, 16 или 64)
+  uint8_t l5cx_resolution;
+
+  // Параметры измерений VL53L5CX (опции frequency_hz=, integration_ms=,
+  // ranging_mode=, sharpener=), проверенные при разборе конфига. 0 и -1 —
+  // значение драйвера по умолчанию
+  uint8_t l5cx_frequency_hz;
+  uint16_t l5cx_integration_ms;
+  uint8_t l5cx_ranging_mode; // VL53L5CX_RANGING_MODE_*
+  int l5cx_sharpener;        // Процент, -1 — по умолчанию
+
+  // Параметры VL53L1X (опции distance_mode=, timing_budget_ms=, roi=):
+  // измерения идут подряд, период равен бюджету времени
+  uint8_t l1x_distance_mode; // 1 — short, 2 — long
+  uint16_t l1x_timing_budget_ms;
+  uint8_t l1x_roi_width;     // SPAD, 0 — весь массив 16x16
+  uint8_t l1x_roi_height;
+  int l1x_roi_center;        // SPAD центра ROI, -1 — по умолчанию
+
+  // Режим по порогам (опции mode=threshold, threshold_mm=): датчик меряет
+  // сам (autonomous) и поднимает INT только при срабатывании порога зоны.
+  // threshold_low_mm 0 — порог «не дальше threshold_high_mm»
+  int l5cx_threshold_mode;
+  uint16_t threshold_low_mm;
+  uint16_t threshold_high_mm;
+
+  // Линия INT на GPIO (опция int_pin=, -1 — нет): поток датчика ждёт спада
+  int int_pin;
+  IntLine int_line;
+
+  // Счётчик кадров VL53L5CX из последнего кадра (255 — кадров ещё не было)
+  uint8_t l5cx_streamcount;
+
+  // Метки этапов текущего кадра, публикуются вместе с данными
+  FrameInfo frame;
+
+  // Фильтр зон VL53L5CX (опции filter=, filter_alpha=, filter_noise=) и
+  // сегмент <имя>_filtered с отфильтрованными кадрами
+  ZoneFilterParams filter_params;
+  ZoneFilter *filter;
+  char filtered_name[256];
+  SensorData *filtered_shm;
+
+  // Публикация только изменившихся кадров или кадров с движением (опции
+  // publish=, change_mm=, change_zones=, heartbeat_ms=)
+  ChangeGateParams gate_params;
+  ChangeGate *gate;
+
+  // Облако точек VL53L5CX (опции cloud=, pose=) и сегмент <имя>_cloud
+  int cloud_enabled;
+  CloudPose cloud_pose;
+  PointCloud *cloud;
+  char cloud_name[256];
+  CloudData *cloud_shm;
+
+  // Ближайшее препятствие по секторам матрицы (опция sectors=) и сегмент
+  // <имя>_sectors
+  SectorMap sector_map;
+  char sectors_name[256];
+  SectorData *sectors_shm;
+
+  // Индикатор движения VL53L5CX (опции motion=, motion_threshold=,
+  // motion_aggregates=) и сегмент <имя>_motion
+  MotionParams motion_params;
+  char motion_name[256];
+  MotionData *motion_shm;
+
+  // Целей на зону VL53L5CX (опции targets=, target_order=) и сегмент
+  // <имя>_targets со стеком целей, если целей больше одной. В основной
+  // сегмент и фильтры уходит первая цель зоны
+  uint8_t l5cx_targets;
+  uint8_t l5cx_target_order; // VL53L5CX_TARGET_ORDER_CLOSEST / _STRONGEST
+  char targets_name[256];
+  TargetStack *targets_shm;
+
+  // Частота по близости сцены (опции rate_bands=, rate_hysteresis_mm=,
+  // rate_hold_ms=) и текущий период измерений, который публикуется в
+  // заголовке сегмента вместе с полосой
+  RateParams rate_params;
+  RateControl rate;
+  uint32_t period_us;
+
+  // Поток чтения для датчиков на модуле ядра или с линией INT (ожидание
+  // прерывания)
+  pthread_t reader;
+  int reader_started;
+  volatile int reader_running;
+
   // Shared memory дескрипторы
   int shm_fd;
   void *shm_ptr;
   sem_t *sem; // дескриптор семафора
 } SensorConfig;
 
-// Структура данных датчика в shared memory
-typedef struct {
-  uint32_t timestamp;  // Временная метка
-  uint8_t sensor_type; // Тип датчика (0=VL53L1X, 1=VL53L5CX, 2=TCS34725)
-  uint8_t resolution;  // Разрешение (1 для одиночного, 16 для 4x4, 64 для 8x8)
-  uint8_t data_format; // Формат данных (0=одиночное, 1=матрица)
-  uint8_t reserved;    // Зарезервировано
-
-  // Объединение для разных форматов данных
-  union {
-    // Одиночное измерение (VL53L1X, TCS34725)
-    struct {
-      uint16_t distance_mm; // Расстояние в мм
-      uint8_t status;       // Статус измерения
-      uint8_t reserved[5];  // Зарезервировано
-    } single;
-
-    // Матричное измерение (VL53L5CX)
-    struct {
-      uint16_t distances[64]; // Массив расстояний (максимум 8x8)
-      uint8_t statuses[64];   // Массив статусов
-    } matrix;
-  } data;
-} SensorData;
 
 // Глобальные переменные для I2C
 static int i2c_fd = -1;
@@ -79,6 +195,12 @@ static int i2c_fd = -1;
 // Глобальная переменная для отслеживания состояния программы
 static volatile int running = 1;
 
+// Запрос отчёта профиля I2C (SIGUSR1)
+static volatile sig_atomic_t i2c_stats_requested = 0;
+
+// Запись сырых кадров (--record), файл открыт только во время записи
+static Recorder recorder;
+
 // Функция для создания PID файла
 int create_pid_file() {
   // Проверяем, не запущен ли уже демон
@@ -162,8 +284,18 @@ void signal_handler(int sig) {
   running = 0;
 }
 
+// Пустой обработчик SIGUSR2: прерывает ожидание прерывания в потоках чтения
+void wakeup_handler(int sig) {}
+
+// Обработчик SIGUSR1: отчёт профиля I2C пишет основной цикл
+void i2c_stats_handler(int sig) { i2c_stats_requested = 1; }
+
 // Функция для проверки наличия устройства на I2C адресе
 int check_i2c_device(uint8_t addr) {
+#ifdef SENSORS2SHM_SIM
+  return sim_bus_probe(addr);
+#endif
+
   if (i2c_fd < 0) {
     i2c_fd = open("/dev/i2c-1", O_RDWR);
     if (i2c_fd < 0) {
@@ -185,16 +317,123 @@ int check_i2c_device(uint8_t addr) {
   return 0;
 }
 
+// Дополнительный сегмент датчика (<имя>_filtered, <имя>_cloud,
+// <имя>_sectors, <имя>_motion): новый
+// формат, читается только по seqlock, поэтому без семафора
+static void *open_output_segment(const char *name, size_t size) {
+  int fd = shm_open(name, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    perror("Failed to create shared memory");
+    return NULL;
+  }
+  if (fchmod(fd, 0666) == -1 || ftruncate(fd, size) == -1) {
+    perror("Failed to set up shared memory");
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+
+  void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ptr == MAP_FAILED) {
+    perror("mmap failed");
+    shm_unlink(name);
+    return NULL;
+  }
+  memset(ptr, 0, size);
+
+  printf("Shared memory создан: %s\n", name);
+  return ptr;
+}
+
+// Состояние проверки изменений и сегменты фильтра зон, облака точек,
+// секторов и движения, если они включены в конфиге
+static int create_output_segments(SensorConfig *config) {
+  if (config->gate_params.mode != CHANGE_GATE_OFF) {
+    config->gate = malloc(sizeof(ChangeGate));
+    if (!config->gate) {
+      perror("Failed to allocate change gate");
+      return -1;
+    }
+    change_gate_init(config->gate, &config->gate_params, config->type);
+  }
+
+  if (config->filter_params.kind != ZONE_FILTER_NONE) {
+    snprintf(config->filtered_name, sizeof(config->filtered_name),
+             "%.246s_filtered", config->shm_name);
+    config->filter = malloc(sizeof(ZoneFilter));
+    if (!config->filter) {
+      perror("Failed to allocate zone filter");
+      return -1;
+    }
+    zone_filter_init(config->filter, &config->filter_params);
+    config->filtered_shm =
+        open_output_segment(config->filtered_name, sizeof(SensorData));
+    if (!config->filtered_shm)
+      return -1;
+  }
+
+  // Лучи зон нужны и облаку, и полярной карте
+  if (config->type == SENSOR_VL53L5CX && (config->cloud_enabled || polar_map)) {
+    config->cloud = malloc(sizeof(PointCloud));
+    if (!config->cloud) {
+      perror("Failed to allocate point cloud");
+      return -1;
+    }
+    cloud_init(config->cloud, &config->cloud_pose);
+  }
+
+  if (config->cloud_enabled) {
+    snprintf(config->cloud_name, sizeof(config->cloud_name), "%.249s_cloud",
+             config->shm_name);
+    config->cloud_shm =
+        open_output_segment(config->cloud_name, sizeof(CloudData));
+    if (!config->cloud_shm)
+      return -1;
+    config->cloud_shm->magic = CLOUD_MAGIC;
+    config->cloud_shm->version = CLOUD_VERSION;
+  }
+
+  if (config->sector_map.count) {
+    snprintf(config->sectors_name, sizeof(config->sectors_name),
+             "%.247s_sectors", config->shm_name);
+    config->sectors_shm =
+        open_output_segment(config->sectors_name, sizeof(SectorData));
+    if (!config->sectors_shm)
+      return -1;
+    config->sectors_shm->magic = SECTOR_MAGIC;
+    config->sectors_shm->version = SECTOR_VERSION;
+  }
+
+  if (config->motion_params.enabled) {
+    snprintf(config->motion_name, sizeof(config->motion_name),
+             "%.248s_motion", config->shm_name);
+    config->motion_shm =
+        open_output_segment(config->motion_name, sizeof(MotionData));
+    if (!config->motion_shm)
+      return -1;
+    config->motion_shm->magic = MOTION_MAGIC;
+    config->motion_shm->version = MOTION_VERSION;
+  }
+
+  if (config->type == SENSOR_VL53L5CX && config->l5cx_targets > 1) {
+    snprintf(config->targets_name, sizeof(config->targets_name),
+             "%.247s_targets", config->shm_name);
+    config->targets_shm =
+        open_output_segment(config->targets_name, sizeof(TargetStack));
+    if (!config->targets_shm)
+      return -1;
+    config->targets_shm->magic = TARGET_STACK_MAGIC;
+    config->targets_shm->version = TARGET_STACK_VERSION;
+  }
+  return 0;
+}
+
 // Функция для создания shared memory сегмента
 int create_shared_memory(SensorConfig *config) {
   // Определяем размер сегмента в зависимости от типа датчика
-  size_t shm_size;
-  if (config->type == SENSOR_VL53L5CX) {
-    shm_size =
-        8 + 64 * 3; // 8 байт заголовка + 64*2 (distances) + 64 (statuses)
-  } else {
-    shm_size = sizeof(SensorData); // Для одиночных датчиков
-  }
+  // Один размер для всех датчиков: заголовок, данные и метки кадра
+  size_t shm_size = sizeof(SensorData);
 
   // Создаем shared memory сегмент
   config->shm_fd =
@@ -233,7 +472,8 @@ int create_shared_memory(SensorConfig *config) {
   printf("Shared memory создан: %s (размер: %zu байт)\n", config->shm_name,
          shm_size);
 
-  // Создаем именованный семафор
+  // Создаем именованный семафор: сам демон его не берёт (запись защищена
+  // seqlock), он нужен клиентам, написанным до версии 2 формата
   char sem_name[256];
   snprintf(sem_name, sizeof(sem_name), "/sem_%.250s", config->shm_name);
   config->sem = sem_open(sem_name, O_CREAT, 0666,
@@ -254,9 +494,131 @@ int create_shared_memory(SensorConfig *config) {
     // не критично, можно продолжать, но выведем ошибку
   }
 
+  if (create_output_segments(config) != 0)
+    return -1;
+
+  return 0;
+}
+
+// Проверка изменений (publish=changes): кадр без изменений не публикуется,
+// кроме кадра heartbeat
+static int frame_should_publish(SensorConfig *config,
+                                const uint16_t *distances,
+                                const uint8_t *statuses, uint8_t zones,
+                                int moving) {
+  if (!config->gate)
+    return 1;
+  if (config->gate->params.mode == CHANGE_GATE_MOTION
+          ? change_gate_motion(config->gate, moving, record_now_ns())
+          : change_gate_check(config->gate, distances, statuses, zones,
+                              record_now_ns()))
+    return 1;
+  shm_skip_frame(&config->frame);
+  return 0;
+}
+
+// Период измерений со значением полосы или базовой частоты: Гц у
+// VL53L5CX, бюджет времени в мс у VL53L1X (период равен бюджету)
+static uint32_t rate_period_us(const SensorConfig *config, uint16_t value) {
+  if (config->type == SENSOR_VL53L5CX)
+    return value ? 1000000u / value : 0;
+  if (config->type == SENSOR_VL53L1X)
+    return value * 1000u;
   return 0;
 }
 
+// Частота в заголовке кадра: период и полоса (255 — базовая частота)
+static void fill_rate(const SensorConfig *config, SensorData *data) {
+  data->period_us = config->period_us;
+  data->rate_band = config->rate.band < config->rate.params.count
+                        ? config->rate.band
+                        : 255;
+}
+
+// Значение полосы band: частота VL53L5CX или бюджет VL53L1X; за
+// последней полосой — базовое значение из конфига
+static uint16_t rate_value(const SensorConfig *config, uint8_t band) {
+  if (band < config->rate.params.count)
+    return config->rate.params.value[band];
+  return config->type == SENSOR_VL53L5CX ? config->l5cx_frequency_hz
+                                         : config->l1x_timing_budget_ms;
+}
+
+// Запуск остановленного датчика с частотой или бюджетом value
+static int restart_at_rate(SensorConfig *config, uint16_t value) {
+  int status;
+
+  i2c_stats_call(I2C_CALL_CONFIG);
+  if (config->type == SENSOR_VL53L5CX) {
+    VL53L5CX_Configuration *dev =
+        (VL53L5CX_Configuration *)config->sensor_config;
+    status = vl53l5cx_set_ranging_frequency_hz(dev, (uint8_t)value);
+    i2c_stats_call(I2C_CALL_START_STOP);
+    status |= vl53l5cx_start_ranging(dev);
+
+    // Счётчик кадров датчика начинается заново
+    config->l5cx_streamcount = 255;
+  } else {
+    uint16_t dev = config->i2c_addr << 1;
+    status = VL53L1X_SetTimingBudgetInMs(dev, value);
+    status |= VL53L1X_SetInterMeasurementInMs(dev, value);
+    i2c_stats_call(I2C_CALL_START_STOP);
+    status |= VL53L1X_StartRanging(dev);
+  }
+  return status ? -1 : 0;
+}
+
+// Новая частота измерений. Частоту VL53L5CX и бюджет VL53L1X драйверы
+// меняют только при остановленных измерениях: датчик останавливается и
+// запускается снова без повторной инициализации и загрузки прошивки.
+// Кольцо модуля ядра не трогается — размер кадра прежний. Если новая
+// частота не применилась, датчик запускается с прежней (current)
+static int apply_rate(SensorConfig *config, uint16_t value,
+                      uint16_t current) {
+  int status;
+
+  i2c_stats_context(config->index, I2C_CALL_START_STOP);
+  if (config->type == SENSOR_VL53L5CX)
+    status = vl53l5cx_stop_ranging(
+        (VL53L5CX_Configuration *)config->sensor_config);
+  else
+    status = VL53L1X_StopRanging(config->i2c_addr << 1);
+  if (status != 0)
+    return -1;
+
+  if (restart_at_rate(config, value) == 0)
+    return 0;
+  if (restart_at_rate(config, current) != 0)
+    fprintf(stderr, "Sensor %d: ranging restart failed\n", config->index);
+  return -1;
+}
+
+// Частота по близости сцены: ближайшее достоверное расстояние кадра
+// выбирает полосу, при смене полосы датчик переходит на её частоту.
+// Полоса и период в заголовке меняются, только если датчик перешёл
+static void adapt_rate(SensorConfig *config, const uint16_t *distances,
+                       const uint8_t *statuses, uint8_t zones) {
+  if (config->rate.params.count == 0)
+    return;
+
+  FrameSummary summary;
+  uint8_t band;
+  shm_summarize(&summary, config->type, distances, statuses, zones);
+  if (!rate_update(&config->rate, summary.min_mm, record_now_ns(), &band))
+    return;
+
+  uint16_t value = rate_value(config, band);
+  if (apply_rate(config, value, rate_value(config, config->rate.band)) !=
+      0) {
+    metrics_i2c_error(config->index);
+    fprintf(stderr, "Sensor %d: ranging rate change failed\n",
+            config->index);
+    return;
+  }
+  rate_commit(&config->rate, band);
+  config->period_us = rate_period_us(config, value);
+}
+
 // Функция для записи одиночных данных в shared memory
 int write_single_to_shm(SensorConfig *config, uint16_t distance,
                         uint8_t status) {
@@ -265,19 +627,24 @@ int write_single_to_shm(SensorConfig *config, uint16_t distance,
     return -1;
   }
 
-  sem_wait(config->sem);
-
-  SensorData *data = (SensorData *)config->shm_ptr;
-
-  // Обновляем данные
-  data->timestamp = (uint32_t)time(NULL);
-  data->sensor_type = config->type;
-  data->resolution = 1;  // Одиночное измерение
-  data->data_format = 0; // Формат одиночного измерения
-  data->data.single.distance_mm = distance;
-  data->data.single.status = status;
+  history_frame(config->index, &distance, &status, 1);
+
+  // Статус 0 у VL53L1X — расстояние достоверно
+  if (config->type == SENSOR_VL53L1X)
+    polar_update_range(config->index, distance, status == 0);
+  if (frame_should_publish(config, &distance, &status, 1, 0)) {
+    SensorData *data = (SensorData *)config->shm_ptr;
+    shm_write_begin(data);
+    shm_fill_single(data, config->type, distance, status);
+    fill_rate(config, data);
+    shm_publish_frame(data, &config->frame, record_now_ns());
+    shm_write_end(data);
+    metrics_frame_published(config->index);
+    trace_event(config->index, TRACE_PUBLISHED, (uint16_t)config->frame.seq);
+  }
 
-  sem_post(config->sem);
+  // Новая частота — после публикации кадра, измеренного со старой
+  adapt_rate(config, &distance, &status, 1);
   return 0;
 }
 
@@ -289,31 +656,128 @@ int write_matrix_to_shm(SensorConfig *config, uint16_t *distances,
     return -1;
   }
 
-  sem_wait(config->sem);
-
   SensorData *data = (SensorData *)config->shm_ptr;
+  shm_write_begin(data);
+  shm_fill_matrix(data, config->type, distances, statuses, resolution);
+  fill_rate(config, data);
+  shm_publish_frame(data, &config->frame, record_now_ns());
+  shm_write_end(data);
+  metrics_frame_published(config->index);
+  trace_event(config->index, TRACE_PUBLISHED, (uint16_t)config->frame.seq);
+  return 0;
+}
 
-  // Обновляем данные
-  data->timestamp = (uint32_t)time(NULL);
-  data->sensor_type = config->type;
-  data->resolution = resolution; // 16 для 4x4, 64 для 8x8
-  data->data_format = 1;         // Формат матричного измерения
-
-  // Копируем данные матрицы
-  for (int i = 0; i < resolution; i++) {
-    data->data.matrix.distances[i] = distances[i];
-    data->data.matrix.statuses[i] = statuses[i];
+// Фильтр зон по кадру: отфильтрованные расстояния в filtered
+static void filter_zones(SensorConfig *config, VL53L5CX_ResultsData *results,
+                         const uint16_t *distances, const uint8_t *statuses,
+                         uint8_t resolution, uint16_t *filtered) {
+  const uint16_t *sigma_mm = NULL;
+#ifndef VL53L5CX_DISABLE_RANGE_SIGMA_MM
+  // Погрешность первой цели зоны: шаг зоны в результатах — число целей
+  uint16_t sigma[64];
+  if (config->l5cx_outputs & VL53L5CX_OUTPUT_RANGE_SIGMA_MM) {
+    for (int i = 0; i < resolution; i++)
+      sigma[i] = results->range_sigma_mm[i * config->l5cx_targets];
+    sigma_mm = sigma;
   }
+#else
+  (void)results;
+#endif
+  zone_filter_apply(config->filter, resolution, distances, statuses, sigma_mm,
+                    filtered);
+}
 
-  sem_post(config->sem);
-  return 0;
+// Запись отфильтрованного кадра в <имя>_filtered. frame — метки кадра до
+// публикации исходного: у отфильтрованного тот же номер публикации
+static void write_filtered_to_shm(SensorConfig *config, FrameInfo frame,
+                                  const uint16_t *filtered,
+                                  const uint8_t *statuses,
+                                  uint8_t resolution) {
+  SensorData *data = config->filtered_shm;
+  shm_write_begin(data);
+  shm_fill_matrix(data, config->type, filtered, statuses, resolution);
+  fill_rate(config, data);
+  shm_publish_frame(data, &frame, record_now_ns());
+  shm_write_end(data);
+}
+
+// Запись облака точек кадра в <имя>_cloud с номером публикации исходного
+static void write_cloud_to_shm(SensorConfig *config, FrameInfo frame,
+                               const CloudData *cloud) {
+  CloudData *data = config->cloud_shm;
+  shm_seq_write_begin(&data->write_seq);
+  data->resolution = cloud->resolution;
+  data->count = cloud->count;
+  memcpy(data->points, cloud->points, cloud->count * sizeof(cloud->points[0]));
+  memcpy(data->zones, cloud->zones, cloud->count);
+  frame.seq++;
+  frame.publish_ns = record_now_ns();
+  data->frame = frame;
+  shm_seq_write_end(&data->write_seq);
+}
+
+// Сектора кадра в <имя>_sectors с номером публикации исходного
+static void write_sectors_to_shm(SensorConfig *config, FrameInfo frame,
+                                 const uint16_t *distances,
+                                 const uint8_t *statuses,
+                                 uint8_t resolution) {
+  SectorData *data = config->sectors_shm;
+  shm_seq_write_begin(&data->write_seq);
+  sector_compute(&config->sector_map, distances, statuses, resolution, data);
+  frame.seq++;
+  frame.publish_ns = record_now_ns();
+  data->frame = frame;
+  shm_seq_write_end(&data->write_seq);
+}
+
+// Индикатор движения кадра в <имя>_motion с номером публикации исходного
+static void write_motion_to_shm(SensorConfig *config, FrameInfo frame,
+                                const VL53L5CX_ResultsData *results,
+                                uint8_t moving) {
+  MotionData *data = config->motion_shm;
+  shm_seq_write_begin(&data->write_seq);
+  data->aggregates = results->motion_indicator.nb_of_aggregates;
+  data->detected = results->motion_indicator.nb_of_detected_aggregates;
+  data->global_indicator_1 = results->motion_indicator.global_indicator_1;
+  data->global_indicator_2 = results->motion_indicator.global_indicator_2;
+  data->status = results->motion_indicator.status;
+  data->moving = moving;
+  memcpy(data->motion, results->motion_indicator.motion,
+         sizeof(data->motion));
+  frame.seq++;
+  frame.publish_ns = record_now_ns();
+  data->frame = frame;
+  shm_seq_write_end(&data->write_seq);
+}
+
+// Стек целей кадра в <имя>_targets с номером публикации исходного
+static void write_targets_to_shm(SensorConfig *config, FrameInfo frame,
+                                 const VL53L5CX_ResultsData *results) {
+  const uint16_t *sigma_mm = NULL;
+  const uint8_t *detected = NULL;
+#ifndef VL53L5CX_DISABLE_RANGE_SIGMA_MM
+  if (config->l5cx_outputs & VL53L5CX_OUTPUT_RANGE_SIGMA_MM)
+    sigma_mm = results->range_sigma_mm;
+#endif
+#ifndef VL53L5CX_DISABLE_NB_TARGET_DETECTED
+  if (config->l5cx_outputs & VL53L5CX_OUTPUT_NB_TARGET_DETECTED)
+    detected = results->nb_target_detected;
+#endif
+  TargetStack *data = config->targets_shm;
+  shm_seq_write_begin(&data->write_seq);
+  target_stack_fill(data, results->distance_mm, sigma_mm,
+                    results->target_status, detected,
+                    config->l5cx_resolution, config->l5cx_targets);
+  frame.seq++;
+  frame.publish_ns = record_now_ns();
+  data->frame = frame;
+  shm_seq_write_end(&data->write_seq);
 }
 
 // Функция для закрытия shared memory
 void close_shared_memory(SensorConfig *config) {
   if (config->shm_ptr && config->shm_ptr != MAP_FAILED) {
-    size_t shm_size = 8 + 64 * 3; // Максимальный размер для матрицы 8x8
-    munmap(config->shm_ptr, shm_size);
+    munmap(config->shm_ptr, sizeof(SensorData));
     config->shm_ptr = NULL;
   }
 
@@ -326,6 +790,39 @@ void close_shared_memory(SensorConfig *config) {
   shm_unlink(config->shm_name);
   printf("Shared memory закрыт: %s\n", config->shm_name);
 
+  // Сегменты фильтра зон, облака точек, секторов и движения
+  if (config->filtered_shm) {
+    munmap(config->filtered_shm, sizeof(SensorData));
+    shm_unlink(config->filtered_name);
+    config->filtered_shm = NULL;
+  }
+  free(config->filter);
+  config->filter = NULL;
+  if (config->cloud_shm) {
+    munmap(config->cloud_shm, sizeof(CloudData));
+    shm_unlink(config->cloud_name);
+    config->cloud_shm = NULL;
+  }
+  free(config->cloud);
+  config->cloud = NULL;
+  if (config->sectors_shm) {
+    munmap(config->sectors_shm, sizeof(SectorData));
+    shm_unlink(config->sectors_name);
+    config->sectors_shm = NULL;
+  }
+  if (config->motion_shm) {
+    munmap(config->motion_shm, sizeof(MotionData));
+    shm_unlink(config->motion_name);
+    config->motion_shm = NULL;
+  }
+  if (config->targets_shm) {
+    munmap(config->targets_shm, sizeof(TargetStack));
+    shm_unlink(config->targets_name);
+    config->targets_shm = NULL;
+  }
+  free(config->gate);
+  config->gate = NULL;
+
   // Закрываем и удаляем семафор
   char sem_name[256];
   snprintf(sem_name, sizeof(sem_name), "/sem_%.250s", config->shm_name);
@@ -337,7 +834,7 @@ void close_shared_memory(SensorConfig *config) {
 }
 
 // Функция для инициализации VL53L1X
-int init_vl53l1x_sensor(uint8_t addr) {
+int init_vl53l1x_sensor(uint8_t addr, const SensorConfig *sensor_config) {
   uint16_t dev = addr;
   uint8_t sensorState = 0;
   int status = 0;
@@ -361,15 +858,58 @@ int init_vl53l1x_sensor(uint8_t addr) {
     return -1;
   }
 
-  // Настройка параметров
-  status = VL53L1X_SetDistanceMode(dev, 2); // Long mode
-  status = VL53L1X_SetTimingBudgetInMs(dev, 100);
-  status = VL53L1X_SetInterMeasurementInMs(dev, 100);
+  // Параметры из конфига; бюджет задаётся после режима, от которого
+  // зависят его регистры
+  i2c_stats_call(I2C_CALL_CONFIG);
+  uint16_t budget_ms = sensor_config->l1x_timing_budget_ms;
+  status = VL53L1X_SetDistanceMode(dev, sensor_config->l1x_distance_mode);
+  status |= VL53L1X_SetTimingBudgetInMs(dev, budget_ms);
+  status |= VL53L1X_SetInterMeasurementInMs(dev, budget_ms);
+  if (sensor_config->l1x_roi_width) {
+    status |= VL53L1X_SetROI(dev, sensor_config->l1x_roi_width,
+                             sensor_config->l1x_roi_height);
+    if (sensor_config->l1x_roi_center >= 0)
+      status |= VL53L1X_SetROICenter(dev, sensor_config->l1x_roi_center);
+  }
+  if (status != 0) {
+    fprintf(stderr, "VL53L1X ranging parameters rejected\n");
+    return -1;
+  }
 
   printf("VL53L1X initialized successfully at address 0x%02X\n", addr);
   return 0;
 }
 
+// Режим по порогам: одинаковый порог расстояния на каждую зону (срабатывает
+// любая), проверка порогов на датчике и измерения без участия хоста
+static int setup_l5cx_thresholds(VL53L5CX_Configuration *dev,
+                                 const SensorConfig *sensor_config) {
+  VL53L5CX_DetectionThresholds thresholds[VL53L5CX_NB_THRESHOLDS];
+  uint8_t zones = sensor_config->l5cx_resolution;
+  uint8_t status;
+
+  memset(thresholds, 0, sizeof(thresholds));
+  for (int i = 0; i < zones; i++) {
+    thresholds[i].measurement = VL53L5CX_DISTANCE_MM;
+    if (sensor_config->threshold_low_mm) {
+      thresholds[i].type = VL53L5CX_IN_WINDOW;
+      thresholds[i].param_low_thresh = sensor_config->threshold_low_mm;
+    } else {
+      thresholds[i].type = VL53L5CX_LESS_THAN_EQUAL_MIN_CHECKER;
+      thresholds[i].param_low_thresh = sensor_config->threshold_high_mm;
+    }
+    thresholds[i].param_high_thresh = sensor_config->threshold_high_mm;
+    thresholds[i].zone_num = (uint8_t)i;
+    thresholds[i].mathematic_operation = VL53L5CX_OPERATION_OR;
+  }
+  thresholds[zones - 1].zone_num |= VL53L5CX_LAST_THRESHOLD;
+
+  status = vl53l5cx_set_detection_thresholds(dev, thresholds);
+  status |= vl53l5cx_set_detection_thresholds_enable(dev, 1);
+  status |= vl53l5cx_set_ranging_mode(dev, VL53L5CX_RANGING_MODE_AUTONOMOUS);
+  return status ? -1 : 0;
+}
+
 // Функция для инициализации VL53L5CX
 int init_vl53l5cx_sensor(uint8_t addr, SensorConfig *sensor_config) {
   uint8_t isAlive, status;
@@ -384,15 +924,30 @@ int init_vl53l5cx_sensor(uint8_t addr, SensorConfig *sensor_config) {
   // Инициализируем конфигурацию нулями
   memset(config, 0, sizeof(VL53L5CX_Configuration));
 
-  // Настройка платформы
+  // Настройка платформы: i2c-dev, модуль ядра stmvl53l5cx или симулятор
   config->platform.address = addr;
-  config->platform.fd = open("/dev/i2c-1", O_RDONLY);
+  int32_t comms_status;
+#ifdef SENSORS2SHM_SIM
+  comms_status =
+      vl53l5cx_comms_attach(&config->platform, sim_bus_transfer, NULL);
+#else
+  comms_status =
+      vl53l5cx_comms_open(&config->platform, sensor_config->l5cx_transport,
+                          sensor_config->dev_path);
+#endif
+  if (comms_status != 0) {
+    free(config);
+    return -1;
+  }
+  if (i2c_stats_enabled())
+    vl53l5cx_comms_profile(&config->platform, i2c_stats_record, NULL);
   printf("config->platform.address: %d\n", config->platform.address);
 
   // Проверка наличия датчика
   status = vl53l5cx_is_alive(config, &isAlive);
   if (!isAlive || status) {
     perror("VL53L5CX not detected at address 0x%02X");
+    vl53l5cx_comms_close(&config->platform);
     free(config);
     return -1;
   }
@@ -401,21 +956,84 @@ int init_vl53l5cx_sensor(uint8_t addr, SensorConfig *sensor_config) {
   status = vl53l5cx_init(config);
   if (status) {
     perror("VL53L5CX ULD Loading failed");
+    vl53l5cx_comms_close(&config->platform);
+    free(config);
+    return -1;
+  }
+
+  // Передаются только выбранные выходы, остальные блоки не читаются по I2C
+  i2c_stats_call(I2C_CALL_CONFIG);
+  status = vl53l5cx_set_output_mask(config, sensor_config->l5cx_outputs);
+  if (status) {
+    fprintf(stderr, "VL53L5CX output mask 0x%03X rejected\n",
+            sensor_config->l5cx_outputs);
+    vl53l5cx_comms_close(&config->platform);
+    free(config);
+    return -1;
+  }
+
+  // Буферы ULD рассчитаны на четыре цели, по I2C — только заданное число
+  status = vl53l5cx_set_nb_targets(config, sensor_config->l5cx_targets);
+  status |= vl53l5cx_set_target_order(config,
+                                      sensor_config->l5cx_target_order);
+  if (status) {
+    fprintf(stderr, "VL53L5CX targets setup failed\n");
+    vl53l5cx_comms_close(&config->platform);
     free(config);
     return -1;
   }
 
-  status = vl53l5cx_set_resolution(config, 64);
+  status = vl53l5cx_set_resolution(config, sensor_config->l5cx_resolution);
   if (status) {
     perror("VL53L5CX resolution set failed");
+    vl53l5cx_comms_close(&config->platform);
     free(config);
     return -1;
   }
 
-  status = vl53l5cx_set_ranging_frequency_hz(config, 10);
+  // Индикатор движения: конфигурация плагина под разрешение и окно
+  // расстояний, выход motion включён в маске при разборе конфига
+  if (sensor_config->motion_params.enabled) {
+    VL53L5CX_Motion_Configuration motion;
+    status = vl53l5cx_motion_indicator_init(config, &motion,
+                                            sensor_config->l5cx_resolution);
+    status |= vl53l5cx_motion_indicator_set_distance_motion(
+        config, &motion, sensor_config->motion_params.min_mm,
+        sensor_config->motion_params.max_mm);
+    if (status) {
+      fprintf(stderr, "VL53L5CX motion indicator setup failed\n");
+      vl53l5cx_comms_close(&config->platform);
+      free(config);
+      return -1;
+    }
+  }
+
+  // Частота, режим, время интеграции и резкость проверены при разборе
+  // конфига; не заданные остаются по умолчанию драйвера
+  status = vl53l5cx_set_ranging_frequency_hz(config,
+                                             sensor_config->l5cx_frequency_hz);
+  if (sensor_config->l5cx_ranging_mode)
+    status |=
+        vl53l5cx_set_ranging_mode(config, sensor_config->l5cx_ranging_mode);
+  if (sensor_config->l5cx_integration_ms)
+    status |= vl53l5cx_set_integration_time_ms(
+        config, sensor_config->l5cx_integration_ms);
+  if (sensor_config->l5cx_sharpener >= 0)
+    status |= vl53l5cx_set_sharpener_percent(
+        config, (uint8_t)sensor_config->l5cx_sharpener);
   if (status) {
-    perror("vl53l5cx_set_ranging_frequency_hz failed");
-    return status;
+    fprintf(stderr, "VL53L5CX ranging parameters rejected\n");
+    vl53l5cx_comms_close(&config->platform);
+    free(config);
+    return -1;
+  }
+
+  if (sensor_config->l5cx_threshold_mode &&
+      setup_l5cx_thresholds(config, sensor_config) != 0) {
+    fprintf(stderr, "VL53L5CX detection thresholds setup failed\n");
+    vl53l5cx_comms_close(&config->platform);
+    free(config);
+    return -1;
   }
 
   // Сохраняем указатель на конфигурацию
@@ -425,6 +1043,32 @@ int init_vl53l5cx_sensor(uint8_t addr, SensorConfig *sensor_config) {
   return 0;
 }
 
+#ifdef SENSORS2SHM_SIM
+// Симулятор: модель каждого датчика из конфигурации на виртуальной шине,
+// питание моделей управляется теми же пинами XSHUT
+static void init_sim_bus(SensorConfig *configs, int sensor_count) {
+  VL53L1_SetBusTransfer(sim_bus_transfer, NULL);
+
+  for (int i = 0; i < sensor_count; i++) {
+    switch (configs[i].type) {
+    case SENSOR_VL53L1X:
+      sim_add_sensor(SIM_SENSOR_L1X, configs[i].xshut_pin);
+      break;
+    case SENSOR_VL53L5CX:
+      sim_add_sensor(SIM_SENSOR_L5CX, configs[i].xshut_pin);
+      configs[i].l5cx_transport = VL53L5CX_TRANSPORT_CUSTOM;
+      // Линия INT модели — виртуальный пин рядом с XSHUT
+      if (configs[i].int_pin >= 0 || configs[i].l5cx_threshold_mode)
+        configs[i].int_pin = configs[i].xshut_pin + SIM_INT_PIN_OFFSET;
+      break;
+    case SENSOR_TCS34725:
+      break;
+    }
+  }
+  printf("Simulator: %d sensors on virtual I2C bus\n", sensor_count);
+}
+#endif
+
 int init_gpio(SensorConfig *configs, int sensor_count) {
   if (wiringPiSetupGpio() == -1) {
     perror("Error: wiringPi init");
@@ -440,7 +1084,7 @@ int init_gpio(SensorConfig *configs, int sensor_count) {
     }
 
     // Проверяем, что GPIO пин в допустимом диапазоне
-    if (configs[i].xshut_pin < 0 || configs[i].xshut_pin > 40) {
+    if (configs[i].xshut_pin < 0 || configs[i].xshut_pin > GPIO_PIN_MAX) {
       perror("Error: Invalid GPIO pin %d for sensor %d");
       return -1;
     }
@@ -456,6 +1100,10 @@ int init_gpio(SensorConfig *configs, int sensor_count) {
     }
   }
 
+#ifdef SENSORS2SHM_SIM
+  init_sim_bus(configs, sensor_count);
+#endif
+
   // Сначала все пины XSHUT устанавливаем в LOW (выключаем все датчики)
   for (int i = 0; i < sensor_count; i++) {
     pinMode(configs[i].xshut_pin, OUTPUT);
@@ -465,6 +1113,8 @@ int init_gpio(SensorConfig *configs, int sensor_count) {
     configs[i].shm_fd = -1;
     configs[i].shm_ptr = NULL;
     configs[i].sem = NULL; // Инициализируем семафор
+    configs[i].reader_started = 0;
+    configs[i].reader_running = 0;
   }
 
   // Ждем немного для стабилизации
@@ -474,11 +1124,27 @@ int init_gpio(SensorConfig *configs, int sensor_count) {
   for (int i = 0; i < sensor_count; i++) {
     printf("Checking sensor %d (pin %d, addr 0x%02X)...", i,
            configs[i].xshut_pin, configs[i].i2c_addr);
+    i2c_stats_context(i, I2C_CALL_INIT);
 
     // Включаем текущий датчик
     digitalWrite(configs[i].xshut_pin, HIGH);
     delay(100); // Ждем загрузки датчика
 
+    // VL53L5CX через модуль ядра: адрес задан в device tree и занят драйвером,
+    // поэтому проверка через i2c-dev и смена адреса не выполняются
+    if (configs[i].type == SENSOR_VL53L5CX &&
+        configs[i].l5cx_transport == VL53L5CX_TRANSPORT_KERNEL) {
+      printf("Using kernel driver %s\n", configs[i].dev_path);
+      if (init_vl53l5cx_sensor(configs[i].i2c_addr << 1, &configs[i]) == 0) {
+        if (create_shared_memory(&configs[i]) == 0) {
+          configs[i].initialized = 1;
+        } else {
+          perror("Failed to create shared memory for sensor %d");
+        }
+      }
+      continue;
+    }
+
     // Проверяем стандартный адрес 0x29 (0x52 в 7-bit формате)
     if (check_i2c_device(0x29) == 0) {
       printf("Found sensor at default address 0x29\n");
@@ -487,7 +1153,7 @@ int init_gpio(SensorConfig *configs, int sensor_count) {
       int init_status = -1;
       switch (configs[i].type) {
       case SENSOR_VL53L1X:
-        init_status = init_vl53l1x_sensor(0x29 << 1);
+        init_status = init_vl53l1x_sensor(0x29 << 1, &configs[i]);
         if (init_status == 0) {
           // Меняем адрес на нужный
           if (configs[i].i2c_addr != 0x29) {
@@ -549,7 +1215,8 @@ int init_gpio(SensorConfig *configs, int sensor_count) {
         int init_status = -1;
         switch (configs[i].type) {
         case SENSOR_VL53L1X:
-          init_status = init_vl53l1x_sensor(configs[i].i2c_addr << 1);
+          init_status =
+              init_vl53l1x_sensor(configs[i].i2c_addr << 1, &configs[i]);
           break;
         case SENSOR_VL53L5CX:
           init_status =
@@ -587,6 +1254,7 @@ int init_gpio(SensorConfig *configs, int sensor_count) {
   //   }
   // }
 
+  i2c_stats_context(-1, I2C_CALL_OTHER);
   return 0;
 }
 
@@ -596,18 +1264,21 @@ void stop_all_sensors(SensorConfig *configs, int sensor_count) {
 
   for (int i = 0; i < sensor_count; i++) {
     if (configs[i].initialized) {
+      i2c_stats_context(i, I2C_CALL_START_STOP);
       switch (configs[i].type) {
       case SENSOR_VL53L1X:
-        VL53L1X_StopRanging(configs[i].i2c_addr);
+        VL53L1X_StopRanging(configs[i].i2c_addr << 1);
         printf("VL53L1X остановлен (адрес 0x%02X)\n", configs[i].i2c_addr);
         break;
       case SENSOR_VL53L5CX: {
         VL53L5CX_Configuration *config =
             (VL53L5CX_Configuration *)configs[i].sensor_config;
         if (config) {
+          vl53l5cx_ring_close(&config->platform);
           vl53l5cx_stop_ranging(config);
           printf("VL53L5CX остановлен (адрес 0x%02X)\n", configs[i].i2c_addr);
           // Освобождаем память
+          vl53l5cx_comms_close(&config->platform);
           free(config);
           configs[i].sensor_config = NULL;
         }
@@ -633,41 +1304,168 @@ void stop_all_sensors(SensorConfig *configs, int sensor_count) {
   }
 }
 
+// Функция для записи результатов VL53L5CX в shared memory
+int write_vl53l5cx_results(SensorConfig *config,
+                           VL53L5CX_ResultsData *results) {
+  // Разрешение не меняется после инициализации, поэтому не читаем его
+  // с датчика на каждом кадре
+  uint8_t resolution = config->l5cx_resolution;
+  if (resolution == 0) {
+    fprintf(stderr, "resolution==0, пропуск записи в shared memory\n");
+    return -1;
+  }
+
+  // Подготавливаем массивы для матричных данных
+  uint16_t distances[64];
+  uint8_t statuses[64];
+
+  // Копируем первую цель всех зон; цели зоны идут подряд
+  uint8_t targets = config->l5cx_targets;
+  for (int i = 0; i < resolution; i++) {
+    distances[i] = results->distance_mm[i * targets];
+    statuses[i] = results->target_status[i * targets];
+  }
+
+  // Записываем матричные данные в shared memory, затем отфильтрованные и
+  // облако точек и сектора (из отфильтрованных расстояний, если фильтр
+  // включён), индикатор движения и стек целей.
+  // Фильтр и полярная карта получают каждый кадр, в сегменты датчика
+  // уходят только кадры, прошедшие проверку изменений
+  history_frame(config->index, distances, statuses, resolution);
+  FrameInfo frame = config->frame;
+  uint8_t moving = 0;
+  if (config->motion_params.enabled)
+    moving = motion_count(&config->motion_params,
+                          results->motion_indicator.motion,
+                          results->motion_indicator.nb_of_aggregates,
+                          results->motion_indicator.nb_of_detected_aggregates);
+  int publish = frame_should_publish(
+      config, distances, statuses, resolution,
+      moving >= config->motion_params.min_aggregates);
+  if (publish && write_matrix_to_shm(config, distances, statuses,
+                                     resolution) != 0)
+    return -1;
+
+  const uint16_t *output = distances;
+  uint16_t filtered[64];
+  if (config->filter) {
+    filter_zones(config, results, distances, statuses, resolution, filtered);
+    if (publish)
+      write_filtered_to_shm(config, frame, filtered, statuses, resolution);
+    output = filtered;
+  }
+  if (config->cloud) {
+    CloudData cloud;
+    cloud_build(config->cloud, output, statuses, resolution, &cloud);
+    if (publish && config->cloud_shm)
+      write_cloud_to_shm(config, frame, &cloud);
+
+    // Зона видна под углом ±FOV / (2 * сторона матрицы) от своего луча
+    polar_update_points(config->index, (const float(*)[3])cloud.points,
+                        cloud.count,
+                        CLOUD_FOV_DEG / (resolution == 16 ? 8.0f : 16.0f));
+  }
+  if (publish && config->sectors_shm)
+    write_sectors_to_shm(config, frame, output, statuses, resolution);
+  if (publish && config->motion_shm)
+    write_motion_to_shm(config, frame, results, moving);
+  if (publish && config->targets_shm)
+    write_targets_to_shm(config, frame, results);
+  adapt_rate(config, distances, statuses, resolution);
+  return 0;
+}
+
+// Запись сырого кадра датчика, если включена запись (--record)
+static void record_frame(SensorConfig *config, const uint8_t *raw,
+                         uint32_t len, uint64_t timestamp_ns) {
+  if (recorder.file)
+    recorder_write(&recorder, RECORD_FRAME, config->index, timestamp_ns, raw,
+                   len);
+}
+
+// Отметка обнаружения готового кадра; модель симулятора знает и время
+// готовности кадра на датчике
+static void frame_detected(SensorConfig *config) {
+  config->frame.detect_ns = record_now_ns();
+#ifdef SENSORS2SHM_SIM
+  config->frame.ready_ns = sim_bus_ready_ns(config->i2c_addr);
+#endif
+}
+
+// Учёт пропущенных кадров VL53L5CX по счётчику кадров датчика (0..254)
+static void count_l5cx_drops(SensorConfig *config, uint8_t streamcount) {
+  if (config->l5cx_streamcount != 255 && streamcount != 255) {
+    uint8_t gap = (streamcount + 255 - config->l5cx_streamcount) % 255;
+    if (gap > 1) {
+      config->frame.dropped += gap - 1;
+      metrics_frames_dropped(config->index, gap - 1);
+    }
+  }
+  config->l5cx_streamcount = streamcount;
+}
+
+// Разбор кадра VL53L5CX из temp_buffer с учётом повреждённых кадров
+static int decode_l5cx_frame(SensorConfig *config,
+                             VL53L5CX_ResultsData *results) {
+  uint8_t status = vl53l5cx_decode_ranging_data(
+      (VL53L5CX_Configuration *)config->sensor_config, results);
+  trace_event(config->index, TRACE_PARSE_DONE, status);
+  if (status & VL53L5CX_STATUS_CORRUPTED_FRAME)
+    metrics_corrupted_frame(config->index);
+  return status == VL53L5CX_STATUS_OK ? 0 : -1;
+}
+
 int read_sensor_data(SensorConfig *config, uint8_t *data) {
+  metrics_poll(config->index);
+  trace_event(config->index, TRACE_POLL_START, 0);
   switch (config->type) {
   case SENSOR_VL53L1X: {
     uint8_t dev = config->i2c_addr << 1;
     uint8_t dataReady = 0;
-    uint16_t distance = 0;
-    uint8_t rangeStatus = 0;
+    uint8_t raw[VL53L1X_RESULT_SIZE];
+    VL53L1X_Result_t result;
 
     // Проверяем готовность данных
+    i2c_stats_context(config->index, I2C_CALL_CHECK_READY);
     if (VL53L1X_CheckForDataReady(dev, &dataReady) != 0) {
+      metrics_i2c_error(config->index);
       perror("VL53L1X_CheckForDataReady error");
       return -1;
     }
+    trace_event(config->index, TRACE_POLL_DONE, dataReady);
 
     if (dataReady) {
-      // Получаем статус и расстояние
-      if (VL53L1X_GetRangeStatus(dev, &rangeStatus) != 0) {
-        perror("VL53L1X_GetRangeStatus error");
-        return -1;
-      }
-
-      if (VL53L1X_GetDistance(dev, &distance) != 0) {
-        perror("VL53L1X_GetDistance error");
+      frame_detected(config);
+
+      // Статус и расстояние одним чтением блока результатов
+      i2c_stats_call(I2C_CALL_READ_FRAME);
+      trace_event(config->index, TRACE_READ_START, 0);
+      if (VL53L1_ReadMulti(dev, VL53L1_RESULT__RANGE_STATUS, raw,
+                           sizeof(raw)) != 0) {
+        metrics_i2c_error(config->index);
+        perror("VL53L1X result read error");
         return -1;
       }
+      config->frame.read_ns = record_now_ns();
+      metrics_frame_read(config->index,
+                         config->frame.read_ns - config->frame.detect_ns);
+      trace_event_at(config->index, TRACE_READ_END, sizeof(raw),
+                     config->frame.read_ns);
 
       // Очищаем прерывание
+      i2c_stats_call(I2C_CALL_CLEAR_INT);
       VL53L1X_ClearInterrupt(dev);
 
+      record_frame(config, raw, sizeof(raw), config->frame.read_ns);
+      VL53L1X_DecodeResult(raw, &result);
+      trace_event(config->index, TRACE_PARSE_DONE, 0);
+
       // Записываем данные в буфер (4 байта: 2 байта расстояния + 2 байта
       // статуса)
-      data[0] = (distance >> 8) & 0xFF;
-      data[1] = distance & 0xFF;
-      data[2] = 0;                  // Старший байт статуса всегда 0 для VL53L1X
-      data[3] = rangeStatus & 0xFF; // Младший байт статуса
+      data[0] = (result.Distance >> 8) & 0xFF;
+      data[1] = result.Distance & 0xFF;
+      data[2] = 0; // Старший байт статуса всегда 0 для VL53L1X
+      data[3] = result.Status & 0xFF; // Младший байт статуса
 
       return 0;
     }
@@ -686,46 +1484,44 @@ int read_sensor_data(SensorConfig *config, uint8_t *data) {
     }
 
     // Проверяем готовность данных
+    i2c_stats_context(config->index, I2C_CALL_CHECK_READY);
     if (vl53l5cx_check_data_ready(vl53l5cx_config, &isReady) != 0) {
+      metrics_i2c_error(config->index);
       return -1;
     }
+    trace_event(config->index, TRACE_POLL_DONE, isReady);
 
     if (isReady) {
-      // Получаем данные
-      if (vl53l5cx_get_ranging_data(vl53l5cx_config, &results) != 0) {
-        return -1;
-      }
-
-      // Получаем текущее разрешение
-      uint8_t resolution;
-      if (vl53l5cx_get_resolution(vl53l5cx_config, &resolution) != 0) {
-        fprintf(stderr, "vl53l5cx_get_resolution error, пропуск записи\n");
+      frame_detected(config);
+      count_l5cx_drops(config, vl53l5cx_config->streamcount);
+
+      // Получаем данные: сырой кадр (для записи), затем разбор
+      i2c_stats_call(I2C_CALL_READ_FRAME);
+      trace_event(config->index, TRACE_READ_START, 0);
+      if (VL53L5CX_RdMulti(&vl53l5cx_config->platform, 0x0,
+                           vl53l5cx_config->temp_buffer,
+                           vl53l5cx_config->data_read_size) != 0) {
+        metrics_i2c_error(config->index);
         return -1;
       }
-      if (resolution == 0) {
-        fprintf(stderr, "resolution==0, пропуск записи в shared memory\n");
+      config->frame.read_ns = record_now_ns();
+      metrics_frame_read(config->index,
+                         config->frame.read_ns - config->frame.detect_ns);
+      trace_event_at(config->index, TRACE_READ_END,
+                     vl53l5cx_config->data_read_size, config->frame.read_ns);
+      record_frame(config, vl53l5cx_config->temp_buffer,
+                   vl53l5cx_config->data_read_size, config->frame.read_ns);
+      if (decode_l5cx_frame(config, &results) != 0) {
         return -1;
       }
-      printf("VL53L5CX: resolution = %d\n", resolution);
-
-      // Подготавливаем массивы для матричных данных
-      uint16_t distances[64];
-      uint8_t statuses[64];
-
-      // Копируем данные из всех зон
-      for (int i = 0; i < resolution; i++) {
-        distances[i] = results.distance_mm[i];
-        statuses[i] = results.target_status[i];
-      }
 
-      // Записываем матричные данные в shared memory
-      if (write_matrix_to_shm(config, distances, statuses, resolution) == 0) {
+      if (write_vl53l5cx_results(config, &results) == 0) {
         // Для обратной совместимости также записываем в буфер данные первой
         // зоны
-        data[0] = (distances[0] >> 8) & 0xFF;
-        data[1] = distances[0] & 0xFF;
+        data[0] = (results.distance_mm[0] >> 8) & 0xFF;
+        data[1] = results.distance_mm[0] & 0xFF;
         data[2] = 0;
-        data[3] = statuses[0] & 0xFF;
+        data[3] = results.target_status[0] & 0xFF;
         return 0;
       }
     }
@@ -739,6 +1535,458 @@ int read_sensor_data(SensorConfig *config, uint8_t *data) {
   return -1;
 }
 
+// Поток чтения VL53L5CX через модуль ядра: вместо опроса блокируется в ядре
+// до прерывания INT, затем читает кадр и пишет его в shared memory
+void *kernel_reader_thread(void *arg) {
+  SensorConfig *config = (SensorConfig *)arg;
+  VL53L5CX_Configuration *dev = (VL53L5CX_Configuration *)config->sensor_config;
+  uint8_t sensor_data[4];
+  VL53L5CX_ResultsData results;
+  VL53L5CX_RingSlot *slot;
+
+  // Контекст профиля I2C — свой у каждого потока
+  i2c_stats_context(config->index, I2C_CALL_CHECK_READY);
+
+  while (running) {
+    // Кадры уже прочитаны модулем ядра в кольцо: только декодируем их
+    if (dev->platform.ring) {
+      if (!vl53l5cx_ring_wait(&dev->platform)) {
+        if (errno != EINTR)
+          delay(10);
+        continue;
+      }
+      metrics_poll(config->index);
+      while ((slot = vl53l5cx_ring_peek(&dev->platform)) != NULL) {
+        uint64_t timestamp_ns = slot->timestamp_ns;
+        uint32_t len = slot->len;
+        trace_event_at(config->index, TRACE_IRQ, len, timestamp_ns);
+        // Длина из общего с модулем ядра кольца: разбор читает
+        // data_read_size байт, кадр другой длины отбрасывается
+        if (len != dev->data_read_size) {
+          vl53l5cx_ring_release(&dev->platform);
+          metrics_corrupted_frame(config->index);
+          continue;
+        }
+        trace_event(config->index, TRACE_READ_START, 0);
+        memcpy(dev->temp_buffer, slot + 1, len);
+        vl53l5cx_ring_release(&dev->platform);
+        trace_event(config->index, TRACE_READ_END, len);
+
+        // Кадр прочитан модулем ядра: готовность — фронт INT
+        config->frame.ready_ns = timestamp_ns;
+        config->frame.detect_ns = record_now_ns();
+        config->frame.read_ns = config->frame.detect_ns;
+        count_l5cx_drops(config, dev->temp_buffer[0]);
+        metrics_frame_read(config->index, 0);
+        record_frame(config, dev->temp_buffer, len, timestamp_ns);
+        if (decode_l5cx_frame(config, &results) == 0)
+          write_vl53l5cx_results(config, &results);
+      }
+      continue;
+    }
+
+    if (!VL53L5CX_wait_for_dataready(&dev->platform)) {
+      // EINTR — остановка через SIGUSR2, иначе пауза, чтобы не крутиться
+      // в цикле при ошибке драйвера
+      if (errno != EINTR)
+        delay(10);
+      continue;
+    }
+    read_sensor_data(config, sensor_data);
+  }
+
+  config->reader_running = 0;
+  return NULL;
+}
+
+// Поток чтения датчика с линией INT на GPIO: спит до спада INT, затем
+// читает кадр тем же путём, что и основной цикл
+void *int_reader_thread(void *arg) {
+  SensorConfig *config = (SensorConfig *)arg;
+  uint8_t sensor_data[4];
+
+  // Контекст профиля I2C — свой у каждого потока
+  i2c_stats_context(config->index, I2C_CALL_CHECK_READY);
+
+  while (running) {
+    int ready = int_line_wait(&config->int_line, 1000);
+    if (ready < 0 && errno != EINTR)
+      delay(10);
+    if (ready <= 0)
+      continue;
+    metrics_poll(config->index);
+    read_sensor_data(config, sensor_data);
+  }
+
+  config->reader_running = 0;
+  return NULL;
+}
+
+// Поток датчика с линией INT (int_pin=); модуль ядра ждёт INT сам
+static void start_int_reader(SensorConfig *config) {
+  if (int_line_open(&config->int_line, config->int_pin) != 0) {
+    fprintf(stderr, "Sensor %d: INT line on GPIO %d unavailable, polling\n",
+            config->index, config->int_pin);
+    return;
+  }
+
+  config->reader_running = 1;
+  if (pthread_create(&config->reader, NULL, int_reader_thread, config) != 0) {
+    perror("Failed to start INT reader thread");
+    config->reader_running = 0;
+    int_line_close(&config->int_line);
+    return;
+  }
+  config->reader_started = 1;
+}
+
+// Функция для запуска потоков чтения датчиков на модуле ядра и с линией
+// INT
+void start_kernel_readers(SensorConfig *configs, int sensor_count) {
+  for (int i = 0; i < sensor_count; i++) {
+    if (!configs[i].initialized || configs[i].type != SENSOR_VL53L5CX)
+      continue;
+    if (configs[i].l5cx_transport != VL53L5CX_TRANSPORT_KERNEL) {
+      if (configs[i].int_pin >= 0)
+        start_int_reader(&configs[i]);
+      continue;
+    }
+
+    // Кольцо кадров модуля ядра; при старом модуле — чтение через ioctl
+    VL53L5CX_Configuration *dev =
+        (VL53L5CX_Configuration *)configs[i].sensor_config;
+    if (vl53l5cx_ring_open(&dev->platform, dev->data_read_size) != 0)
+      fprintf(stderr, "Sensor %d: frame ring unavailable, using ioctl reads\n",
+              i);
+
+    configs[i].reader_running = 1;
+    if (pthread_create(&configs[i].reader, NULL, kernel_reader_thread,
+                       &configs[i]) != 0) {
+      perror("Failed to start kernel reader thread");
+      configs[i].reader_running = 0;
+      continue;
+    }
+    configs[i].reader_started = 1;
+  }
+}
+
+// Функция для остановки потоков чтения: SIGUSR2 прерывает ожидание в ядре,
+// сигнал повторяется, пока поток не выйдет из цикла
+void stop_kernel_readers(SensorConfig *configs, int sensor_count) {
+  for (int i = 0; i < sensor_count; i++) {
+    if (!configs[i].reader_started)
+      continue;
+
+    while (configs[i].reader_running) {
+      pthread_kill(configs[i].reader, SIGUSR2);
+      delay(10);
+    }
+    pthread_join(configs[i].reader, NULL);
+    configs[i].reader_started = 0;
+    if (configs[i].int_pin >= 0)
+      int_line_close(&configs[i].int_line);
+  }
+}
+
+// Функция для начала записи: файл и описания инициализированных датчиков
+int start_recording(const char *path, SensorConfig *configs,
+                    int sensor_count) {
+  if (recorder_open(&recorder, path) != 0)
+    return -1;
+
+  for (int i = 0; i < sensor_count; i++) {
+    if (!configs[i].initialized)
+      continue;
+
+    uint8_t buf[sizeof(RecordSensor) + sizeof(configs[i].shm_name)];
+    RecordSensor desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.type = configs[i].type;
+    if (configs[i].type == SENSOR_VL53L5CX) {
+      VL53L5CX_Configuration *dev =
+          (VL53L5CX_Configuration *)configs[i].sensor_config;
+      desc.resolution = configs[i].l5cx_resolution;
+      desc.targets = configs[i].l5cx_targets;
+      desc.outputs = configs[i].l5cx_outputs;
+      desc.frame_size = dev->data_read_size;
+    } else {
+      desc.resolution = 1;
+      desc.frame_size = VL53L1X_RESULT_SIZE;
+    }
+
+    // Имя shared memory без завершающего нуля
+    size_t name_len = strlen(configs[i].shm_name);
+    memcpy(buf, &desc, sizeof(desc));
+    memcpy(buf + sizeof(desc), configs[i].shm_name, name_len);
+    recorder_write(&recorder, RECORD_SENSOR, configs[i].index,
+                   record_now_ns(), buf, sizeof(desc) + name_len);
+  }
+
+  printf("Recording raw frames to %s\n", path);
+  return 0;
+}
+
+// Функция для завершения записи
+void stop_recording(int daemon_mode) {
+  if (!recorder.file)
+    return;
+
+  if (!daemon_mode) {
+    printf("Recorded %llu frames (%llu bytes)\n",
+           (unsigned long long)recorder.frames,
+           (unsigned long long)recorder.bytes);
+  }
+  recorder_close(&recorder);
+}
+
+// Функция для включения профиля I2C (--profile-i2c): хуки платформенных
+// слоёв подключаются до инициализации датчиков
+int start_i2c_stats(SensorConfig *configs, int sensor_count) {
+  if (i2c_stats_enable(sensor_count) != 0) {
+    perror("Failed to allocate I2C profile");
+    return -1;
+  }
+  for (int i = 0; i < sensor_count; i++)
+    i2c_stats_set_name(i, configs[i].shm_name);
+  VL53L1_SetCommsProfile(i2c_stats_record, NULL);
+  return 0;
+}
+
+// Функция для вывода профиля I2C: в режиме демона — в файл I2C_STATS_FILE
+void write_i2c_stats(int daemon_mode) {
+  if (!i2c_stats_enabled()) {
+    if (!daemon_mode)
+      printf("I2C profile disabled, run with --profile-i2c\n");
+    return;
+  }
+  if (!daemon_mode) {
+    i2c_stats_dump(stdout);
+    return;
+  }
+
+  FILE *out = fopen(I2C_STATS_FILE, "w");
+  if (!out)
+    return;
+  i2c_stats_dump(out);
+  fclose(out);
+}
+
+// Функция для создания сегмента счётчиков (METRICS_SHM_NAME); без него
+// демон работает как раньше
+void start_metrics(SensorConfig *configs, int sensor_count, int daemon_mode) {
+  if (metrics_open(sensor_count) != 0) {
+    if (!daemon_mode)
+      perror("Failed to create metrics shared memory");
+    return;
+  }
+  for (int i = 0; i < sensor_count; i++)
+    metrics_set_sensor(i, configs[i].shm_name, configs[i].type);
+}
+
+// Функция для включения трассы (--trace): кольцо открывается до
+// демонизации, чтобы сообщить об ошибке
+int start_trace(uint32_t records, SensorConfig *configs, int sensor_count) {
+  if (trace_open(records, sensor_count) != 0) {
+    perror("Failed to create trace ring");
+    return -1;
+  }
+  for (int i = 0; i < sensor_count; i++)
+    trace_set_sensor(i, configs[i].shm_name);
+  printf("Tracing to /dev/shm%s (%u records)\n", TRACE_SHM_NAME,
+         trace_ring->capacity);
+  return 0;
+}
+
+// Функция для включения истории кадров (--history): сегмент создаётся до
+// демонизации, чтобы сообщить об ошибке
+int start_history(uint32_t megabytes, SensorConfig *configs,
+                  int sensor_count) {
+  if (history_open(megabytes, sensor_count) != 0) {
+    perror("Failed to create history store");
+    return -1;
+  }
+  for (int i = 0; i < sensor_count; i++)
+    history_set_sensor(i, configs[i].shm_name);
+  printf("History in /dev/shm%s (%u blocks of %u bytes)\n", HISTORY_SHM_NAME,
+         history_store->block_count, history_store->block_size);
+  return 0;
+}
+
+// Функция для включения полярной карты (--polar): до инициализации
+// датчиков, чтобы VL53L5CX получили лучи зон
+int start_polar(SensorConfig *configs, int sensor_count) {
+  if (polar_open(sensor_count) != 0) {
+    perror("Failed to create polar map");
+    return -1;
+  }
+  for (int i = 0; i < sensor_count; i++)
+    polar_set_sensor(i, &configs[i].cloud_pose, POLAR_L1X_FOV_DEG / 2.0f);
+  printf("Polar map in /dev/shm%s (%d sectors)\n", POLAR_SHM_NAME,
+         POLAR_BINS);
+  return 0;
+}
+
+// Датчик из описания в записи: shared memory и состояние разбора кадров
+static int replay_add_sensor(SensorConfig *config, uint8_t index,
+                             const uint8_t *buf, uint16_t len) {
+  RecordSensor desc;
+  size_t name_len = len - sizeof(desc);
+
+  memcpy(&desc, buf, sizeof(desc));
+  if (name_len >= sizeof(config->shm_name))
+    name_len = sizeof(config->shm_name) - 1;
+  memcpy(config->shm_name, buf + sizeof(desc), name_len);
+  config->shm_name[name_len] = '\0';
+  config->type = desc.type;
+  config->index = index;
+  config->l5cx_streamcount = 255;
+
+  if (desc.type == SENSOR_VL53L5CX) {
+    if (desc.frame_size > VL53L5CX_TEMPORARY_BUFFER_SIZE)
+      return -1;
+
+    // Разбор без датчика: таблица блоков строится по первому кадру
+    VL53L5CX_Configuration *dev = calloc(1, sizeof(VL53L5CX_Configuration));
+    if (!dev)
+      return -1;
+    // Записи без числа целей сделаны с одной целью на зону
+    config->l5cx_targets = desc.targets ? desc.targets : 1;
+    if (vl53l5cx_set_nb_targets(dev, config->l5cx_targets) != 0) {
+      free(dev);
+      return -1;
+    }
+    // Без start_ranging: выходы кадров записи — маска из описания датчика
+    vl53l5cx_set_output_mask(dev, desc.outputs);
+    dev->streamed_mask = desc.outputs;
+    dev->data_read_size = desc.frame_size;
+    config->sensor_config = dev;
+    config->l5cx_outputs = desc.outputs;
+    config->l5cx_resolution = desc.resolution;
+  } else if (desc.type != SENSOR_VL53L1X) {
+    return -1;
+  }
+
+  if (create_shared_memory(config) != 0) {
+    free(config->sensor_config);
+    config->sensor_config = NULL;
+    return -1;
+  }
+  config->initialized = 1;
+  return 0;
+}
+
+// Разбор и публикация записанного кадра тем же путём, что и с датчика
+static int replay_frame(SensorConfig *config, const uint8_t *raw,
+                        uint16_t len) {
+  if (config->type == SENSOR_VL53L5CX) {
+    VL53L5CX_Configuration *dev =
+        (VL53L5CX_Configuration *)config->sensor_config;
+    VL53L5CX_ResultsData results;
+
+    if (len != dev->data_read_size)
+      return -1;
+    memcpy(dev->temp_buffer, raw, len);
+    count_l5cx_drops(config, raw[0]);
+    if (vl53l5cx_decode_ranging_data(dev, &results) != 0)
+      return -1;
+    return write_vl53l5cx_results(config, &results);
+  }
+
+  VL53L1X_Result_t result;
+  if (len != VL53L1X_RESULT_SIZE)
+    return -1;
+  VL53L1X_DecodeResult(raw, &result);
+  return write_single_to_shm(config, result.Distance, result.Status);
+}
+
+// Воспроизведение записи (--replay): кадры публикуются в shared memory с
+// исходными интервалами или, с --fast, без пауз (замер пропускной
+// способности разбора и публикации). --repeat проходит запись N раз
+int replay_record(const char *path, int fast, int repeat) {
+  static SensorConfig configs[MAX_SENSORS];
+  static uint8_t buf[RECORD_MAX_LEN];
+  RecordHeader hdr;
+  uint64_t first_ts = 0, start_ns = 0, pass_ns = 0, frames = 0, errors = 0;
+  int status, pass = 1;
+
+  FILE *file = record_open_read(path);
+  if (!file)
+    return -1;
+
+  memset(configs, 0, sizeof(configs));
+  for (int i = 0; i < MAX_SENSORS; i++)
+    configs[i].shm_fd = -1;
+
+  for (;;) {
+    status = running ? record_read(file, &hdr, buf) : 0;
+
+    // Следующий проход по записи (--repeat): датчики уже созданы
+    if (status == 0 && running && pass < repeat) {
+      fseek(file, sizeof(RecordFileHeader), SEEK_SET);
+      first_ts = 0;
+      pass++;
+      continue;
+    }
+    if (status != 1)
+      break;
+    if (hdr.sensor >= MAX_SENSORS)
+      continue;
+    SensorConfig *config = &configs[hdr.sensor];
+
+    if (hdr.kind == RECORD_SENSOR) {
+      if (!config->initialized && hdr.len >= sizeof(RecordSensor) &&
+          replay_add_sensor(config, hdr.sensor, buf, hdr.len) != 0)
+        fprintf(stderr, "Replay: sensor %d skipped\n", hdr.sensor);
+      continue;
+    }
+    if (hdr.kind != RECORD_FRAME || !config->initialized)
+      continue;
+
+    // Кадр публикуется через то же время от первого кадра, что и при записи
+    if (first_ts == 0) {
+      first_ts = hdr.timestamp_ns;
+      pass_ns = record_now_ns();
+      if (start_ns == 0)
+        start_ns = pass_ns;
+    }
+    uint64_t due = pass_ns + (hdr.timestamp_ns - first_ts);
+    if (!fast) {
+      struct timespec ts = {due / 1000000000ull, due % 1000000000ull};
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+
+    // Готовность — время кадра в записи, чтение — момент воспроизведения
+    config->frame.ready_ns = fast ? 0 : due;
+    config->frame.detect_ns = record_now_ns();
+    config->frame.read_ns = config->frame.detect_ns;
+
+    if (replay_frame(config, buf, hdr.len) == 0)
+      frames++;
+    else
+      errors++;
+  }
+  if (status < 0)
+    fprintf(stderr, "Replay: truncated record, stopped\n");
+
+  uint64_t elapsed_ns = start_ns ? record_now_ns() - start_ns : 0;
+  printf("Replayed %llu frames (%llu errors) in %.6f s",
+         (unsigned long long)frames, (unsigned long long)errors,
+         elapsed_ns / 1e9);
+  if (frames && elapsed_ns)
+    printf(": %.0f frames/s, %.2f us/frame", frames * 1e9 / elapsed_ns,
+           elapsed_ns / 1e3 / frames);
+  printf("\n");
+
+  fclose(file);
+  for (int i = 0; i < MAX_SENSORS; i++) {
+    if (!configs[i].initialized)
+      continue;
+    close_shared_memory(&configs[i]);
+    free(configs[i].sensor_config);
+  }
+  return 0;
+}
+
 // delete this
 // Функция для записи данных в файл
 int write_to_file(const char *filename, uint8_t *data, int size) {
@@ -759,6 +2007,570 @@ int write_to_file(const char *filename, uint8_t *data, int size) {
   return 0;
 }
 
+// Названия выходов VL53L5CX для опции outputs=
+static const struct {
+  const char *name;
+  uint32_t mask;
+} l5cx_output_names[] = {
+    {"ambient", VL53L5CX_OUTPUT_AMBIENT_PER_SPAD},
+    {"spads", VL53L5CX_OUTPUT_NB_SPADS_ENABLED},
+    {"nb_target", VL53L5CX_OUTPUT_NB_TARGET_DETECTED},
+    {"signal", VL53L5CX_OUTPUT_SIGNAL_PER_SPAD},
+    {"sigma", VL53L5CX_OUTPUT_RANGE_SIGMA_MM},
+    {"distance", VL53L5CX_OUTPUT_DISTANCE_MM},
+    {"reflectance", VL53L5CX_OUTPUT_REFLECTANCE_PERCENT},
+    {"status", VL53L5CX_OUTPUT_TARGET_STATUS},
+    {"motion", VL53L5CX_OUTPUT_MOTION_INDICATOR},
+    {"all", VL53L5CX_OUTPUT_ALL},
+};
+
+// Разбор списка выходов через запятую: outputs=distance,status
+static int parse_l5cx_outputs(const char *value, uint32_t *mask) {
+  char list[128];
+  char *saveptr = NULL;
+  uint32_t result = 0;
+
+  snprintf(list, sizeof(list), "%s", value);
+  for (char *name = strtok_r(list, ",", &saveptr); name != NULL;
+       name = strtok_r(NULL, ",", &saveptr)) {
+    size_t j;
+    for (j = 0; j < sizeof(l5cx_output_names) / sizeof(l5cx_output_names[0]);
+         j++) {
+      if (strcmp(name, l5cx_output_names[j].name) == 0) {
+        result |= l5cx_output_names[j].mask;
+        break;
+      }
+    }
+    if (j == sizeof(l5cx_output_names) / sizeof(l5cx_output_names[0])) {
+      fprintf(stderr, "Unknown VL53L5CX output '%s'\n", name);
+      return -1;
+    }
+  }
+
+  if (result == 0) {
+    fprintf(stderr, "Empty VL53L5CX output list\n");
+    return -1;
+  }
+  *mask = result;
+  return 0;
+}
+
+// Бюджеты времени VL53L1X, поддерживаемые драйвером
+static int l1x_budget_valid(long ms) {
+  return ms == 15 || ms == 20 || ms == 33 || ms == 50 || ms == 100 ||
+         ms == 200 || ms == 500;
+}
+
+// Разбор необязательных опций вида ключ=значение после имени файла
+static int parse_sensor_options(SensorConfig *config, char *options) {
+  char *saveptr = NULL;
+
+  for (char *opt = strtok_r(options, " \t", &saveptr); opt != NULL;
+       opt = strtok_r(NULL, " \t", &saveptr)) {
+    char *value = strchr(opt, '=');
+    if (!value) {
+      fprintf(stderr, "Invalid option '%s', expected key=value\n", opt);
+      return -1;
+    }
+    *value++ = '\0';
+
+    if (strcmp(opt, "transport") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'transport' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "i2c") == 0) {
+        config->l5cx_transport = VL53L5CX_TRANSPORT_I2C_DEV;
+      } else if (strcmp(value, "kernel") == 0) {
+        config->l5cx_transport = VL53L5CX_TRANSPORT_KERNEL;
+      } else {
+        fprintf(stderr, "Unknown transport '%s', expected i2c or kernel\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "dev") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'dev' applies only to l5cx, ignored\n");
+        continue;
+      }
+      snprintf(config->dev_path, sizeof(config->dev_path), "%s", value);
+    } else if (strcmp(opt, "outputs") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'outputs' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (parse_l5cx_outputs(value, &config->l5cx_outputs) != 0)
+        return -1;
+    } else if (strcmp(opt, "filter") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'filter' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (zone_filter_parse_kind(value, &config->filter_params.kind) != 0) {
+        fprintf(stderr,
+                "Unknown filter '%s', expected median3, median5, ema or "
+                "kalman\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "filter_alpha") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr,
+                "Option 'filter_alpha' applies only to l5cx, ignored\n");
+        continue;
+      }
+      float alpha = strtof(value, NULL);
+      if (!(alpha > 0.0f && alpha <= 1.0f)) {
+        fprintf(stderr, "Invalid filter_alpha '%s', expected (0, 1]\n", value);
+        return -1;
+      }
+      config->filter_params.alpha = alpha;
+    } else if (strcmp(opt, "filter_noise") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr,
+                "Option 'filter_noise' applies only to l5cx, ignored\n");
+        continue;
+      }
+      float noise = strtof(value, NULL);
+      if (!(noise > 0.0f)) {
+        fprintf(stderr, "Invalid filter_noise '%s', expected mm > 0\n", value);
+        return -1;
+      }
+      config->filter_params.process_noise_mm = noise;
+    } else if (strcmp(opt, "publish") == 0) {
+      if (strcmp(value, "all") == 0) {
+        config->gate_params.mode = CHANGE_GATE_OFF;
+      } else if (strcmp(value, "changes") == 0) {
+        config->gate_params.mode = CHANGE_GATE_CHANGES;
+      } else if (strcmp(value, "motion") == 0) {
+        if (config->type != SENSOR_VL53L5CX) {
+          fprintf(stderr, "publish=motion applies only to l5cx, ignored\n");
+          continue;
+        }
+        config->gate_params.mode = CHANGE_GATE_MOTION;
+      } else {
+        fprintf(stderr,
+                "Unknown publish '%s', expected all, changes or motion\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "change_mm") == 0) {
+      long mm = strtol(value, NULL, 0);
+      if (mm < 0 || mm > 4000) {
+        fprintf(stderr, "Invalid change_mm '%s', expected 0..4000\n", value);
+        return -1;
+      }
+      config->gate_params.threshold_mm = (uint16_t)mm;
+    } else if (strcmp(opt, "change_zones") == 0) {
+      long zones = strtol(value, NULL, 0);
+      if (zones < 1 || zones > 64) {
+        fprintf(stderr, "Invalid change_zones '%s', expected 1..64\n", value);
+        return -1;
+      }
+      config->gate_params.min_zones = (uint8_t)zones;
+    } else if (strcmp(opt, "heartbeat_ms") == 0) {
+      long ms = strtol(value, NULL, 0);
+      if (ms < 1) {
+        fprintf(stderr, "Invalid heartbeat_ms '%s', expected ms > 0\n", value);
+        return -1;
+      }
+      config->gate_params.heartbeat_ms = (uint32_t)ms;
+    } else if (strcmp(opt, "cloud") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'cloud' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "on") == 0) {
+        config->cloud_enabled = 1;
+      } else if (strcmp(value, "off") == 0) {
+        config->cloud_enabled = 0;
+      } else {
+        fprintf(stderr, "Unknown cloud '%s', expected on or off\n", value);
+        return -1;
+      }
+    } else if (strcmp(opt, "pose") == 0) {
+      if (cloud_parse_pose(value, &config->cloud_pose) != 0) {
+        fprintf(stderr,
+                "Invalid pose '%s', expected x,y,z,roll,pitch,yaw "
+                "(m and degrees)\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "sectors") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'sectors' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (sector_parse(value, &config->sector_map) != 0) {
+        fprintf(stderr,
+                "Invalid sectors '%s', expected cols:N, rows:N, grid:CxR "
+                "or 8x8 hex masks, up to %d sectors\n",
+                value, SECTOR_MAX);
+        return -1;
+      }
+    } else if (strcmp(opt, "mode") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'mode' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "continuous") == 0) {
+        config->l5cx_threshold_mode = 0;
+      } else if (strcmp(value, "threshold") == 0) {
+        config->l5cx_threshold_mode = 1;
+      } else {
+        fprintf(stderr, "Unknown mode '%s', expected continuous or threshold\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "threshold_mm") == 0) {
+      int low = 0, high = 0, consumed = 0;
+      if (sscanf(value, "%d-%d%n", &low, &high, &consumed) != 2 ||
+          value[consumed] != '\0') {
+        low = 0;
+        consumed = 0;
+        if (sscanf(value, "%d%n", &high, &consumed) != 1 ||
+            value[consumed] != '\0')
+          high = -1;
+      }
+      if (low < 0 || high < 1 || high > 4000 || (low && low >= high)) {
+        fprintf(stderr,
+                "Invalid threshold_mm '%s', expected max or min-max in mm "
+                "(up to 4000)\n",
+                value);
+        return -1;
+      }
+      config->threshold_low_mm = (uint16_t)low;
+      config->threshold_high_mm = (uint16_t)high;
+    } else if (strcmp(opt, "int_pin") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'int_pin' applies only to l5cx, ignored\n");
+        continue;
+      }
+      long pin = strtol(value, NULL, 0);
+      if (pin < 0 || pin > GPIO_PIN_MAX) {
+        fprintf(stderr, "Invalid int_pin '%s', expected 0..%d\n", value,
+                GPIO_PIN_MAX);
+        return -1;
+      }
+      config->int_pin = (int)pin;
+    } else if (strcmp(opt, "motion") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'motion' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "on") == 0) {
+        config->motion_params.enabled = 1;
+      } else if (strcmp(value, "off") == 0) {
+        config->motion_params.enabled = 0;
+      } else if (motion_parse_window(value, &config->motion_params.min_mm,
+                                     &config->motion_params.max_mm) == 0) {
+        config->motion_params.enabled = 1;
+      } else {
+        fprintf(stderr,
+                "Invalid motion '%s', expected on, off or min-max in mm "
+                "(%d..%d, at most %d apart)\n",
+                value, MOTION_MIN_MM, MOTION_MAX_MM, MOTION_MAX_WINDOW_MM);
+        return -1;
+      }
+    } else if (strcmp(opt, "motion_threshold") == 0) {
+      long threshold = strtol(value, NULL, 0);
+      if (threshold < 0) {
+        fprintf(stderr, "Invalid motion_threshold '%s', expected >= 0\n",
+                value);
+        return -1;
+      }
+      config->motion_params.threshold = (uint32_t)threshold;
+    } else if (strcmp(opt, "motion_aggregates") == 0) {
+      long aggregates = strtol(value, NULL, 0);
+      if (aggregates < 1 || aggregates > MOTION_AGGREGATES) {
+        fprintf(stderr, "Invalid motion_aggregates '%s', expected 1..%d\n",
+                value, MOTION_AGGREGATES);
+        return -1;
+      }
+      config->motion_params.min_aggregates = (uint8_t)aggregates;
+    } else if (strcmp(opt, "resolution") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr,
+                "Option 'resolution' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "8x8") == 0 || strcmp(value, "64") == 0) {
+        config->l5cx_resolution = VL53L5CX_RESOLUTION_8X8;
+      } else if (strcmp(value, "4x4") == 0 || strcmp(value, "16") == 0) {
+        config->l5cx_resolution = VL53L5CX_RESOLUTION_4X4;
+      } else {
+        fprintf(stderr, "Unknown resolution '%s', expected 8x8 or 4x4\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "frequency_hz") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr,
+                "Option 'frequency_hz' applies only to l5cx, ignored\n");
+        continue;
+      }
+      long hz = strtol(value, NULL, 0);
+      if (hz < 1 || hz > L5CX_MAX_FREQUENCY_HZ_4X4) {
+        fprintf(stderr, "Invalid frequency_hz '%s', expected 1..%d\n", value,
+                L5CX_MAX_FREQUENCY_HZ_4X4);
+        return -1;
+      }
+      config->l5cx_frequency_hz = (uint8_t)hz;
+    } else if (strcmp(opt, "integration_ms") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr,
+                "Option 'integration_ms' applies only to l5cx, ignored\n");
+        continue;
+      }
+      long ms = strtol(value, NULL, 0);
+      if (ms < 2 || ms > 1000) {
+        fprintf(stderr, "Invalid integration_ms '%s', expected 2..1000\n",
+                value);
+        return -1;
+      }
+      config->l5cx_integration_ms = (uint16_t)ms;
+    } else if (strcmp(opt, "ranging_mode") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr,
+                "Option 'ranging_mode' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "continuous") == 0) {
+        config->l5cx_ranging_mode = VL53L5CX_RANGING_MODE_CONTINUOUS;
+      } else if (strcmp(value, "autonomous") == 0) {
+        config->l5cx_ranging_mode = VL53L5CX_RANGING_MODE_AUTONOMOUS;
+      } else {
+        fprintf(stderr,
+                "Unknown ranging_mode '%s', expected continuous or "
+                "autonomous\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "sharpener") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'sharpener' applies only to l5cx, ignored\n");
+        continue;
+      }
+      long percent = strtol(value, NULL, 0);
+      if (percent < 0 || percent > 99) {
+        fprintf(stderr, "Invalid sharpener '%s', expected 0..99 %%\n", value);
+        return -1;
+      }
+      config->l5cx_sharpener = (int)percent;
+    } else if (strcmp(opt, "distance_mode") == 0) {
+      if (config->type != SENSOR_VL53L1X) {
+        fprintf(stderr,
+                "Option 'distance_mode' applies only to l1x, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "short") == 0) {
+        config->l1x_distance_mode = 1;
+      } else if (strcmp(value, "long") == 0) {
+        config->l1x_distance_mode = 2;
+      } else {
+        fprintf(stderr, "Unknown distance_mode '%s', expected short or long\n",
+                value);
+        return -1;
+      }
+    } else if (strcmp(opt, "timing_budget_ms") == 0) {
+      if (config->type != SENSOR_VL53L1X) {
+        fprintf(stderr,
+                "Option 'timing_budget_ms' applies only to l1x, ignored\n");
+        continue;
+      }
+      long ms = strtol(value, NULL, 0);
+      if (!l1x_budget_valid(ms)) {
+        fprintf(stderr,
+                "Invalid timing_budget_ms '%s', expected 15, 20, 33, 50, "
+                "100, 200 or 500\n",
+                value);
+        return -1;
+      }
+      config->l1x_timing_budget_ms = (uint16_t)ms;
+    } else if (strcmp(opt, "roi") == 0) {
+      if (config->type != SENSOR_VL53L1X) {
+        fprintf(stderr, "Option 'roi' applies only to l1x, ignored\n");
+        continue;
+      }
+      int width = 0, height = 0, center = -1, consumed = 0;
+      if (sscanf(value, "%dx%d@%d%n", &width, &height, &center, &consumed) !=
+              3 ||
+          value[consumed] != '\0') {
+        center = -1;
+        consumed = 0;
+        if (sscanf(value, "%dx%d%n", &width, &height, &consumed) != 2 ||
+            value[consumed] != '\0')
+          width = 0;
+      }
+      if (width < 4 || width > 16 || height < 4 || height > 16 ||
+          center > 255) {
+        fprintf(stderr,
+                "Invalid roi '%s', expected WxH or WxH@center "
+                "(4..16 SPADs, center 0..255)\n",
+                value);
+        return -1;
+      }
+      config->l1x_roi_width = (uint8_t)width;
+      config->l1x_roi_height = (uint8_t)height;
+      config->l1x_roi_center = center;
+    } else if (strcmp(opt, "rate_bands") == 0) {
+      if (config->type == SENSOR_TCS34725) {
+        fprintf(stderr,
+                "Option 'rate_bands' applies only to l5cx and l1x, ignored\n");
+        continue;
+      }
+      if (rate_parse(value, &config->rate_params) != 0) {
+        fprintf(stderr,
+                "Invalid rate_bands '%s', expected mm:value pairs with "
+                "increasing mm, up to %d bands\n",
+                value, RATE_MAX_BANDS);
+        return -1;
+      }
+    } else if (strcmp(opt, "rate_hysteresis_mm") == 0) {
+      long mm = strtol(value, NULL, 0);
+      if (mm < 0 || mm > 4000) {
+        fprintf(stderr, "Invalid rate_hysteresis_mm '%s', expected 0..4000\n",
+                value);
+        return -1;
+      }
+      config->rate_params.hysteresis_mm = (uint16_t)mm;
+    } else if (strcmp(opt, "rate_hold_ms") == 0) {
+      long ms = strtol(value, NULL, 0);
+      if (ms < 0) {
+        fprintf(stderr, "Invalid rate_hold_ms '%s', expected ms >= 0\n",
+                value);
+        return -1;
+      }
+      config->rate_params.hold_ms = (uint32_t)ms;
+    } else if (strcmp(opt, "targets") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr, "Option 'targets' applies only to l5cx, ignored\n");
+        continue;
+      }
+      long targets = strtol(value, NULL, 0);
+      if (targets < 1 || targets > TARGET_STACK_MAX) {
+        fprintf(stderr, "Invalid targets '%s', expected 1..%d\n", value,
+                TARGET_STACK_MAX);
+        return -1;
+      }
+      config->l5cx_targets = (uint8_t)targets;
+    } else if (strcmp(opt, "target_order") == 0) {
+      if (config->type != SENSOR_VL53L5CX) {
+        fprintf(stderr,
+                "Option 'target_order' applies only to l5cx, ignored\n");
+        continue;
+      }
+      if (strcmp(value, "closest") == 0) {
+        config->l5cx_target_order = VL53L5CX_TARGET_ORDER_CLOSEST;
+      } else if (strcmp(value, "strongest") == 0) {
+        config->l5cx_target_order = VL53L5CX_TARGET_ORDER_STRONGEST;
+      } else {
+        fprintf(stderr,
+                "Unknown target_order '%s', expected closest or strongest\n",
+                value);
+        return -1;
+      }
+    } else {
+      fprintf(stderr, "Unknown option '%s', ignored\n", opt);
+    }
+  }
+
+  // Модуль ядра сам ждёт INT датчика: линия на GPIO не нужна
+  if (config->int_pin >= 0 &&
+      config->l5cx_transport == VL53L5CX_TRANSPORT_KERNEL) {
+    fprintf(stderr,
+            "Option 'int_pin' applies only to transport=i2c, ignored\n");
+    config->int_pin = -1;
+  }
+
+  // Калман взвешивает зоны по range_sigma_mm: выход нужен в кадре
+  if (config->filter_params.kind == ZONE_FILTER_KALMAN)
+    config->l5cx_outputs |= VL53L5CX_OUTPUT_RANGE_SIGMA_MM;
+
+  // publish=motion без окна — окно по умолчанию; агрегаты движения нужны
+  // в кадре
+  if (config->gate_params.mode == CHANGE_GATE_MOTION)
+    config->motion_params.enabled = 1;
+  if (config->motion_params.enabled)
+    config->l5cx_outputs |= VL53L5CX_OUTPUT_MOTION_INDICATOR;
+
+  // Стек целей: сколько целей найдено в зоне и их погрешности
+  if (config->l5cx_targets > 1)
+    config->l5cx_outputs |=
+        VL53L5CX_OUTPUT_NB_TARGET_DETECTED | VL53L5CX_OUTPUT_RANGE_SIGMA_MM;
+
+  // Пределы датчика, зависящие от нескольких опций: частота VL53L5CX по
+  // разрешению, время интеграции (режим autonomous) короче периода
+  // измерений, бюджет 15 мс VL53L1X только в ближнем режиме
+  uint8_t max_hz = config->l5cx_resolution == VL53L5CX_RESOLUTION_8X8
+                       ? L5CX_MAX_FREQUENCY_HZ_8X8
+                       : L5CX_MAX_FREQUENCY_HZ_4X4;
+  if (config->type == SENSOR_VL53L5CX && config->l5cx_frequency_hz > max_hz) {
+    fprintf(stderr, "frequency_hz=%u exceeds %u Hz for %s\n",
+            config->l5cx_frequency_hz, max_hz,
+            config->l5cx_resolution == VL53L5CX_RESOLUTION_8X8 ? "8x8"
+                                                               : "4x4");
+    return -1;
+  }
+  // В режиме continuous время интеграции не используется; без
+  // ranging_mode= остаётся режим прошивки по умолчанию, autonomous
+  uint16_t integration_ms =
+      config->l5cx_ranging_mode == VL53L5CX_RANGING_MODE_CONTINUOUS
+          ? 0
+          : config->l5cx_integration_ms;
+  if (integration_ms * config->l5cx_frequency_hz >= 1000) {
+    fprintf(stderr,
+            "integration_ms=%u does not fit the %u Hz ranging period\n",
+            integration_ms, config->l5cx_frequency_hz);
+    return -1;
+  }
+  if (config->l5cx_threshold_mode &&
+      config->l5cx_ranging_mode == VL53L5CX_RANGING_MODE_CONTINUOUS) {
+    fprintf(stderr, "mode=threshold needs ranging_mode=autonomous\n");
+    return -1;
+  }
+  if (config->type == SENSOR_VL53L1X && config->l1x_timing_budget_ms == 15 &&
+      config->l1x_distance_mode != 1) {
+    fprintf(stderr, "timing_budget_ms=15 needs distance_mode=short\n");
+    return -1;
+  }
+
+  // Полосы частоты — в тех же пределах, что и базовая частота
+  for (int i = 0; i < config->rate_params.count; i++) {
+    uint16_t v = config->rate_params.value[i];
+    if (config->type == SENSOR_VL53L5CX &&
+        (v > max_hz || integration_ms * v >= 1000)) {
+      fprintf(stderr,
+              "rate_bands: %u Hz exceeds %u Hz or the integration time\n", v,
+              max_hz);
+      return -1;
+    }
+    if (config->type == SENSOR_VL53L1X &&
+        (!l1x_budget_valid(v) ||
+         (v == 15 && config->l1x_distance_mode != 1))) {
+      fprintf(stderr,
+              "rate_bands: invalid timing budget %u ms for distance_mode\n",
+              v);
+      return -1;
+    }
+  }
+  rate_init(&config->rate, &config->rate_params);
+  config->period_us = rate_period_us(
+      config, config->type == SENSOR_VL53L5CX ? config->l5cx_frequency_hz
+                                              : config->l1x_timing_budget_ms);
+
+#ifndef SENSORS2SHM_SIM
+  // Готовность кадра по I2C видна на каждом кадре: отбор кадров по порогам
+  // даёт только линия INT
+  if (config->l5cx_threshold_mode && config->int_pin < 0 &&
+      config->l5cx_transport != VL53L5CX_TRANSPORT_KERNEL) {
+    fprintf(stderr, "mode=threshold needs int_pin= or transport=kernel\n");
+    return -1;
+  }
+#endif
+  return 0;
+}
+
 int read_config(const char *config_path, SensorConfig *configs, int *count) {
   FILE *file = fopen(config_path, "r");
   if (!file) {
@@ -770,7 +2582,7 @@ int read_config(const char *config_path, SensorConfig *configs, int *count) {
   char type_str[32];
   *count = 0;
 
-  while (fgets(line, sizeof(line), file) && *count < 6) {
+  while (fgets(line, sizeof(line), file) && *count < MAX_SENSORS) {
     // Пропускаем пустые строки и комментарии
     char *trimmed = line;
     while (*trimmed == ' ' || *trimmed == '\t')
@@ -800,9 +2612,13 @@ int read_config(const char *config_path, SensorConfig *configs, int *count) {
       continue; // Пропускаем пустые строки после обработки
 
     // Парсим строку
-    if (sscanf(trimmed, "%31s %d %hhx %255s", type_str,
+    int consumed = 0;
+    if (sscanf(trimmed, "%31s %d %hhx %255s%n", type_str,
                &configs[*count].xshut_pin, &configs[*count].i2c_addr,
-               configs[*count].shm_name) == 4) {
+               configs[*count].shm_name, &consumed) == 4) {
+
+      configs[*count].index = *count;
+      configs[*count].l5cx_streamcount = 255;
 
       // Преобразуем строку в SensorType
       if (strcmp(type_str, "l1x") == 0) {
@@ -817,6 +2633,68 @@ int read_config(const char *config_path, SensorConfig *configs, int *count) {
         continue;
       }
 
+      // Необязательные опции после имени файла
+      configs[*count].l5cx_outputs = L5CX_DEFAULT_OUTPUTS;
+      configs[*count].l5cx_transport = VL53L5CX_TRANSPORT_I2C_DEV;
+      configs[*count].dev_path[0] = '\0';
+      configs[*count].filter_params.kind = ZONE_FILTER_NONE;
+      configs[*count].filter_params.alpha = ZONE_FILTER_DEFAULT_ALPHA;
+      configs[*count].filter_params.process_noise_mm =
+          ZONE_FILTER_DEFAULT_NOISE_MM;
+      configs[*count].filter = NULL;
+      configs[*count].filtered_shm = NULL;
+      configs[*count].gate_params.mode = CHANGE_GATE_OFF;
+      configs[*count].gate_params.threshold_mm = CHANGE_GATE_DEFAULT_MM;
+      configs[*count].gate_params.min_zones = CHANGE_GATE_DEFAULT_ZONES;
+      configs[*count].gate_params.heartbeat_ms =
+          CHANGE_GATE_DEFAULT_HEARTBEAT_MS;
+      configs[*count].gate = NULL;
+      configs[*count].cloud_enabled = 0;
+      memset(&configs[*count].cloud_pose, 0, sizeof(CloudPose));
+      configs[*count].cloud = NULL;
+      configs[*count].cloud_shm = NULL;
+      memset(&configs[*count].sector_map, 0, sizeof(SectorMap));
+      configs[*count].sectors_shm = NULL;
+      configs[*count].motion_params.enabled = 0;
+      configs[*count].motion_params.min_mm = MOTION_DEFAULT_MIN_MM;
+      configs[*count].motion_params.max_mm = MOTION_DEFAULT_MAX_MM;
+      configs[*count].motion_params.threshold = 0;
+      configs[*count].motion_params.min_aggregates =
+          MOTION_DEFAULT_AGGREGATES;
+      configs[*count].motion_shm = NULL;
+      configs[*count].l5cx_targets = 1;
+      configs[*count].l5cx_target_order = VL53L5CX_TARGET_ORDER_STRONGEST;
+      configs[*count].targets_shm = NULL;
+      configs[*count].l5cx_resolution = L5CX_DEFAULT_RESOLUTION;
+      configs[*count].l5cx_frequency_hz = L5CX_DEFAULT_FREQUENCY_HZ;
+      configs[*count].l5cx_integration_ms = 0;
+      configs[*count].l5cx_ranging_mode = 0;
+      configs[*count].l5cx_sharpener = -1;
+      configs[*count].l1x_distance_mode = L1X_DEFAULT_DISTANCE_MODE;
+      configs[*count].l1x_timing_budget_ms = L1X_DEFAULT_TIMING_BUDGET_MS;
+      configs[*count].l1x_roi_width = 0;
+      configs[*count].l1x_roi_height = 0;
+      configs[*count].l1x_roi_center = -1;
+      configs[*count].l5cx_threshold_mode = 0;
+      configs[*count].threshold_low_mm = 0;
+      configs[*count].threshold_high_mm = L5CX_DEFAULT_THRESHOLD_MM;
+      configs[*count].int_pin = -1;
+      memset(&configs[*count].rate_params, 0, sizeof(RateParams));
+      configs[*count].rate_params.hysteresis_mm = RATE_DEFAULT_HYSTERESIS_MM;
+      configs[*count].rate_params.hold_ms = RATE_DEFAULT_HOLD_MS;
+      if (parse_sensor_options(&configs[*count], trimmed + consumed) != 0) {
+        fprintf(stderr, "Invalid options for sensor '%s', skipping\n",
+                configs[*count].shm_name);
+        continue;
+      }
+      if (configs[*count].dev_path[0] == '\0') {
+        snprintf(configs[*count].dev_path, sizeof(configs[*count].dev_path),
+                 "%s",
+                 configs[*count].l5cx_transport == VL53L5CX_TRANSPORT_KERNEL
+                     ? "/dev/stmvl53l5cx"
+                     : "/dev/i2c-1");
+      }
+
       printf("Loaded config: %s pin=%d addr=0x%02X file=%s\n", type_str,
              configs[*count].xshut_pin, configs[*count].i2c_addr,
              configs[*count].shm_name);
@@ -832,24 +2710,74 @@ int read_config(const char *config_path, SensorConfig *configs, int *count) {
 }
 
 int main(int argc, char *argv[]) {
-  SensorConfig configs[6];
+  SensorConfig configs[MAX_SENSORS];
   int sensor_count = 0;
   uint8_t sensor_data[4];
   int daemon_mode = 0;
-
-  // Проверяем аргумент для режима демона
-  if (argc > 1 && strcmp(argv[1], "--daemon") == 0) {
-    daemon_mode = 1;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  int replay_fast = 0;
+  int replay_repeat = 1;
+  int profile_i2c = 0;
+  uint32_t trace_records = 0;
+  int polar = 0;
+  uint32_t history_mb = 0;
+
+  // Разбираем аргументы: режим демона, запись и воспроизведение кадров
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--daemon") == 0) {
+      daemon_mode = 1;
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replay_path = argv[++i];
+    } else if (strcmp(argv[i], "--fast") == 0) {
+      replay_fast = 1;
+    } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      replay_repeat = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--profile-i2c") == 0) {
+      profile_i2c = 1;
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_records = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--polar") == 0) {
+      polar = 1;
+    } else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc) {
+      history_mb = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--daemon] [--profile-i2c] [--trace RECORDS] "
+              "[--polar] [--history MB] [--record FILE] "
+              "[--replay FILE [--fast] [--repeat N]]\n",
+              argv[0]);
+      return EXIT_FAILURE;
+    }
   }
 
   // Устанавливаем обработчик сигналов для корректного завершения
   signal(SIGINT, signal_handler);  // Ctrl+C
   signal(SIGTERM, signal_handler); // kill
 
+  // SIGUSR2 без SA_RESTART: прерывает ожидание прерывания в потоках чтения
+  struct sigaction wakeup_action;
+  memset(&wakeup_action, 0, sizeof(wakeup_action));
+  wakeup_action.sa_handler = wakeup_handler;
+  sigemptyset(&wakeup_action.sa_mask);
+  sigaction(SIGUSR2, &wakeup_action, NULL);
+
+  // SIGUSR1 — отчёт профиля I2C (без профиля только сообщение)
+  signal(SIGUSR1, i2c_stats_handler);
+
   if (!daemon_mode) {
     printf("Программа запущена. Нажмите Ctrl+C для остановки.\n");
   }
 
+  // Воспроизведение записи вместо датчиков
+  if (replay_path) {
+    return replay_record(replay_path, replay_fast, replay_repeat) == 0
+               ? EXIT_SUCCESS
+               : EXIT_FAILURE;
+  }
+
   // read config file
   if (read_config("./sensors_config.txt", configs, &sensor_count) != 0) {
     if (!daemon_mode)
@@ -857,8 +2785,15 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  if (profile_i2c && start_i2c_stats(configs, sensor_count) != 0)
+    return EXIT_FAILURE;
+
+  if (polar && start_polar(configs, sensor_count) != 0)
+    return EXIT_FAILURE;
+
   // sensors init
   if (init_gpio(configs, sensor_count) != 0) {
+    polar_close();
     if (!daemon_mode)
       fprintf(stderr, "Error: sensors initialization failed\n");
     return EXIT_FAILURE;
@@ -867,6 +2802,7 @@ int main(int argc, char *argv[]) {
   // Запускаем измерение для всех инициализированных датчиков
   for (int i = 0; i < sensor_count; i++) {
     if (configs[i].initialized) {
+      i2c_stats_context(i, I2C_CALL_START_STOP);
       switch (configs[i].type) {
       case SENSOR_VL53L1X:
         VL53L1X_StartRanging(configs[i].i2c_addr << 1);
@@ -886,6 +2822,25 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // Файл записи открывается до демонизации (относительный путь)
+  if (record_path && start_recording(record_path, configs, sensor_count) != 0) {
+    stop_all_sensors(configs, sensor_count);
+    return EXIT_FAILURE;
+  }
+
+  if (trace_records && start_trace(trace_records, configs, sensor_count) != 0) {
+    stop_recording(daemon_mode);
+    stop_all_sensors(configs, sensor_count);
+    return EXIT_FAILURE;
+  }
+
+  if (history_mb && start_history(history_mb, configs, sensor_count) != 0) {
+    trace_close();
+    stop_recording(daemon_mode);
+    stop_all_sensors(configs, sensor_count);
+    return EXIT_FAILURE;
+  }
+
   // ТЕПЕРЬ запускаем демонизацию ПОСЛЕ инициализации датчиков
   if (daemon_mode) {
     // Не используем printf после демонизации!
@@ -897,10 +2852,22 @@ int main(int argc, char *argv[]) {
     printf("Инициализация датчиков завершена. Запуск демона...\n");
   }
 
+  // Счётчики создаются после daemonize(): в сегменте PID демона
+  start_metrics(configs, sensor_count, daemon_mode);
+
+  // Датчики на модуле ядра и с линией INT читаются в своих потоках по
+  // прерыванию
+  start_kernel_readers(configs, sensor_count);
+
+  // Если опрашивать некого, основной цикл только ждёт сигналов
+  int polled = 0;
+  for (int i = 0; i < sensor_count; i++)
+    polled += configs[i].initialized && !configs[i].reader_started;
+
   // main loop
   while (running) {
     for (int i = 0; i < sensor_count; i++) {
-      if (configs[i].initialized) {
+      if (configs[i].initialized && !configs[i].reader_started) {
         if (read_sensor_data(&configs[i], sensor_data) == 0) {
           if (configs[i].type == SENSOR_VL53L5CX) {
             if (!daemon_mode) {
@@ -929,11 +2896,25 @@ int main(int argc, char *argv[]) {
         }
       }
     }
-    delay(10); // Пауза между циклами
+    if (i2c_stats_requested) {
+      i2c_stats_requested = 0;
+      write_i2c_stats(daemon_mode);
+    }
+    trace_event(TRACE_NO_SENSOR, TRACE_SLEEP_START, 0);
+    delay(polled ? 10 : 1000); // Пауза между циклами
+    trace_event(TRACE_NO_SENSOR, TRACE_SLEEP_END, 0);
   }
 
   // Корректное завершение
+  stop_kernel_readers(configs, sensor_count);
+  stop_recording(daemon_mode);
   stop_all_sensors(configs, sensor_count);
+  metrics_close();
+  polar_close();
+  history_close();
+  trace_close();
+  if (profile_i2c && !daemon_mode)
+    write_i2c_stats(daemon_mode);
 
   // Удаляем PID файл при завершении (только в режиме демона)
   if (daemon_mode) {
@@ -0,0 +1,339 @@
+// Нагрузка на сегмент shared memory множеством читателей: один писатель
+// публикует матрицу 8x8 с фиксированным периодом, от 1 до 64 процессов
+// читают сегмент без пауз. Сравнивает семафор /sem_<имя> (версии формата
+// до 2) и seqlock: время записи и опоздание пробуждения писателя, число
+// чтений в секунду и повторы читателей. Результат — таблица и JSON.
+
+#include <fcntl.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shm_layout.h"
+
+#define MAX_READERS 64
+#define MAX_RUNS 32
+
+typedef enum { MODE_SEM, MODE_SEQLOCK, MODE_COUNT } Mode;
+
+static const char *mode_names[MODE_COUNT] = {"sem", "seqlock"};
+
+typedef struct {
+  uint64_t p50, p99, max;
+} Summary;
+
+// Результат одного прогона (режим, число читателей)
+typedef struct {
+  Mode mode;
+  int readers;
+  uint64_t writes;
+  Summary write_ns;     // От начала записи до освобождения сегмента
+  Summary wake_late_ns; // Опоздание пробуждения писателя
+  double reads_per_s;   // Суммарно по читателям
+  double retries_per_read;
+  uint64_t torn; // Снимков со смесью двух кадров
+} RunResult;
+
+// Счётчики читателя в общей памяти (MAP_SHARED | MAP_ANONYMOUS)
+typedef struct {
+  uint64_t reads;
+  uint64_t retries;
+  uint64_t torn;
+} ReaderStats;
+
+typedef struct {
+  volatile int go; // Писатель начал публикацию, счёт чтений идёт
+  volatile int stop;
+  ReaderStats readers[MAX_READERS];
+} Shared;
+
+static RunResult runs[MAX_RUNS];
+static int run_count = 0;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static Summary summarize(uint64_t *values, uint64_t count) {
+  Summary s = {0, 0, 0};
+  if (!count)
+    return s;
+  qsort(values, count, sizeof(*values), compare_u64);
+  s.p50 = values[count / 2];
+  s.p99 = values[(count * 99) / 100];
+  s.max = values[count - 1];
+  return s;
+}
+
+// Кадр писателя: все зоны матрицы равны номеру кадра, поэтому читатель
+// узнаёт снимок, в который попали два кадра
+static int snapshot_torn(const SensorData *snap) {
+  for (int i = 1; i < 64; i++)
+    if (snap->data.matrix.distances[i] != snap->data.matrix.distances[0])
+      return 1;
+  return 0;
+}
+
+static void run_reader(Mode mode, SensorData *data, sem_t *sem,
+                       Shared *shared, ReaderStats *stats) {
+  SensorData snap;
+
+  while (!shared->go)
+    usleep(1000);
+  while (!shared->stop) {
+    if (mode == MODE_SEM) {
+      sem_wait(sem);
+      memcpy(&snap, data, sizeof(snap));
+      sem_post(sem);
+    } else {
+      stats->retries += shm_read_snapshot(data, &snap);
+    }
+    stats->reads++;
+    if (snap.data_format == 1 && snapshot_torn(&snap))
+      stats->torn++;
+  }
+}
+
+static int run_case(Mode mode, int readers, double duration_s,
+                    long period_us) {
+  char name[64], sem_name[64];
+  snprintf(name, sizeof(name), "/bench_contention_%d", (int)getpid());
+  snprintf(sem_name, sizeof(sem_name), "/sem_bench_contention_%d",
+           (int)getpid());
+
+  int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+  if (fd < 0 || ftruncate(fd, sizeof(SensorData)) != 0) {
+    perror("Failed to create benchmark shared memory");
+    return -1;
+  }
+  SensorData *data = mmap(NULL, sizeof(SensorData), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+  close(fd);
+  sem_t *sem = sem_open(sem_name, O_CREAT, 0600, 1);
+  Shared *shared = mmap(NULL, sizeof(Shared), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED || sem == SEM_FAILED || shared == MAP_FAILED) {
+    perror("Failed to set up benchmark segment");
+    shm_unlink(name);
+    sem_unlink(sem_name);
+    return -1;
+  }
+  memset(data, 0, sizeof(*data));
+
+  pid_t pids[MAX_READERS];
+  for (int i = 0; i < readers; i++) {
+    pids[i] = fork();
+    if (pids[i] == 0) {
+      run_reader(mode, data, sem, shared, &shared->readers[i]);
+      _exit(0);
+    }
+  }
+
+  uint64_t max_writes = (uint64_t)(duration_s * 1e6 / period_us) + 1;
+  uint64_t *write_ns = calloc(max_writes, sizeof(*write_ns));
+  uint64_t *late_ns = calloc(max_writes, sizeof(*late_ns));
+  uint16_t distances[64];
+  uint8_t statuses[64];
+  FrameInfo frame = {0};
+  memset(statuses, 5, sizeof(statuses));
+
+  // Читатели успевают запуститься до первого кадра
+  usleep(100000);
+  shared->go = 1;
+
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  uint64_t writes = 0, start = now_ns();
+
+  while (writes < max_writes && write_ns && late_ns) {
+    next.tv_nsec += period_us * 1000;
+    while (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      next.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+    uint64_t woke = now_ns();
+    uint64_t deadline = (uint64_t)next.tv_sec * 1000000000ull + next.tv_nsec;
+    for (int i = 0; i < 64; i++)
+      distances[i] = (uint16_t)writes;
+
+    if (mode == MODE_SEM) {
+      sem_wait(sem);
+      shm_fill_matrix(data, 1, distances, statuses, 64);
+      shm_publish_frame(data, &frame, woke);
+      sem_post(sem);
+    } else {
+      shm_write_begin(data);
+      shm_fill_matrix(data, 1, distances, statuses, 64);
+      shm_publish_frame(data, &frame, woke);
+      shm_write_end(data);
+    }
+
+    write_ns[writes] = now_ns() - woke;
+    late_ns[writes] = woke > deadline ? woke - deadline : 0;
+    writes++;
+  }
+  double elapsed_s = (now_ns() - start) / 1e9;
+
+  shared->stop = 1;
+  for (int i = 0; i < readers; i++)
+    waitpid(pids[i], NULL, 0);
+
+  RunResult *r = &runs[run_count++];
+  uint64_t reads = 0, retries = 0;
+  memset(r, 0, sizeof(*r));
+  r->mode = mode;
+  r->readers = readers;
+  r->writes = writes;
+  r->write_ns = summarize(write_ns, writes);
+  r->wake_late_ns = summarize(late_ns, writes);
+  for (int i = 0; i < readers; i++) {
+    reads += shared->readers[i].reads;
+    retries += shared->readers[i].retries;
+    r->torn += shared->readers[i].torn;
+  }
+  r->reads_per_s = elapsed_s > 0 ? reads / elapsed_s : 0;
+  r->retries_per_read = reads ? (double)retries / reads : 0;
+
+  printf("%-8s %7d %8llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f "
+         "%13.0f %9.4f %6llu\n",
+         mode_names[mode], readers, (unsigned long long)writes,
+         r->write_ns.p50 / 1e3, r->write_ns.p99 / 1e3, r->write_ns.max / 1e3,
+         r->wake_late_ns.p50 / 1e3, r->wake_late_ns.p99 / 1e3,
+         r->wake_late_ns.max / 1e3, r->reads_per_s, r->retries_per_read,
+         (unsigned long long)r->torn);
+  fflush(stdout);
+
+  free(write_ns);
+  free(late_ns);
+  munmap(shared, sizeof(Shared));
+  munmap(data, sizeof(SensorData));
+  sem_close(sem);
+  sem_unlink(sem_name);
+  shm_unlink(name);
+  return 0;
+}
+
+static void print_summary(FILE *out, const char *key, const Summary *s,
+                          const char *tail) {
+  fprintf(out, "\"%s\": {\"p50\": %llu, \"p99\": %llu, \"max\": %llu}%s",
+          key, (unsigned long long)s->p50, (unsigned long long)s->p99,
+          (unsigned long long)s->max, tail);
+}
+
+static void print_json(FILE *out, double duration_s, long period_us) {
+  fprintf(out, "{\n  \"duration_s\": %.1f,\n  \"period_us\": %ld,\n",
+          duration_s, period_us);
+  fprintf(out, "  \"runs\": [\n");
+  for (int i = 0; i < run_count; i++) {
+    const RunResult *r = &runs[i];
+    fprintf(out,
+            "    {\"mode\": \"%s\", \"readers\": %d, \"writes\": %llu, ",
+            mode_names[r->mode], r->readers, (unsigned long long)r->writes);
+    print_summary(out, "writer_ns", &r->write_ns, ", ");
+    print_summary(out, "wake_late_ns", &r->wake_late_ns, ", ");
+    fprintf(out,
+            "\"reads_per_s\": %.0f, \"retries_per_read\": %.6f, "
+            "\"torn\": %llu}%s\n",
+            r->reads_per_s, r->retries_per_read, (unsigned long long)r->torn,
+            i + 1 < run_count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-m sem|seqlock|both] [-r N[,N...]] [-d SECONDS] "
+          "[-p PERIOD_US] [-j FILE]\n",
+          prog);
+}
+
+int main(int argc, char *argv[]) {
+  const char *readers_list = "1,2,4,8,16,32,64";
+  const char *json_path = NULL;
+  double duration_s = 2.0;
+  long period_us = 1000;
+  int modes[MODE_COUNT] = {1, 1};
+  int opt;
+
+  while ((opt = getopt(argc, argv, "m:r:d:p:j:")) != -1) {
+    switch (opt) {
+    case 'm':
+      modes[MODE_SEM] = !strcmp(optarg, "sem") || !strcmp(optarg, "both");
+      modes[MODE_SEQLOCK] =
+          !strcmp(optarg, "seqlock") || !strcmp(optarg, "both");
+      if (!modes[MODE_SEM] && !modes[MODE_SEQLOCK]) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'r':
+      readers_list = optarg;
+      break;
+    case 'd':
+      duration_s = atof(optarg);
+      break;
+    case 'p':
+      period_us = atol(optarg);
+      break;
+    case 'j':
+      json_path = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (duration_s <= 0 || period_us <= 0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  printf("writer period %ld us, %.1f s per run; times in us\n", period_us,
+         duration_s);
+  printf("%-8s %7s %8s %10s %10s %10s %10s %10s %10s %13s %9s %6s\n", "mode",
+         "readers", "writes", "write_p50", "write_p99", "write_max",
+         "late_p50", "late_p99", "late_max", "reads/s", "retries", "torn");
+
+  for (int mode = 0; mode < MODE_COUNT; mode++) {
+    if (!modes[mode])
+      continue;
+    const char *p = readers_list;
+    while (*p && run_count < MAX_RUNS) {
+      char *end;
+      long readers = strtol(p, &end, 10);
+      if (end == p || readers < 1 || readers > MAX_READERS) {
+        fprintf(stderr, "Reader count must be 1..%d\n", MAX_READERS);
+        return EXIT_FAILURE;
+      }
+      if (run_case(mode, (int)readers, duration_s, period_us) != 0)
+        return EXIT_FAILURE;
+      p = *end == ',' ? end + 1 : end;
+    }
+  }
+
+  if (json_path) {
+    FILE *out = fopen(json_path, "w");
+    if (!out) {
+      perror("Failed to open JSON file");
+      return EXIT_FAILURE;
+    }
+    print_json(out, duration_s, period_us);
+    fclose(out);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,367 @@
+// Замер задержки кадра от готовности на датчике до читателя shared memory.
+// Запускает N процессов-читателей, которые опрашивают сегменты демона так же,
+// как обычные клиенты (seqlock), и по блоку FrameInfo считают задержку
+// каждого этапа. Результат — перцентили, гистограммы и доля пропущенных
+// кадров в JSON для сравнения между версиями.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shm_layout.h"
+
+#define MAX_SEGMENTS 64
+#define MAX_READERS 32
+
+// Отсчётов на читателя: при 36 датчиках по 15 Гц — около 8 минут
+#define MAX_SAMPLES (1 << 18)
+
+// Корзины гистограммы: корзина i — задержки меньше 2^i мкс
+#define HIST_BUCKETS 24
+
+// Значение этапа, который не удалось измерить
+#define NO_SAMPLE UINT32_MAX
+
+typedef enum {
+  STAGE_READY_TO_DETECT, // Готовность на датчике -> check_data_ready
+  STAGE_DETECT_TO_READ,  // check_data_ready -> кадр прочитан по I2C
+  STAGE_READ_TO_PUBLISH, // Чтение -> запись в shared memory
+  STAGE_PUBLISH_TO_SEEN, // Запись -> кадр увидел читатель
+  STAGE_END_TO_END,      // Готовность на датчике -> кадр увидел читатель
+  STAGE_COUNT
+} Stage;
+
+static const char *stage_names[STAGE_COUNT] = {
+    "ready_to_detect", "detect_to_read", "read_to_publish",
+    "publish_to_observe", "end_to_end"};
+
+// Задержки этапов одного кадра в нс
+typedef struct {
+  uint32_t stage[STAGE_COUNT];
+} Sample;
+
+// Счётчики одного сегмента у читателя
+typedef struct {
+  int seen;         // Читатель видел хотя бы один кадр
+  uint32_t first_seq, last_seq;
+  uint32_t first_dropped, last_dropped;
+  uint64_t observed; // Кадров увидено
+  uint64_t missed;   // Публикаций, перезаписанных до чтения
+} SegmentStats;
+
+// Результаты читателя в общей памяти (MAP_SHARED | MAP_ANONYMOUS)
+typedef struct {
+  SegmentStats segments[MAX_SEGMENTS];
+  uint64_t count;     // Сохранено отсчётов
+  uint64_t truncated; // Отсчётов сверх MAX_SAMPLES
+  Sample samples[MAX_SAMPLES];
+} ReaderResult;
+
+typedef struct {
+  const char *name;
+  const SensorData *data;
+} Segment;
+
+static Segment segments[MAX_SEGMENTS];
+static int segment_count = 0;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Сегмент демона; демон может ещё инициализировать датчики,
+// поэтому открытие повторяется до wait_s секунд
+static int open_segment(Segment *seg, const char *name, int wait_s) {
+  char path[300];
+  uint64_t deadline = now_ns() + (uint64_t)wait_s * 1000000000ull;
+  int fd;
+
+  seg->name = name;
+  snprintf(path, sizeof(path), "/%s", name);
+  while ((fd = shm_open(path, O_RDONLY, 0)) < 0) {
+    if (errno != ENOENT || now_ns() > deadline) {
+      fprintf(stderr, "%s: %s\n", name, strerror(errno));
+      return -1;
+    }
+    usleep(100000);
+  }
+
+  // Размер проверяется после открытия: демон создаёт сегмент не сразу
+  // нужного размера (shm_open, затем ftruncate)
+  struct stat st;
+  while (fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(SensorData)) {
+    if (now_ns() > deadline) {
+      fprintf(stderr, "%s: segment too small, daemon is older than "
+                      "layout version %d\n",
+              name, SHM_LAYOUT_VERSION);
+      close(fd);
+      return -1;
+    }
+    usleep(100000);
+  }
+
+  seg->data = mmap(NULL, sizeof(SensorData), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (seg->data == MAP_FAILED) {
+    perror("mmap failed");
+    return -1;
+  }
+  return 0;
+}
+
+static uint32_t delta_ns(uint64_t from, uint64_t to) {
+  if (!from || !to || to < from || to - from >= NO_SAMPLE)
+    return NO_SAMPLE;
+  return (uint32_t)(to - from);
+}
+
+// Цикл читателя: опрос всех сегментов с интервалом poll_us до deadline
+static void run_reader(ReaderResult *res, uint64_t deadline, int poll_us) {
+  struct timespec pause = {poll_us / 1000000, (poll_us % 1000000) * 1000};
+  SensorData snap;
+
+  while (now_ns() < deadline) {
+    for (int i = 0; i < segment_count; i++) {
+      SegmentStats *st = &res->segments[i];
+      const FrameInfo *f = &snap.frame;
+
+      shm_read_snapshot(segments[i].data, &snap);
+      if (snap.reserved < SHM_LAYOUT_VERSION || f->seq == 0)
+        continue;
+      if (st->seen && f->seq == st->last_seq)
+        continue;
+      uint64_t observe_ns = now_ns();
+
+      if (!st->seen) {
+        // Первый снимок задаёт начало отсчёта, его задержка не считается:
+        // кадр мог быть опубликован задолго до запуска читателя
+        st->seen = 1;
+        st->first_seq = f->seq;
+        st->first_dropped = f->dropped;
+      } else {
+        st->missed += f->seq - st->last_seq - 1;
+        st->observed++;
+
+        if (res->count < MAX_SAMPLES) {
+          Sample *s = &res->samples[res->count++];
+          s->stage[STAGE_READY_TO_DETECT] = delta_ns(f->ready_ns, f->detect_ns);
+          s->stage[STAGE_DETECT_TO_READ] = delta_ns(f->detect_ns, f->read_ns);
+          s->stage[STAGE_READ_TO_PUBLISH] = delta_ns(f->read_ns, f->publish_ns);
+          s->stage[STAGE_PUBLISH_TO_SEEN] = delta_ns(f->publish_ns, observe_ns);
+          s->stage[STAGE_END_TO_END] = delta_ns(f->ready_ns, observe_ns);
+        } else {
+          res->truncated++;
+        }
+      }
+      st->last_seq = f->seq;
+      st->last_dropped = f->dropped;
+    }
+    nanosleep(&pause, NULL);
+  }
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Значение перцентиля p (0..1) отсортированного массива, в мкс
+static double percentile_us(const uint32_t *sorted, uint64_t n, double p) {
+  uint64_t idx = (uint64_t)(p * n + 0.999999);
+  return sorted[idx ? idx - 1 : 0] / 1e3;
+}
+
+// Статистика этапа по отсчётам всех читателей
+static void print_stage(FILE *out, Stage stage, ReaderResult **results,
+                        int readers, uint32_t *values) {
+  uint64_t hist[HIST_BUCKETS] = {0};
+  uint64_t n = 0;
+  double sum = 0;
+
+  for (int r = 0; r < readers; r++) {
+    for (uint64_t i = 0; i < results[r]->count; i++) {
+      uint32_t v = results[r]->samples[i].stage[stage];
+      if (v != NO_SAMPLE)
+        values[n++] = v;
+    }
+  }
+
+  fprintf(out, "    \"%s\": {\"count\": %llu", stage_names[stage],
+          (unsigned long long)n);
+  if (!n) {
+    fprintf(out, "}");
+    return;
+  }
+
+  qsort(values, n, sizeof(*values), compare_u32);
+  int last = 0;
+  for (uint64_t i = 0; i < n; i++) {
+    int b = 0;
+    while (b < HIST_BUCKETS - 1 && values[i] >= (1000ull << b))
+      b++;
+    hist[b]++;
+    if (b > last)
+      last = b;
+    sum += values[i];
+  }
+
+  fprintf(out,
+          ", \"min_us\": %.3f, \"mean_us\": %.3f, \"p50_us\": %.3f, "
+          "\"p99_us\": %.3f, \"p999_us\": %.3f, \"max_us\": %.3f, "
+          "\"histogram_log2_us\": [",
+          values[0] / 1e3, sum / n / 1e3, percentile_us(values, n, 0.5),
+          percentile_us(values, n, 0.99), percentile_us(values, n, 0.999),
+          values[n - 1] / 1e3);
+  for (int b = 0; b <= last; b++)
+    fprintf(out, "%s%llu", b ? ", " : "", (unsigned long long)hist[b]);
+  fprintf(out, "]}");
+}
+
+static void print_report(FILE *out, ReaderResult **results, int readers,
+                         int duration_s, int poll_us) {
+  uint64_t published = 0, dropped = 0, observed = 0, missed = 0;
+  uint64_t truncated = 0, total = 0;
+
+  // Публикации и пропуски демона — по первому читателю: у всех читателей
+  // одни и те же сегменты
+  for (int i = 0; i < segment_count; i++) {
+    const SegmentStats *st = &results[0]->segments[i];
+    if (!st->seen)
+      continue;
+    published += st->last_seq - st->first_seq;
+    dropped += st->last_dropped - st->first_dropped;
+  }
+  for (int r = 0; r < readers; r++) {
+    for (int i = 0; i < segment_count; i++) {
+      observed += results[r]->segments[i].observed;
+      missed += results[r]->segments[i].missed;
+    }
+    truncated += results[r]->truncated;
+    total += results[r]->count;
+  }
+
+  fprintf(out, "{\n  \"layout_version\": %d,\n", SHM_LAYOUT_VERSION);
+  fprintf(out, "  \"readers\": %d,\n  \"duration_s\": %d,\n", readers,
+          duration_s);
+  fprintf(out, "  \"poll_us\": %d,\n  \"segments\": [", poll_us);
+  for (int i = 0; i < segment_count; i++)
+    fprintf(out, "%s\"%s\"", i ? ", " : "", segments[i].name);
+  fprintf(out, "],\n");
+  fprintf(out, "  \"frames_published\": %llu,\n",
+          (unsigned long long)published);
+  fprintf(out, "  \"frames_dropped_daemon\": %llu,\n",
+          (unsigned long long)dropped);
+  fprintf(out, "  \"drop_rate_daemon\": %.6f,\n",
+          published + dropped ? (double)dropped / (published + dropped) : 0.0);
+  fprintf(out, "  \"frames_observed\": %llu,\n", (unsigned long long)observed);
+  fprintf(out, "  \"frames_missed_readers\": %llu,\n",
+          (unsigned long long)missed);
+  fprintf(out, "  \"miss_rate_readers\": %.6f,\n",
+          observed + missed ? (double)missed / (observed + missed) : 0.0);
+  fprintf(out, "  \"samples_truncated\": %llu,\n",
+          (unsigned long long)truncated);
+  fprintf(out, "  \"stages\": {\n");
+
+  uint32_t *values = malloc((total ? total : 1) * sizeof(uint32_t));
+  if (!values) {
+    perror("malloc failed");
+    exit(EXIT_FAILURE);
+  }
+  for (int s = 0; s < STAGE_COUNT; s++) {
+    print_stage(out, s, results, readers, values);
+    fprintf(out, s + 1 < STAGE_COUNT ? ",\n" : "\n");
+  }
+  free(values);
+  fprintf(out, "  }\n}\n");
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-r READERS] [-d SECONDS] [-p POLL_US] [-w WAIT_S] "
+          "[-o FILE] SHM_NAME...\n",
+          prog);
+}
+
+int main(int argc, char *argv[]) {
+  int readers = 1, duration_s = 10, poll_us = 200, wait_s = 60;
+  const char *out_path = NULL;
+  ReaderResult *results[MAX_READERS];
+  pid_t pids[MAX_READERS];
+  int opt;
+
+  while ((opt = getopt(argc, argv, "r:d:p:w:o:")) != -1) {
+    switch (opt) {
+    case 'r':
+      readers = atoi(optarg);
+      break;
+    case 'd':
+      duration_s = atoi(optarg);
+      break;
+    case 'p':
+      poll_us = atoi(optarg);
+      break;
+    case 'w':
+      wait_s = atoi(optarg);
+      break;
+    case 'o':
+      out_path = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (optind >= argc || readers < 1 || readers > MAX_READERS ||
+      duration_s < 1 || poll_us < 1 || argc - optind > MAX_SEGMENTS) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  for (int i = optind; i < argc; i++) {
+    if (open_segment(&segments[segment_count], argv[i], wait_s) != 0)
+      return EXIT_FAILURE;
+    segment_count++;
+  }
+
+  // Читатели — отдельные процессы, как клиенты демона
+  uint64_t deadline = now_ns() + (uint64_t)duration_s * 1000000000ull;
+  for (int r = 0; r < readers; r++) {
+    results[r] = mmap(NULL, sizeof(ReaderResult), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results[r] == MAP_FAILED) {
+      perror("mmap failed");
+      return EXIT_FAILURE;
+    }
+    pids[r] = fork();
+    if (pids[r] < 0) {
+      perror("fork failed");
+      return EXIT_FAILURE;
+    }
+    if (pids[r] == 0) {
+      run_reader(results[r], deadline, poll_us);
+      _exit(EXIT_SUCCESS);
+    }
+  }
+  for (int r = 0; r < readers; r++)
+    waitpid(pids[r], NULL, 0);
+
+  FILE *out = stdout;
+  if (out_path && !(out = fopen(out_path, "w"))) {
+    perror("Failed to open output file");
+    return EXIT_FAILURE;
+  }
+  print_report(out, results, readers, duration_s, poll_us);
+  if (out != stdout)
+    fclose(out);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+#!/bin/bash
+
+# Замер задержки демона: background_ranging_sim на модели шины (или
+# воспроизведение записи) и N читателей bench_latency. Параметры — через
+# переменные окружения:
+#   SENSORS=4 TYPE=l5cx      число и тип моделей датчиков (l5cx или l1x)
+#   READERS=2 DURATION=10    число процессов-читателей и длительность, с
+#   POLL_US=200              интервал опроса сегментов читателем
+#   REPLAY=file NAMES="a b"  воспроизвести запись вместо симулятора, NAMES —
+#                            имена shared memory из записи
+#   OUT=bench_latency.json   файл с результатом
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+SENSORS=${SENSORS:-4}
+TYPE=${TYPE:-l5cx}
+READERS=${READERS:-2}
+DURATION=${DURATION:-10}
+POLL_US=${POLL_US:-200}
+OUT=${OUT:-bench_latency.json}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ -n "$REPLAY" ]; then
+    if [ -z "$NAMES" ]; then
+        echo "REPLAY требует NAMES (имена shared memory из записи)" >&2
+        exit 1
+    fi
+    REPLAY=$(realpath "$REPLAY")
+    DAEMON_ARGS="--replay $REPLAY"
+else
+    # Конфигурация симулятора: свои XSHUT и адрес у каждой модели
+    NAMES=""
+    for i in $(seq 0 $((SENSORS - 1))); do
+        NAME="bench_${TYPE}_$i"
+        printf "%s %d 0x%02x %s\n" "$TYPE" $((2 + i)) $((0x30 + i)) "$NAME" \
+            >> "$WORK/sensors_config.txt"
+        NAMES="$NAMES $NAME"
+    done
+    DAEMON_ARGS=""
+fi
+
+# Демон читает ./sensors_config.txt, поэтому запускается из $WORK
+(cd "$WORK" && exec "$ROOT/background_ranging_sim" $DAEMON_ARGS) \
+    > "$WORK/daemon.log" 2>&1 &
+DAEMON_PID=$!
+
+"$ROOT/bench_latency" -r "$READERS" -d "$DURATION" -p "$POLL_US" \
+    -o "$OUT" $NAMES
+STATUS=$?
+
+kill -TERM "$DAEMON_PID" 2>/dev/null
+wait "$DAEMON_PID"
+
+if [ $STATUS -ne 0 ]; then
+    echo "bench_latency завершился с ошибкой, журнал демона:" >&2
+    tail -n 20 "$WORK/daemon.log" >&2
+    exit $STATUS
+fi
+cat "$OUT"
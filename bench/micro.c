@@ -0,0 +1,246 @@
+// Микробенчмарки горячего пути без датчиков: разбор кадра VL53L5CX,
+// перестановка байт, декодирование результата VL53L1X, публикация в shared
+// memory и чтение сегмента клиентом. Кадры VL53L5CX снимаются с модели
+// симулятора через драйвер, как на настоящей шине. Результат — нс на кадр
+// и кадров в секунду на одно ядро.
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <VL53L1X_api.h>
+#include <sim_bus.h>
+#include <vl53l5cx_api.h>
+
+#include "shm_layout.h"
+
+// Выходы VL53L5CX, которые демон включает по умолчанию
+#define L5CX_DEFAULT_OUTPUTS                                                   \
+  (VL53L5CX_OUTPUT_DISTANCE_MM | VL53L5CX_OUTPUT_TARGET_STATUS |               \
+   VL53L5CX_OUTPUT_NB_TARGET_DETECTED)
+
+// Минимальное время одного замера
+#define BENCH_MIN_NS 300000000ull
+
+typedef struct {
+  const char *name;
+  uint64_t iterations;
+  double ns_per_frame;
+} BenchResult;
+
+static BenchResult results[16];
+static int result_count = 0;
+
+// Приёмник результатов: не даёт компилятору выбросить измеряемый код
+static volatile uint32_t sink;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Замер fn: число итераций удваивается, пока замер не займёт BENCH_MIN_NS
+static void run_bench(const char *name, void (*fn)(void *), void *arg) {
+  uint64_t iterations = 1, elapsed;
+
+  for (;;) {
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++)
+      fn(arg);
+    elapsed = now_ns() - start;
+    if (elapsed >= BENCH_MIN_NS)
+      break;
+    iterations *= 2;
+  }
+
+  BenchResult *r = &results[result_count++];
+  r->name = name;
+  r->iterations = iterations;
+  r->ns_per_frame = (double)elapsed / iterations;
+  printf("%-28s %10llu %12.1f %14.0f\n", name, (unsigned long long)iterations,
+         r->ns_per_frame, 1e9 / r->ns_per_frame);
+}
+
+// Кадр VL53L5CX 8x8 с модели симулятора: драйвер загружает модель, задаёт
+// выходы и читает первый кадр. Модель на 0x29 выключается после съёмки
+typedef struct {
+  VL53L5CX_Configuration dev;
+  uint8_t frame[VL53L5CX_TEMPORARY_BUFFER_SIZE];
+  VL53L5CX_ResultsData results;
+} L5cxBench;
+
+static int capture_l5cx_frame(L5cxBench *b, uint32_t outputs, int pin) {
+  uint8_t ready = 0;
+
+  memset(b, 0, sizeof(*b));
+  if (sim_add_sensor(SIM_SENSOR_L5CX, pin) < 0)
+    return -1;
+  b->dev.platform.address = SIM_DEFAULT_ADDR << 1;
+  vl53l5cx_comms_attach(&b->dev.platform, sim_bus_transfer, NULL);
+  if (vl53l5cx_init(&b->dev) || vl53l5cx_set_output_mask(&b->dev, outputs) ||
+      vl53l5cx_set_resolution(&b->dev, 64) ||
+      vl53l5cx_set_ranging_frequency_hz(&b->dev, 15) ||
+      vl53l5cx_start_ranging(&b->dev))
+    return -1;
+
+  while (!ready) {
+    usleep(5000);
+    if (vl53l5cx_check_data_ready(&b->dev, &ready))
+      return -1;
+  }
+  if (VL53L5CX_RdMulti(&b->dev.platform, 0, b->frame, b->dev.data_read_size))
+    return -1;
+  vl53l5cx_stop_ranging(&b->dev);
+  sim_gpio_write(pin, 0);
+  return 0;
+}
+
+// Разбор кадра как в демоне: копия сырого кадра в temp_buffer и декодирование
+static void bench_l5cx_decode(void *arg) {
+  L5cxBench *b = arg;
+  memcpy(b->dev.temp_buffer, b->frame, b->dev.data_read_size);
+  vl53l5cx_decode_ranging_data(&b->dev, &b->results);
+  sink = b->results.distance_mm[63];
+}
+
+static void bench_swap_buffer(void *arg) {
+  L5cxBench *b = arg;
+  VL53L5CX_SwapBuffer(b->frame, (uint16_t)b->dev.data_read_size);
+  sink = b->frame[0];
+}
+
+static void bench_l1x_decode(void *arg) {
+  VL53L1X_Result_t result;
+  VL53L1X_DecodeResult(arg, &result);
+  sink = result.Distance;
+}
+
+// Сегмент shared memory, как у демона
+typedef struct {
+  char name[64];
+  SensorData *data;
+  FrameInfo frame;
+  uint16_t distances[64];
+  uint8_t statuses[64];
+} ShmBench;
+
+static int open_shm(ShmBench *b) {
+  snprintf(b->name, sizeof(b->name), "/bench_micro_%d", (int)getpid());
+
+  int fd = shm_open(b->name, O_CREAT | O_RDWR, 0600);
+  if (fd < 0 || ftruncate(fd, sizeof(SensorData)) != 0)
+    return -1;
+  b->data = mmap(NULL, sizeof(SensorData), PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fd, 0);
+  close(fd);
+  if (b->data == MAP_FAILED)
+    return -1;
+
+  for (int i = 0; i < 64; i++) {
+    b->distances[i] = 300 + 8 * i;
+    b->statuses[i] = 5;
+  }
+  return 0;
+}
+
+static void close_shm(ShmBench *b) {
+  munmap(b->data, sizeof(SensorData));
+  shm_unlink(b->name);
+}
+
+// write_matrix_to_shm(): матрица 8x8 и блок frame под seqlock
+static void bench_shm_write(void *arg) {
+  ShmBench *b = arg;
+  shm_write_begin(b->data);
+  shm_fill_matrix(b->data, 1, b->distances, b->statuses, 64);
+  shm_publish_frame(b->data, &b->frame, now_ns());
+  shm_write_end(b->data);
+}
+
+// Читатель на C: снимок сегмента (seqlock) и разбор матрицы
+static void bench_shm_read(void *arg) {
+  ShmBench *b = arg;
+  SensorData snap;
+  uint16_t distances[64];
+  uint8_t statuses[64];
+
+  shm_read_snapshot(b->data, &snap);
+
+  uint8_t n = snap.resolution > 64 ? 64 : snap.resolution;
+  memcpy(distances, snap.data.matrix.distances, n * sizeof(*distances));
+  memcpy(statuses, snap.data.matrix.statuses, n);
+  sink = distances[n - 1] + statuses[n - 1];
+}
+
+static void print_json(FILE *out) {
+  fprintf(out, "{\n  \"benchmarks\": {\n");
+  for (int i = 0; i < result_count; i++) {
+    fprintf(out,
+            "    \"%s\": {\"iterations\": %llu, \"ns_per_frame\": %.1f, "
+            "\"frames_per_s\": %.0f}%s\n",
+            results[i].name, (unsigned long long)results[i].iterations,
+            results[i].ns_per_frame, 1e9 / results[i].ns_per_frame,
+            i + 1 < result_count ? "," : "");
+  }
+  fprintf(out, "  }\n}\n");
+}
+
+int main(int argc, char *argv[]) {
+  static L5cxBench l5cx_default, l5cx_all;
+  static ShmBench shm;
+  const char *json_path = NULL;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "j:")) != -1) {
+    if (opt != 'j') {
+      fprintf(stderr, "Usage: %s [-j FILE]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+    json_path = optarg;
+  }
+
+  if (capture_l5cx_frame(&l5cx_default, L5CX_DEFAULT_OUTPUTS, 1) != 0 ||
+      capture_l5cx_frame(&l5cx_all, VL53L5CX_OUTPUT_ALL, 2) != 0) {
+    fprintf(stderr, "Failed to capture VL53L5CX frames from the simulator\n");
+    return EXIT_FAILURE;
+  }
+  if (open_shm(&shm) != 0) {
+    perror("Failed to create benchmark shared memory");
+    return EXIT_FAILURE;
+  }
+
+  // Блок результатов VL53L1X: статус 9 (корректно), 1234 мм
+  uint8_t l1x_raw[VL53L1X_RESULT_SIZE] = {9, 0, 0, 16, 0, 0, 0, 0, 20,
+                                          0, 0, 0, 0, 0x04, 0xD2, 0x04, 0xB0};
+
+  printf("VL53L5CX 8x8 frame: %u bytes (default outputs), %u bytes (all)\n",
+         (unsigned)l5cx_default.dev.data_read_size,
+         (unsigned)l5cx_all.dev.data_read_size);
+  printf("%-28s %10s %12s %14s\n", "benchmark", "iterations", "ns/frame",
+         "frames/s/core");
+  run_bench("l5cx_decode_default", bench_l5cx_decode, &l5cx_default);
+  run_bench("l5cx_decode_all", bench_l5cx_decode, &l5cx_all);
+  run_bench("l5cx_swap_buffer_default", bench_swap_buffer, &l5cx_default);
+  run_bench("l5cx_swap_buffer_all", bench_swap_buffer, &l5cx_all);
+  run_bench("l1x_decode_result", bench_l1x_decode, l1x_raw);
+  run_bench("shm_write_matrix", bench_shm_write, &shm);
+  run_bench("shm_read_matrix", bench_shm_read, &shm);
+  close_shm(&shm);
+
+  if (json_path) {
+    FILE *out = fopen(json_path, "w");
+    if (!out) {
+      perror("Failed to open JSON file");
+      return EXIT_FAILURE;
+    }
+    print_json(out);
+    fclose(out);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Микробенчмарк разбора SensorData в read_sensors.py (матрица 8x8 и одиночное
+измерение). Вывод в том же формате, что и bench_micro
+Запуск: python3 bench/micro_read.py
+"""
+
+import os
+import struct
+import sys
+import time
+import types
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+# Для разбора семафоры не нужны: без posix_ipc подставляется пустой модуль
+try:
+    import posix_ipc  # noqa: F401
+except ImportError:
+    sys.modules["posix_ipc"] = types.ModuleType("posix_ipc")
+
+from read_sensors import SensorData  # noqa: E402
+
+# Минимальное время одного замера, с
+BENCH_MIN_S = 0.3
+
+
+def run_bench(name, data):
+    iterations = 1
+    while True:
+        start = time.perf_counter_ns()
+        for _ in range(iterations):
+            SensorData(data)
+        elapsed = time.perf_counter_ns() - start
+        if elapsed >= BENCH_MIN_S * 1e9:
+            break
+        iterations *= 2
+    ns_per_frame = elapsed / iterations
+    print(f"{name:<28} {iterations:>10} {ns_per_frame:>12.1f} {1e9 / ns_per_frame:>14.0f}")
+
+
+def main():
+    # Сегмент формата версии 2: заголовок, матрица 8x8, блок FrameInfo
+    # и счётчик seqlock
+    matrix = struct.pack("<IBBBB", int(time.time()), 1, 64, 1, 2)
+    matrix += struct.pack("<64H", *[300 + 8 * i for i in range(64)])
+    matrix += struct.pack("<64B", *[5] * 64)
+    matrix += bytes(40 + 8)
+
+    single = struct.pack("<IBBBB", int(time.time()), 0, 1, 0, 2)
+    single += struct.pack("<HB5x", 1234, 0) + bytes(184 + 40 + 8)
+
+    print(f"{'benchmark':<28} {'iterations':>10} {'ns/frame':>12} {'frames/s/core':>14}")
+    run_bench("python_decode_matrix", matrix)
+    run_bench("python_decode_single", single)
+
+
+if __name__ == "__main__":
+    main()
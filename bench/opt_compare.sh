@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# Сравнение сборок демона на одном цикле кадров: каждая RUNS раз
+# воспроизводит запись без пауз (REPEAT проходов за запуск), в таблице —
+# медиана и минимум мкс на кадр и ускорение относительно первой сборки.
+# Результат также в OUT (JSON).
+# Запуск: bench/opt_compare.sh ЗАПИСЬ ДЕМОН...
+#   RUNS=15 REPEAT=50 OUT=bench_opt.json
+
+RECORD=$1
+shift
+RUNS=${RUNS:-15}
+REPEAT=${REPEAT:-50}
+OUT=${OUT:-bench_opt.json}
+
+if [ ! -s "$RECORD" ] || [ $# -eq 0 ]; then
+    echo "Usage: $0 RECORD DAEMON..." >&2
+    exit 1
+fi
+
+printf "%-36s %10s %10s %10s %9s\n" "build" "size_KB" "median_us" "min_us" \
+    "speedup"
+BASE=""
+JSON=""
+for DAEMON in "$@"; do
+    # мкс на кадр из итоговой строки --replay
+    US=$(for i in $(seq "$RUNS"); do
+        "$DAEMON" --replay "$RECORD" --fast --repeat "$REPEAT" |
+            sed -n 's/.*, \([0-9.]*\) us\/frame/\1/p'
+    done | sort -g)
+    if [ -z "$US" ]; then
+        echo "$DAEMON: replay failed" >&2
+        exit 1
+    fi
+    MEDIAN=$(echo "$US" | awk '{v[NR] = $1} END {print v[int((NR + 1) / 2)]}')
+    MIN=$(echo "$US" | head -n 1)
+    SIZE=$(($(stat -c %s "$DAEMON") / 1024))
+    [ -z "$BASE" ] && BASE=$MEDIAN
+    SPEEDUP=$(awk -v b="$BASE" -v m="$MEDIAN" 'BEGIN {printf "%.2f", b / m}')
+
+    printf "%-36s %10d %10.2f %10.2f %8sx\n" "$DAEMON" "$SIZE" "$MEDIAN" \
+        "$MIN" "$SPEEDUP"
+    [ -n "$JSON" ] && JSON="$JSON,"
+    JSON="$JSON
+    {\"build\": \"$DAEMON\", \"size_bytes\": $(stat -c %s "$DAEMON"), \
+\"median_us_per_frame\": $MEDIAN, \"min_us_per_frame\": $MIN, \
+\"speedup\": $SPEEDUP}"
+done
+
+printf '{\n  "record": "%s",\n  "runs": %d,\n  "repeat": %d,\n  "builds": [%s\n  ]\n}\n' \
+    "$RECORD" "$RUNS" "$REPEAT" "$JSON" > "$OUT"
@@ -0,0 +1,21 @@
+#!/bin/bash
+
+# Обучение PGO: инструментированный демон воспроизводит запись без пауз
+# (разбор и публикация кадров — горячий путь). Без записи она снимается
+# с симулятора. Запуск: bench/pgo_train.sh ДЕМОН ЗАПИСЬ [ПРОХОДЫ]
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+DAEMON=$1
+RECORD=$2
+RUNS=${3:-20}
+
+if [ -z "$DAEMON" ] || [ -z "$RECORD" ]; then
+    echo "Usage: $0 DAEMON RECORD [PASSES]" >&2
+    exit 1
+fi
+if [ ! -s "$RECORD" ]; then
+    "$ROOT/bench/sim_record.sh" "$RECORD" || exit 1
+fi
+
+"$DAEMON" --replay "$RECORD" --fast --repeat "$RUNS" > /dev/null || exit 1
+echo "PGO: $RUNS passes over $RECORD"
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Запись кадров с моделей симулятора для воспроизведения (обучение PGO,
+# сравнение сборок). Запуск: bench/sim_record.sh ФАЙЛ [СЕКУНДЫ]
+# Параметры — через переменные окружения:
+#   L5CX=4 L1X=2   число моделей VL53L5CX и VL53L1X
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=$1
+SECONDS_TO_RECORD=${2:-10}
+L5CX=${L5CX:-4}
+L1X=${L1X:-2}
+
+if [ -z "$OUT" ]; then
+    echo "Usage: $0 FILE [SECONDS]" >&2
+    exit 1
+fi
+mkdir -p "$(dirname "$OUT")"
+OUT=$(realpath "$OUT")
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Конфигурация симулятора: свои XSHUT и адрес у каждой модели
+for i in $(seq 0 $((L5CX + L1X - 1))); do
+    TYPE=l5cx
+    [ "$i" -ge "$L5CX" ] && TYPE=l1x
+    printf "%s %d 0x%02x rec_%s_%d\n" "$TYPE" $((2 + i)) $((0x30 + i)) \
+        "$TYPE" "$i" >> "$WORK/sensors_config.txt"
+done
+
+# Демон читает ./sensors_config.txt, поэтому запускается из $WORK
+(cd "$WORK" && exec "$ROOT/background_ranging_sim" --record "$OUT") \
+    > "$WORK/daemon.log" 2>&1 &
+DAEMON_PID=$!
+sleep "$SECONDS_TO_RECORD"
+kill -TERM "$DAEMON_PID" 2>/dev/null
+wait "$DAEMON_PID"
+
+if [ ! -s "$OUT" ]; then
+    echo "Запись не создана, журнал симулятора:" >&2
+    tail -n 20 "$WORK/daemon.log" >&2
+    exit 1
+fi
+grep "Recorded" "$WORK/daemon.log"
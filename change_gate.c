@@ -0,0 +1,55 @@
+#include "change_gate.h"
+
+#include <string.h>
+
+void change_gate_init(ChangeGate *gate, const ChangeGateParams *params,
+                      uint8_t sensor_type) {
+  memset(gate, 0, sizeof(*gate));
+  gate->params = *params;
+  gate->sensor_type = sensor_type;
+}
+
+static inline uint8_t status_valid(uint8_t sensor_type, uint8_t status) {
+  return sensor_type == 1 ? (status == 5) | (status == 9) : status == 0;
+}
+
+int change_gate_check(ChangeGate *gate, const uint16_t *distances,
+                      const uint8_t *statuses, uint8_t zones,
+                      uint64_t now_ns) {
+  uint8_t valid[CHANGE_GATE_ZONES];
+  int changed = 0;
+
+  if (zones > CHANGE_GATE_ZONES)
+    zones = CHANGE_GATE_ZONES;
+
+  // Расстояние сравнивается, если зона достоверна сейчас или была раньше
+  for (int i = 0; i < zones; i++) {
+    int diff = (int)distances[i] - gate->distances[i];
+    int moved = (diff > gate->params.threshold_mm) |
+                (-diff > gate->params.threshold_mm);
+    valid[i] = status_valid(gate->sensor_type, statuses[i]);
+    changed += (moved & (valid[i] | gate->valid[i])) |
+               (valid[i] != gate->valid[i]);
+  }
+
+  uint64_t heartbeat_ns = (uint64_t)gate->params.heartbeat_ms * 1000000ull;
+  if (zones == gate->zones && changed < gate->params.min_zones &&
+      now_ns - gate->last_publish_ns < heartbeat_ns)
+    return 0;
+
+  memcpy(gate->distances, distances, zones * sizeof(*distances));
+  memcpy(gate->valid, valid, zones);
+  gate->zones = zones;
+  gate->last_publish_ns = now_ns;
+  return 1;
+}
+
+int change_gate_motion(ChangeGate *gate, int moving, uint64_t now_ns) {
+  uint64_t heartbeat_ns = (uint64_t)gate->params.heartbeat_ms * 1000000ull;
+  if (!moving && gate->last_publish_ns != 0 &&
+      now_ns - gate->last_publish_ns < heartbeat_ns)
+    return 0;
+
+  gate->last_publish_ns = now_ns;
+  return 1;
+}
@@ -0,0 +1,56 @@
+#ifndef CHANGE_GATE_H
+#define CHANGE_GATE_H
+
+// Публикация только изменившихся кадров (опция publish=changes в конфиге):
+// кадр уходит в shared memory, если хотя бы в change_zones зонах
+// расстояние изменилось больше чем на change_mm относительно последнего
+// опубликованного кадра или зона стала достоверной либо недостоверной.
+// Без изменений кадр всё равно публикуется раз в heartbeat_ms, чтобы
+// читатели отличали тихую сцену от остановленного демона. Сравнение —
+// один проход по зонам без ветвлений. Режим publish=motion (motion.h)
+// публикует кадры, в которых датчик увидел движение, с тем же heartbeat.
+
+#include <stdint.h>
+
+#define CHANGE_GATE_ZONES 64
+
+#define CHANGE_GATE_DEFAULT_MM 20
+#define CHANGE_GATE_DEFAULT_ZONES 1
+#define CHANGE_GATE_DEFAULT_HEARTBEAT_MS 1000
+
+typedef enum {
+  CHANGE_GATE_OFF,     // publish=all
+  CHANGE_GATE_CHANGES, // publish=changes
+  CHANGE_GATE_MOTION   // publish=motion
+} ChangeGateMode;
+
+typedef struct {
+  ChangeGateMode mode;
+  uint16_t threshold_mm;
+  uint8_t min_zones;
+  uint32_t heartbeat_ms;
+} ChangeGateParams;
+
+typedef struct {
+  ChangeGateParams params;
+  // Как в SensorData: 1 — VL53L5CX (достоверны статусы 5 и 9), иначе
+  // VL53L1X (достоверен статус 0)
+  uint8_t sensor_type;
+  uint8_t zones; // Зон в последнем опубликованном кадре, 0 — ещё не было
+  uint64_t last_publish_ns;
+  uint16_t distances[CHANGE_GATE_ZONES];
+  uint8_t valid[CHANGE_GATE_ZONES];
+} ChangeGate;
+
+void change_gate_init(ChangeGate *gate, const ChangeGateParams *params,
+                      uint8_t sensor_type);
+
+// 1 — кадр публикуется и становится образцом для следующих, 0 — пропуск
+int change_gate_check(ChangeGate *gate, const uint16_t *distances,
+                      const uint8_t *statuses, uint8_t zones,
+                      uint64_t now_ns);
+
+// publish=motion: 1 — в кадре есть движение или пора heartbeat
+int change_gate_motion(ChangeGate *gate, int moving, uint64_t now_ns);
+
+#endif
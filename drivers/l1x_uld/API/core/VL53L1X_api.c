@@ -579,20 +579,27 @@ VL53L1X_ERROR VL53L1X_GetRangeStatus(uint16_t dev, uint8_t *rangeStatus)
 VL53L1X_ERROR VL53L1X_GetResult(uint16_t dev, VL53L1X_Result_t *pResult)
 {
 	VL53L1X_ERROR status = 0;
-	uint8_t Temp[17];
+	uint8_t Temp[VL53L1X_RESULT_SIZE];
+
+	status |= VL53L1_ReadMulti(dev, VL53L1_RESULT__RANGE_STATUS, Temp,
+			VL53L1X_RESULT_SIZE);
+	VL53L1X_DecodeResult(Temp, pResult);
+
+	return status;
+}
+
+void VL53L1X_DecodeResult(const uint8_t *pRaw, VL53L1X_Result_t *pResult)
+{
 	uint8_t RgSt = 255;
 
-	status |= VL53L1_ReadMulti(dev, VL53L1_RESULT__RANGE_STATUS, Temp, 17);
-	RgSt = Temp[0] & 0x1F;
+	RgSt = pRaw[0] & 0x1F;
 	if (RgSt < 24)
 		RgSt = status_rtn[RgSt];
 	pResult->Status = RgSt;
-	pResult->Ambient = (Temp[7] << 8 | Temp[8]) * 8;
-	pResult->NumSPADs = Temp[3];
-	pResult->SigPerSPAD = (Temp[15] << 8 | Temp[16]) * 8;
-	pResult->Distance = Temp[13] << 8 | Temp[14];
-
-	return status;
+	pResult->Ambient = (pRaw[7] << 8 | pRaw[8]) * 8;
+	pResult->NumSPADs = pRaw[3];
+	pResult->SigPerSPAD = (pRaw[15] << 8 | pRaw[16]) * 8;
+	pResult->Distance = pRaw[13] << 8 | pRaw[14];
 }
 
 VL53L1X_ERROR VL53L1X_SetOffset(uint16_t dev, int16_t OffsetValue)
@@ -69,6 +69,8 @@ typedef int8_t VL53L1X_ERROR;
 #define VL53L1_IDENTIFICATION__MODEL_ID                     0x010F
 #define VL53L1_ROI_CONFIG__MODE_ROI_CENTRE_SPAD				0x013E
 
+#define VL53L1X_RESULT_SIZE									17
+
 /****************************************
  * PRIVATE define do not edit
  ****************************************/
@@ -235,6 +237,13 @@ VL53L1X_ERROR VL53L1X_GetRangeStatus(uint16_t dev, uint8_t *rangeStatus);
  */
 VL53L1X_ERROR VL53L1X_GetResult(uint16_t dev, VL53L1X_Result_t *pResult);
 
+/**
+ * @brief This function decodes a result burst of VL53L1X_RESULT_SIZE bytes read
+ * from VL53L1_RESULT__RANGE_STATUS (as done by VL53L1X_GetResult). It allows to
+ * log or replay the raw bytes sent by the sensor
+ */
+void VL53L1X_DecodeResult(const uint8_t *pRaw, VL53L1X_Result_t *pResult);
+
 /**
  * @brief This function programs the offset correction in mm
  * @param OffsetValue:the offset correction value to program in mm
@@ -23,15 +23,43 @@
 #define I2C_DEV_PATH "/dev/i2c-1"
 static int i2c_fd = -1;
 static uint16_t current_addr = 0;
+static VL53L1_BusTransfer bus_transfer = NULL;
+static void *bus_ctx = NULL;
 
+static VL53L1_CommsProfile comms_profile = NULL;
+static void *comms_profile_ctx = NULL;
+
+void VL53L1_SetBusTransfer(VL53L1_BusTransfer transfer, void *ctx) {
+    bus_transfer = transfer;
+    bus_ctx = ctx;
+}
+
+void VL53L1_SetCommsProfile(VL53L1_CommsProfile profile, void *ctx) {
+    comms_profile = profile;
+    comms_profile_ctx = ctx;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Returns the number of system calls done to select dev_addr, -1 on error */
 static int i2c_init(uint16_t dev_addr) {
+    int syscalls = 0;
     if (i2c_fd >= 0 && current_addr == dev_addr) return 0;
-    if (i2c_fd >= 0) close(i2c_fd);
+    if (i2c_fd >= 0) {
+        close(i2c_fd);
+        syscalls++;
+    }
     i2c_fd = open(I2C_DEV_PATH, O_RDWR);
+    syscalls++;
     if (i2c_fd < 0) {
         perror("Failed to open I2C device");
         return -1;
     }
+    syscalls++;
     if (ioctl(i2c_fd, I2C_SLAVE, dev_addr >> 1) < 0) {
         perror("Failed to set I2C address");
         close(i2c_fd);
@@ -39,11 +67,14 @@ static int i2c_init(uint16_t dev_addr) {
         return -1;
     }
     current_addr = dev_addr;
-    return 0;
+    return syscalls;
 }
 
-int8_t VL53L1_WriteMulti(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count) {
-    if (i2c_init(dev) < 0) return -1;
+static int8_t write_multi(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count, uint32_t *syscalls) {
+    if (bus_transfer) return bus_transfer(bus_ctx, dev, index, pdata, count, 1) ? -1 : 0;
+    int selected = i2c_init(dev);
+    if (selected < 0) return -1;
+    *syscalls = selected + 1;
     uint8_t buf[count + 2];
     buf[0] = (index >> 8) & 0xFF;
     buf[1] = index & 0xFF;
@@ -52,14 +83,36 @@ int8_t VL53L1_WriteMulti(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t
     return (ret == (ssize_t)(count + 2)) ? 0 : -1;
 }
 
-int8_t VL53L1_ReadMulti(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count) {
-    if (i2c_init(dev) < 0) return -1;
+static int8_t read_multi(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count, uint32_t *syscalls) {
+    if (bus_transfer) return bus_transfer(bus_ctx, dev, index, pdata, count, 0) ? -1 : 0;
+    int selected = i2c_init(dev);
+    if (selected < 0) return -1;
+    *syscalls = selected + 1;
     uint8_t reg[2] = { (index >> 8) & 0xFF, index & 0xFF };
     if (write(i2c_fd, reg, 2) != 2) return -1;
+    (*syscalls)++;
     ssize_t ret = read(i2c_fd, pdata, count);
     return (ret == (ssize_t)count) ? 0 : -1;
 }
 
+int8_t VL53L1_WriteMulti(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count) {
+    uint32_t syscalls = 0;
+    if (!comms_profile) return write_multi(dev, index, pdata, count, &syscalls);
+    uint64_t start_ns = monotonic_ns();
+    int8_t status = write_multi(dev, index, pdata, count, &syscalls);
+    comms_profile(comms_profile_ctx, dev, index, count, 1, syscalls, status, monotonic_ns() - start_ns);
+    return status;
+}
+
+int8_t VL53L1_ReadMulti(uint16_t dev, uint16_t index, uint8_t *pdata, uint32_t count) {
+    uint32_t syscalls = 0;
+    if (!comms_profile) return read_multi(dev, index, pdata, count, &syscalls);
+    uint64_t start_ns = monotonic_ns();
+    int8_t status = read_multi(dev, index, pdata, count, &syscalls);
+    comms_profile(comms_profile_ctx, dev, index, count, 0, syscalls, status, monotonic_ns() - start_ns);
+    return status;
+}
+
 int8_t VL53L1_WrByte(uint16_t dev, uint16_t index, uint8_t data) {
     return VL53L1_WriteMulti(dev, index, &data, 1);
 }
@@ -31,6 +31,47 @@ typedef struct {
 
 typedef VL53L1_Dev_t *VL53L1_DEV;
 
+/** @brief Bus transfer hook type. dev is the 8-bit I2C address, index the
+ * register. Returns 0 if OK.
+ */
+typedef int32_t (*VL53L1_BusTransfer)(
+		void *ctx,
+		uint16_t      dev,
+		uint16_t      index,
+		uint8_t      *pdata,
+		uint32_t      count,
+		int           write_not_read);
+
+/** @brief VL53L1_SetBusTransfer() definition.\n
+ * Routes all register accesses to transfer instead of /dev/i2c-1 (used by the
+ * software simulator). NULL restores the i2c-dev transport.
+ */
+void VL53L1_SetBusTransfer(
+		VL53L1_BusTransfer transfer,
+		void         *ctx);
+
+/** @brief Profiling hook type, called after each WriteMulti/ReadMulti.
+ * syscalls is the number of system calls done for the transaction (including
+ * reopening /dev/i2c-1 on an address change), elapsed_ns its wall time.
+ */
+typedef void (*VL53L1_CommsProfile)(
+		void *ctx,
+		uint16_t      dev,
+		uint16_t      index,
+		uint32_t      count,
+		int           write_not_read,
+		uint32_t      syscalls,
+		int32_t       status,
+		uint64_t      elapsed_ns);
+
+/** @brief VL53L1_SetCommsProfile() definition.\n
+ * Attaches a profiling hook to all register accesses. NULL disables
+ * profiling; the hook costs nothing when disabled.
+ */
+void VL53L1_SetCommsProfile(
+		VL53L1_CommsProfile profile,
+		void         *ctx);
+
 /** @brief VL53L1_WriteMulti() definition.\n
  * To be implemented by the developer
  */
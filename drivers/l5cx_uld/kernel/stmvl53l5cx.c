@@ -14,12 +14,48 @@
 #include <linux/gpio/consumer.h>
 #include <linux/interrupt.h>
 #include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
 
 
 #define VL53L5CX_COMMS_CHUNK_SIZE 1024
 
 #define ST_TOF_IOCTL_TRANSFER 		_IOWR('a',0x1, struct stmvl53l5cx_comms_struct)
 #define ST_TOF_IOCTL_WAIT_FOR_INTERRUPT	_IO('a',0x2)
+#define ST_TOF_IOCTL_SET_FRAME_SIZE	_IOW('a',0x3, __u32)
+
+/* Frame ring, mapped by userspace: one header page, then nslots slots. Each
+ * slot is a stmvl53l5cx_ring_slot followed by frame_size bytes read from
+ * register 0x0 (the sensor results, not swapped). The driver owns head,
+ * userspace owns tail; a frame is dropped when the ring is full. */
+#define STMVL53L5CX_RING_MAGIC		0x52353543 /* "C55R" */
+#define STMVL53L5CX_MAX_FRAME_SIZE	8192
+
+static unsigned int ring_slots = 8;
+module_param(ring_slots, uint, 0444);
+MODULE_PARM_DESC(ring_slots, "Number of frames in the mmap ring (2-256)");
+
+struct stmvl53l5cx_ring_header {
+	__u32   magic;
+	__u32   ring_size;   /* bytes to map */
+	__u32   slot_offset; /* offset of the first slot */
+	__u32   nslots;
+	__u32   slot_size;
+	__u32   frame_size;
+	__u32   head;        /* written by the driver */
+	__u32   tail;        /* written by userspace */
+	__u32   dropped;
+	__u32   errors;
+};
+
+struct stmvl53l5cx_ring_slot {
+	__u64   timestamp_ns; /* INT edge, CLOCK_MONOTONIC */
+	__u32   seq;
+	__u32   len;
+};
 
 
 struct stmvl53l5cx_drvdata {
@@ -30,6 +66,14 @@ struct stmvl53l5cx_drvdata {
 	atomic_t intr_ready_flag;
 	wait_queue_head_t wq;
 	int dev_num;
+	char devname[16]; /* misc device name, must outlive misc_register() */
+	struct mutex lock; /* reg_buf, shared by ioctl and interrupt thread */
+	void *ring;
+	size_t ring_size;
+	atomic_t ring_maps;
+	uint32_t frame_size; /* 0 : frames are not read by the interrupt thread */
+	uint32_t seq;
+	u64 irq_ts;
 };
 
 struct stmvl53l5cx_comms_struct {
@@ -208,6 +252,99 @@ static int stmvl53l5cx_read_write(struct stmvl53l5cx_drvdata *drvdata, uint16_t
 	return ret;
 }
 
+static int stmvl53l5cx_read_frame(struct stmvl53l5cx_drvdata *drvdata, uint8_t *pdata,
+									uint32_t count)
+{
+	int ret = 0;
+	uint32_t offset = 0, len;
+
+	while (offset < count) {
+		len = min_t(uint32_t, count - offset, VL53L5CX_COMMS_CHUNK_SIZE);
+		ret = stmvl53l5cx_read_regs(drvdata, offset, pdata + offset, len, NULL);
+		if (ret)
+			return ret;
+		offset += len;
+	}
+	return ret;
+}
+
+/* Called with drvdata->lock held */
+static void stmvl53l5cx_ring_push(struct stmvl53l5cx_drvdata *drvdata)
+{
+	struct stmvl53l5cx_ring_header *hdr = drvdata->ring;
+	struct stmvl53l5cx_ring_slot *slot;
+	uint32_t head = hdr->head;
+	uint32_t tail = smp_load_acquire(&hdr->tail);
+
+	if (head - tail >= hdr->nslots) {
+		hdr->dropped++;
+		return;
+	}
+
+	slot = drvdata->ring + hdr->slot_offset + (head % hdr->nslots) * hdr->slot_size;
+	if (stmvl53l5cx_read_frame(drvdata, (uint8_t *)(slot + 1), drvdata->frame_size)) {
+		hdr->errors++;
+		return;
+	}
+	slot->timestamp_ns = drvdata->irq_ts;
+	slot->seq = drvdata->seq++;
+	slot->len = drvdata->frame_size;
+
+	smp_store_release(&hdr->head, head + 1);
+}
+
+static int stmvl53l5cx_ring_setup(struct stmvl53l5cx_drvdata *drvdata, uint32_t frame_size)
+{
+	int ret = 0;
+	struct stmvl53l5cx_ring_header *hdr;
+	uint32_t nslots = clamp_t(uint32_t, ring_slots, 2, 256);
+	uint32_t slot_size;
+	size_t size;
+	void *ring;
+
+	if (frame_size > STMVL53L5CX_MAX_FRAME_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&drvdata->lock);
+	drvdata->frame_size = 0;
+	if (frame_size == 0)
+		goto out;
+
+	slot_size = ALIGN(sizeof(struct stmvl53l5cx_ring_slot) + frame_size, 64);
+	size = PAGE_ALIGN(PAGE_SIZE + (size_t)nslots * slot_size);
+	if (!drvdata->ring || size > drvdata->ring_size) {
+		if (atomic_read(&drvdata->ring_maps)) {
+			ret = -EBUSY;
+			goto out;
+		}
+		ring = vmalloc_user(size);
+		if (!ring) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		vfree(drvdata->ring);
+		drvdata->ring = ring;
+		drvdata->ring_size = size;
+	}
+
+	hdr = drvdata->ring;
+	hdr->magic = STMVL53L5CX_RING_MAGIC;
+	hdr->ring_size = drvdata->ring_size;
+	hdr->slot_offset = PAGE_SIZE;
+	hdr->nslots = nslots;
+	hdr->slot_size = slot_size;
+	hdr->frame_size = frame_size;
+	hdr->head = 0;
+	hdr->tail = 0;
+	hdr->dropped = 0;
+	hdr->errors = 0;
+	drvdata->seq = 0;
+	drvdata->frame_size = frame_size;
+out:
+	mutex_unlock(&drvdata->lock);
+	return ret;
+}
+
 static long stmvl53l5cx_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	int ret = 0;
@@ -215,6 +352,7 @@ static long stmvl53l5cx_ioctl(struct file *file, unsigned int cmd, unsigned long
     										struct stmvl53l5cx_drvdata, misc);
 	struct stmvl53l5cx_comms_struct comms_struct = {0};
 	void __user *data_ptr = NULL;
+	__u32 frame_size;
 
 	pr_debug("stmvl53l5cx_ioctl : cmd = %u\n", cmd);
 	switch (cmd) {
@@ -234,6 +372,7 @@ static long stmvl53l5cx_ioctl(struct file *file, unsigned int cmd, unsigned long
 				return -EINVAL;
 			}
 			pr_debug("[0x%x,%d,%d]\n", comms_struct.reg_index, comms_struct.len, comms_struct.write_not_read);
+			mutex_lock(&drvdata->lock);
 			if (!comms_struct.write_not_read) {
 				data_ptr = (u8 __user *)(uintptr_t)(comms_struct.bufptr);
 				ret = stmvl53l5cx_read_write(drvdata, comms_struct.reg_index, data_ptr,
@@ -243,11 +382,21 @@ static long stmvl53l5cx_ioctl(struct file *file, unsigned int cmd, unsigned long
 				ret = stmvl53l5cx_read_write(drvdata, comms_struct.reg_index, (char *)(uintptr_t)comms_struct.bufptr,
 										comms_struct.len, comms_struct.write_not_read);
 			}
+			mutex_unlock(&drvdata->lock);
 			if (ret) {
 				pr_err("%s:%d err[%d]\n", __func__, __LINE__, ret);
 				return -EFAULT;
 			}
 			break;
+		case ST_TOF_IOCTL_SET_FRAME_SIZE:
+			if (copy_from_user(&frame_size, (void __user *)arg, sizeof(frame_size)))
+				return -EFAULT;
+			ret = stmvl53l5cx_ring_setup(drvdata, frame_size);
+			if (ret) {
+				pr_err("%s:%d err[%d]\n", __func__, __LINE__, ret);
+				return ret;
+			}
+			break;
 
 		default:
 			return -EINVAL;
@@ -263,18 +412,106 @@ static long stmvl53l5cx_compat_ioctl(struct file *file, unsigned int cmd, unsign
 }
 #endif
 
+static void stmvl53l5cx_vm_open(struct vm_area_struct *vma)
+{
+	struct stmvl53l5cx_drvdata *drvdata = vma->vm_private_data;
+	atomic_inc(&drvdata->ring_maps);
+}
+
+static void stmvl53l5cx_vm_close(struct vm_area_struct *vma)
+{
+	struct stmvl53l5cx_drvdata *drvdata = vma->vm_private_data;
+	atomic_dec(&drvdata->ring_maps);
+}
+
+static const struct vm_operations_struct stmvl53l5cx_vm_ops = {
+	.open			= stmvl53l5cx_vm_open,
+	.close			= stmvl53l5cx_vm_close,
+};
+
+static int stmvl53l5cx_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	int ret = 0;
+	struct stmvl53l5cx_drvdata *drvdata = container_of(file->private_data,
+    										struct stmvl53l5cx_drvdata, misc);
+
+	mutex_lock(&drvdata->lock);
+	if (!drvdata->ring || vma->vm_pgoff != 0 ||
+			vma->vm_end - vma->vm_start > drvdata->ring_size) {
+		ret = -EINVAL;
+	}
+	else {
+		ret = remap_vmalloc_range(vma, drvdata->ring, 0);
+	}
+	if (ret == 0) {
+		vma->vm_private_data = drvdata;
+		vma->vm_ops = &stmvl53l5cx_vm_ops;
+		atomic_inc(&drvdata->ring_maps);
+	}
+	mutex_unlock(&drvdata->lock);
+	return ret;
+}
+
+static __poll_t stmvl53l5cx_poll(struct file *file, poll_table *wait)
+{
+	__poll_t mask = 0;
+	struct stmvl53l5cx_drvdata *drvdata = container_of(file->private_data,
+    										struct stmvl53l5cx_drvdata, misc);
+	struct stmvl53l5cx_ring_header *hdr;
+
+	poll_wait(file, &drvdata->wq, wait);
+
+	mutex_lock(&drvdata->lock);
+	hdr = drvdata->ring;
+	if (hdr && drvdata->frame_size &&
+			smp_load_acquire(&hdr->head) != READ_ONCE(hdr->tail))
+		mask |= EPOLLIN | EPOLLRDNORM;
+	mutex_unlock(&drvdata->lock);
+
+	return mask;
+}
+
+static int stmvl53l5cx_release(struct inode *inode, struct file *file)
+{
+	struct stmvl53l5cx_drvdata *drvdata = container_of(file->private_data,
+    										struct stmvl53l5cx_drvdata, misc);
+
+	/* Stop reading frames when userspace goes away, the ring is kept */
+	mutex_lock(&drvdata->lock);
+	drvdata->frame_size = 0;
+	mutex_unlock(&drvdata->lock);
+	return 0;
+}
+
 static const struct file_operations stmvl53l5cx_fops = {
 	.owner 			= THIS_MODULE,
 	.unlocked_ioctl		= stmvl53l5cx_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl		= stmvl53l5cx_compat_ioctl,
 #endif
+	.mmap			= stmvl53l5cx_mmap,
+	.poll			= stmvl53l5cx_poll,
+	.release		= stmvl53l5cx_release,
 };
 
-/* Interrupt handler */
+/* Primary interrupt handler: timestamp of the INT edge */
+static irqreturn_t stmvl53l5cx_intr_top(int irq, void *dev_id)
+{
+	struct stmvl53l5cx_drvdata *drvdata = (struct stmvl53l5cx_drvdata *)dev_id;
+	drvdata->irq_ts = ktime_get_ns();
+	return IRQ_WAKE_THREAD;
+}
+
+/* Interrupt handler: reads the frame into the ring when it is enabled */
 static irqreturn_t stmvl53l5cx_intr_handler(int irq, void *dev_id)
 {
 	struct stmvl53l5cx_drvdata *drvdata = (struct stmvl53l5cx_drvdata *)dev_id;
+
+	mutex_lock(&drvdata->lock);
+	if (drvdata->ring && drvdata->frame_size)
+		stmvl53l5cx_ring_push(drvdata);
+	mutex_unlock(&drvdata->lock);
+
 	atomic_set(&drvdata->intr_ready_flag, 1);
 	wake_up_interruptible(&drvdata->wq);
 	return IRQ_HANDLED;
@@ -306,7 +543,7 @@ static int stmvl53l5cx_parse_dt(struct device *dev, struct stmvl53l5cx_drvdata *
 	}
 
 	init_waitqueue_head(&drvdata->wq);
-	ret = devm_request_threaded_irq(dev, drvdata->irq, NULL,
+	ret = devm_request_threaded_irq(dev, drvdata->irq, stmvl53l5cx_intr_top,
 			stmvl53l5cx_intr_handler, IRQF_TRIGGER_FALLING | IRQF_ONESHOT, "vl53l5cx_intr", drvdata);
 	if (ret) {
 		dev_err(dev, "failed to register plugin det irq (%d)\n", ret);
@@ -327,7 +564,6 @@ static int stmvl53l5cx_detect(struct stmvl53l5cx_drvdata *drvdata)
 {
 	int ret = 0;
 	uint8_t page = 0, revision_id = 0, device_id = 0;
-	char devname[16];
 
 	ret = stmvl53l5cx_write_regs(drvdata, 0x7FFF, &page, 1, NULL);
 	ret |= stmvl53l5cx_read_regs(drvdata, 0x00, &device_id, 1, NULL);
@@ -343,8 +579,8 @@ static int stmvl53l5cx_detect(struct stmvl53l5cx_drvdata *drvdata)
 	drvdata->misc.name = "stmvl53l5cx";
 	drvdata->misc.fops = &stmvl53l5cx_fops;
 	if (drvdata->dev_num >= 0) {
-		snprintf(devname, sizeof(devname), "stmvl53l5cx%d", drvdata->dev_num);
-		drvdata->misc.name = devname;		
+		snprintf(drvdata->devname, sizeof(drvdata->devname), "stmvl53l5cx%d", drvdata->dev_num);
+		drvdata->misc.name = drvdata->devname;
 	}
 	
 	ret = misc_register(&drvdata->misc);
@@ -365,6 +601,8 @@ static int stmvl53l5cx_i2c_probe(struct i2c_client *client, const struct i2c_dev
 		 return -ENOMEM;
 
 	drvdata->client = client;
+	mutex_init(&drvdata->lock);
+	atomic_set(&drvdata->ring_maps, 0);
 
 	pr_info("%s: i2c name=%s, addr=0x%x\n", __func__, client->adapter->name, client->addr);
 
@@ -398,6 +636,12 @@ static void stmvl53l5cx_i2c_remove(struct i2c_client *client)
 	}
 	else {
 		misc_deregister(&drvdata->misc);
+
+		mutex_lock(&drvdata->lock);
+		drvdata->frame_size = 0;
+		vfree(drvdata->ring);
+		drvdata->ring = NULL;
+		mutex_unlock(&drvdata->lock);
 	}
 
 	#if KERNEL_VERSION(6, 1, 0) > LINUX_VERSION_CODE
@@ -142,8 +142,8 @@ int example1(VL53L5CX_Configuration *p_dev)
 			{
 				printf("Zone : %3d, Status : %3u, Distance : %4d mm\n",
 					i,
-					Results.target_status[VL53L5CX_NB_TARGET_PER_ZONE*i],
-					Results.distance_mm[VL53L5CX_NB_TARGET_PER_ZONE*i]);
+					Results.target_status[p_dev->nb_target_per_zone*i],
+					Results.distance_mm[p_dev->nb_target_per_zone*i]);
 			}
 			printf("\n");
 			loop++;
@@ -113,10 +113,18 @@ int example5(VL53L5CX_Configuration *p_dev)
 	/*********************************/
 
 	/* Each zone can output between 1 and 4 targets. By default the output
-	 * is set to 1 targets, but user can change it using macro
-	 * VL53L5CX_NB_TARGET_PER_ZONE located in file 'platform.h'.
+	 * is set to 1 targets, but user can change it using function
+	 * vl53l5cx_set_nb_targets(), up to macro VL53L5CX_NB_TARGET_PER_ZONE
+	 * located in file 'platform.h'.
 	 */
 
+	status = vl53l5cx_set_nb_targets(p_dev, VL53L5CX_NB_TARGET_PER_ZONE);
+	if(status)
+	{
+		printf("vl53l5cx_set_nb_targets failed, status %u\n", status);
+		return status;
+	}
+
 	/*********************************/
 	/*         Ranging loop          */
 	/*********************************/
@@ -148,10 +156,10 @@ int example5(VL53L5CX_Configuration *p_dev)
 					(int)Results.ambient_per_spad[i],
 					(int)Results.nb_spads_enabled[i]);
 
-				for(j = 0; j < VL53L5CX_NB_TARGET_PER_ZONE; j++)
+				for(j = 0; j < p_dev->nb_target_per_zone; j++)
 				{
 					/* Print per target results. These results depends of the target nb */
-					uint16_t idx = VL53L5CX_NB_TARGET_PER_ZONE * i + j;
+					uint16_t idx = p_dev->nb_target_per_zone * i + j;
 					printf("Target[%1u] : %2u, %4d, %6d, %3u, ",
 						j,
 						Results.target_status[idx],
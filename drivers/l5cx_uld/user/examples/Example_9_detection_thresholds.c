@@ -207,9 +207,9 @@ int example9(VL53L5CX_Configuration *p_dev)
 			{
 				printf("Zone : %3d, Status : %3u, Distance : %4d mm, Signal : %5d kcps/SPADs\n",
 					i,
-					Results.target_status[VL53L5CX_NB_TARGET_PER_ZONE*i],
-					Results.distance_mm[VL53L5CX_NB_TARGET_PER_ZONE*i],
-					(int)Results.signal_per_spad[VL53L5CX_NB_TARGET_PER_ZONE*i]);
+					Results.target_status[p_dev->nb_target_per_zone*i],
+					Results.distance_mm[p_dev->nb_target_per_zone*i],
+					(int)Results.signal_per_spad[p_dev->nb_target_per_zone*i]);
 			}
 			printf("\n");
 			loop++;
@@ -11,6 +11,7 @@
   */
 
 #include <fcntl.h> // open()
+#include <pthread.h> // pthread_mutex_lock()
 #include <unistd.h> // close()
 #include <time.h> // clock_gettime()
 
@@ -18,6 +19,8 @@
 #include <linux/i2c-dev.h>
 
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <poll.h>
 
 #include "platform.h"
 #include "types.h"
@@ -34,9 +37,13 @@
 
 #define LOG 				printf
 
-#ifndef STMVL53L5CX_KERNEL
+/* Register address and payload of i2c-dev transfers are staged in a single
+ * buffer shared by all sensors. Sensors read by their own threads (INT line)
+ * and the polling loop transfer concurrently, so i2c-dev transfers are
+ * serialized by i2c_bus_lock */
 static uint8_t i2c_buffer[VL53L5CX_COMMS_CHUNK_SIZE];
-#else
+static pthread_mutex_t i2c_bus_lock = PTHREAD_MUTEX_INITIALIZER;
+
 struct comms_struct {
 	uint16_t   len;
 	uint16_t   reg_address;
@@ -44,55 +51,85 @@ struct comms_struct {
 	uint8_t    padding[3]; /* 64bits alignment */
 	uint64_t   bufptr;
 };
-#endif
 
 #define ST_TOF_IOCTL_TRANSFER           _IOWR('a',0x1, struct comms_struct)
 #define ST_TOF_IOCTL_WAIT_FOR_INTERRUPT	_IO('a',0x2)
+#define ST_TOF_IOCTL_SET_FRAME_SIZE	_IOW('a',0x3, uint32_t)
 
-int32_t vl53l5cx_comms_init(VL53L5CX_Platform * p_platform)
+int32_t vl53l5cx_comms_open(
+		VL53L5CX_Platform * p_platform,
+		uint8_t transport,
+		const char *dev_path)
 {
-
-#ifdef STMVL53L5CX_KERNEL
-	p_platform->fd = open("/dev/stmvl53l5cx", O_RDONLY);
+	p_platform->transport = transport;
+	p_platform->bus_transfer = NULL;
+	p_platform->comms_profile = NULL;
+	p_platform->comms_profile_ctx = NULL;
+	p_platform->ring = NULL;
+	p_platform->fd = open(dev_path, O_RDONLY);
 	if (p_platform->fd == -1) {
-		LOG("Failed to open /dev/stmvl53l5cx\n");
+		LOG("Failed to open %s\n", dev_path);
 		return VL53L5CX_COMMS_ERROR;
 	}
+
+	LOG("Opened ST TOF Dev = %d\n", p_platform->fd);
+
+	return 0;
+}
+
+int32_t vl53l5cx_comms_init(VL53L5CX_Platform * p_platform)
+{
+
+#ifdef STMVL53L5CX_KERNEL
+	return vl53l5cx_comms_open(p_platform, VL53L5CX_TRANSPORT_KERNEL,
+			"/dev/stmvl53l5cx");
 #else
 	/* Create sensor at default i2c address */
 	p_platform->address = 0x52;
-	p_platform->fd = open("/dev/i2c-1", O_RDONLY);
-	if (p_platform->fd == -1) {
-		LOG("Failed to open /dev/i2c-1\n");
+	if (vl53l5cx_comms_open(p_platform, VL53L5CX_TRANSPORT_I2C_DEV,
+			"/dev/i2c-1") != 0)
 		return VL53L5CX_COMMS_ERROR;
-	}
 
 	if (ioctl(p_platform->fd, I2C_SLAVE, p_platform->address) <0) {
 		LOG("Could not speak to the device on the i2c bus\n");
 		return VL53L5CX_COMMS_ERROR;
 	}
+
+	return 0;
 #endif
+}
 
-	LOG("Opened ST TOF Dev = %d\n", p_platform->fd);
+int32_t vl53l5cx_comms_attach(
+		VL53L5CX_Platform * p_platform,
+		VL53L5CX_BusTransfer bus_transfer,
+		void *ctx)
+{
+	p_platform->transport = VL53L5CX_TRANSPORT_CUSTOM;
+	p_platform->fd = -1;
+	p_platform->bus_transfer = bus_transfer;
+	p_platform->bus_ctx = ctx;
+	p_platform->comms_profile = NULL;
+	p_platform->comms_profile_ctx = NULL;
+	p_platform->ring = NULL;
 
 	return 0;
 }
 
 int32_t vl53l5cx_comms_close(VL53L5CX_Platform * p_platform)
 {
-	close(p_platform->fd);
+	if (p_platform->fd >= 0)
+		close(p_platform->fd);
+	p_platform->fd = -1;
 	return 0;
 }
 
-int32_t write_read_multi(
+static int32_t kernel_write_read_multi(
 		int fd,
-		uint16_t i2c_address,
 		uint16_t reg_address,
 		uint8_t *pdata,
 		uint32_t count,
 		int write_not_read)
 {
-#ifdef STMVL53L5CX_KERNEL
 	struct comms_struct cs;
 
 	cs.len = count;
@@ -102,8 +139,18 @@ int32_t write_read_multi(
 
 	if (ioctl(fd, ST_TOF_IOCTL_TRANSFER, &cs) < 0)
 		return VL53L5CX_COMMS_ERROR;
-#else
 
+	return 0;
+}
+
+static int32_t i2c_dev_write_read_multi(
+		int fd,
+		uint16_t i2c_address,
+		uint16_t reg_address,
+		uint8_t *pdata,
+		uint32_t count,
+		int write_not_read)
+{
 	struct i2c_rdwr_ioctl_data packets;
 	struct i2c_msg messages[2];
 
@@ -162,28 +209,107 @@ int32_t write_read_multi(
 		} while (position < count);
 	}
 
-#endif
 	return 0;
 }
 
+static int32_t transport_write_read_multi(
+		VL53L5CX_Platform * p_platform,
+		uint16_t reg_address,
+		uint8_t *pdata,
+		uint32_t count,
+		int write_not_read)
+{
+	int32_t status;
+
+	if (p_platform->transport == VL53L5CX_TRANSPORT_KERNEL)
+		return(kernel_write_read_multi(p_platform->fd, reg_address, pdata,
+				count, write_not_read));
+
+	if (p_platform->transport == VL53L5CX_TRANSPORT_CUSTOM)
+		return(p_platform->bus_transfer(p_platform->bus_ctx,
+				p_platform->address, reg_address, pdata, count,
+				write_not_read) ? VL53L5CX_COMMS_ERROR : 0);
+
+	pthread_mutex_lock(&i2c_bus_lock);
+	status = i2c_dev_write_read_multi(p_platform->fd, p_platform->address,
+			reg_address, pdata, count, write_not_read);
+	pthread_mutex_unlock(&i2c_bus_lock);
+	return status;
+}
+
+/* Number of ioctl() done by a transaction of count bytes */
+static uint32_t transport_syscalls(
+		VL53L5CX_Platform * p_platform,
+		uint32_t count,
+		int write_not_read)
+{
+	uint32_t chunk = write_not_read ? VL53L5CX_COMMS_CHUNK_SIZE - 2
+			: VL53L5CX_COMMS_CHUNK_SIZE;
+
+	if (p_platform->transport == VL53L5CX_TRANSPORT_KERNEL)
+		return 1;
+	if (p_platform->transport == VL53L5CX_TRANSPORT_CUSTOM)
+		return 0;
+	return count ? (count + chunk - 1) / chunk : 1;
+}
+
+static uint64_t monotonic_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void vl53l5cx_comms_profile(
+		VL53L5CX_Platform * p_platform,
+		VL53L5CX_CommsProfile comms_profile,
+		void *ctx)
+{
+	p_platform->comms_profile = comms_profile;
+	p_platform->comms_profile_ctx = ctx;
+}
+
+int32_t write_read_multi(
+		VL53L5CX_Platform * p_platform,
+		uint16_t reg_address,
+		uint8_t *pdata,
+		uint32_t count,
+		int write_not_read)
+{
+	uint64_t start_ns;
+	int32_t status;
+
+	if (p_platform->comms_profile == NULL)
+		return(transport_write_read_multi(p_platform, reg_address, pdata,
+				count, write_not_read));
+
+	start_ns = monotonic_ns();
+	status = transport_write_read_multi(p_platform, reg_address, pdata,
+			count, write_not_read);
+	p_platform->comms_profile(p_platform->comms_profile_ctx,
+			p_platform->address, reg_address, count, write_not_read,
+			transport_syscalls(p_platform, count, write_not_read), status,
+			monotonic_ns() - start_ns);
+	return status;
+}
+
 int32_t write_multi(
-		int fd,
-		uint16_t i2c_address,
+		VL53L5CX_Platform * p_platform,
 		uint16_t reg_address,
 		uint8_t *pdata,
 		uint32_t count)
 {
-	return(write_read_multi(fd, i2c_address, reg_address, pdata, count, 1));
+	return(write_read_multi(p_platform, reg_address, pdata, count, 1));
 }
 
 int32_t read_multi(
-		int fd,
-		uint16_t i2c_address,
+		VL53L5CX_Platform * p_platform,
 		uint16_t reg_address,
 		uint8_t *pdata,
 		uint32_t count)
 {
-	return(write_read_multi(fd, i2c_address, reg_address, pdata, count, 0));
+	return(write_read_multi(p_platform, reg_address, pdata, count, 0));
 }
 
 uint8_t VL53L5CX_RdByte(
@@ -191,7 +317,7 @@ uint8_t VL53L5CX_RdByte(
 		uint16_t reg_address,
 		uint8_t *p_value)
 {
-	return(read_multi(p_platform->fd, p_platform->address, reg_address, p_value, 1));
+	return(read_multi(p_platform, reg_address, p_value, 1));
 }
 
 uint8_t VL53L5CX_WrByte(
@@ -199,7 +325,7 @@ uint8_t VL53L5CX_WrByte(
 		uint16_t reg_address,
 		uint8_t value)
 {
-	return(write_multi(p_platform->fd, p_platform->address, reg_address, &value, 1));
+	return(write_multi(p_platform, reg_address, &value, 1));
 }
 
 uint8_t VL53L5CX_RdMulti(
@@ -208,7 +334,7 @@ uint8_t VL53L5CX_RdMulti(
 		uint8_t *p_values,
 		uint32_t size)
 {
-	return(read_multi(p_platform->fd, p_platform->address, reg_address, p_values, size));
+	return(read_multi(p_platform, reg_address, p_values, size));
 }
 
 uint8_t VL53L5CX_WrMulti(
@@ -217,7 +343,7 @@ uint8_t VL53L5CX_WrMulti(
 		uint8_t *p_values,
 		uint32_t size)
 {
-	return(write_multi(p_platform->fd, p_platform->address, reg_address, p_values, size));
+	return(write_multi(p_platform, reg_address, p_values, size));
 }
 
 void VL53L5CX_SwapBuffer(
@@ -249,16 +375,106 @@ uint8_t VL53L5CX_WaitMs(
 
 uint8_t VL53L5CX_wait_for_dataready(VL53L5CX_Platform *p_platform)
 {
-#ifdef STMVL53L5CX_KERNEL
-	if (ioctl(p_platform->fd, ST_TOF_IOCTL_WAIT_FOR_INTERRUPT) < 0)
-		return 0;
-#else
-	VL53L5CX_Configuration * p_dev = (VL53L5CX_Configuration *)(p_platform - offsetof(VL53L5CX_Configuration, platform));
-	uint8_t isReady = 0;
-	do {
-		VL53L5CX_WaitMs(p_platform, 5);
-		vl53l5cx_check_data_ready(p_dev, &isReady);		
-	} while (isReady == 0);
-#endif
+	if (p_platform->transport == VL53L5CX_TRANSPORT_KERNEL) {
+		if (ioctl(p_platform->fd, ST_TOF_IOCTL_WAIT_FOR_INTERRUPT) < 0)
+			return 0;
+	}
+	else {
+		VL53L5CX_Configuration * p_dev = (VL53L5CX_Configuration *)((uint8_t *)p_platform - offsetof(VL53L5CX_Configuration, platform));
+		uint8_t isReady = 0;
+		do {
+			VL53L5CX_WaitMs(p_platform, 5);
+			vl53l5cx_check_data_ready(p_dev, &isReady);		
+		} while (isReady == 0);
+	}
 	return 1;
+}
+
+int32_t vl53l5cx_ring_open(
+		VL53L5CX_Platform * p_platform,
+		uint32_t frame_size)
+{
+	VL53L5CX_RingHeader *p_header;
+	uint32_t ring_size;
+
+	if (p_platform->transport != VL53L5CX_TRANSPORT_KERNEL)
+		return VL53L5CX_COMMS_ERROR;
+
+	if (ioctl(p_platform->fd, ST_TOF_IOCTL_SET_FRAME_SIZE, &frame_size) < 0) {
+		LOG("Frame ring not supported by the kernel module\n");
+		return VL53L5CX_COMMS_ERROR;
+	}
+
+	/* Map the header first, to get the size of the ring */
+	p_header = mmap(NULL, sizeof(VL53L5CX_RingHeader), PROT_READ,
+			MAP_SHARED, p_platform->fd, 0);
+	if (p_header == MAP_FAILED)
+		goto disable;
+	ring_size = p_header->ring_size;
+	if (p_header->magic != VL53L5CX_RING_MAGIC) {
+		munmap(p_header, sizeof(VL53L5CX_RingHeader));
+		goto disable;
+	}
+	munmap(p_header, sizeof(VL53L5CX_RingHeader));
+
+	p_platform->ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, p_platform->fd, 0);
+	if (p_platform->ring == MAP_FAILED) {
+		p_platform->ring = NULL;
+		goto disable;
+	}
+
+	return 0;
+
+disable:
+	frame_size = 0;
+	ioctl(p_platform->fd, ST_TOF_IOCTL_SET_FRAME_SIZE, &frame_size);
+	LOG("Failed to map the frame ring\n");
+	return VL53L5CX_COMMS_ERROR;
+}
+
+int32_t vl53l5cx_ring_close(VL53L5CX_Platform * p_platform)
+{
+	VL53L5CX_RingHeader *p_header = (VL53L5CX_RingHeader *)p_platform->ring;
+	uint32_t frame_size = 0;
+
+	if (p_header == NULL)
+		return 0;
+
+	ioctl(p_platform->fd, ST_TOF_IOCTL_SET_FRAME_SIZE, &frame_size);
+	munmap(p_header, p_header->ring_size);
+	p_platform->ring = NULL;
+	return 0;
+}
+
+uint8_t vl53l5cx_ring_wait(VL53L5CX_Platform * p_platform)
+{
+	struct pollfd pfd;
+
+	pfd.fd = p_platform->fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	if (poll(&pfd, 1, -1) <= 0)
+		return 0;
+	return (pfd.revents & POLLIN) ? 1 : 0;
+}
+
+VL53L5CX_RingSlot *vl53l5cx_ring_peek(VL53L5CX_Platform * p_platform)
+{
+	VL53L5CX_RingHeader *p_header = (VL53L5CX_RingHeader *)p_platform->ring;
+	uint32_t tail = p_header->tail;
+
+	if (__atomic_load_n(&p_header->head, __ATOMIC_ACQUIRE) == tail)
+		return NULL;
+
+	return (VL53L5CX_RingSlot *)((uint8_t *)p_header + p_header->slot_offset
+			+ (tail % p_header->nslots) * p_header->slot_size);
+}
+
+void vl53l5cx_ring_release(VL53L5CX_Platform * p_platform)
+{
+	VL53L5CX_RingHeader *p_header = (VL53L5CX_RingHeader *)p_platform->ring;
+
+	__atomic_store_n(&p_header->tail, p_header->tail + 1, __ATOMIC_RELEASE);
 }
\ No newline at end of file
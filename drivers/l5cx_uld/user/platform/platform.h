@@ -17,6 +17,36 @@
 #include <stdint.h>
 #include <string.h>
 
+/**
+ * @brief Bus transfer hook used by VL53L5CX_TRANSPORT_CUSTOM (e.g. software
+ * simulator). i2c_address is the 8-bit address of the platform.
+ * @return (int32_t) status : 0 if OK
+ */
+
+typedef int32_t (*VL53L5CX_BusTransfer)(
+		void *ctx,
+		uint16_t i2c_address,
+		uint16_t reg_address,
+		uint8_t *pdata,
+		uint32_t count,
+		int write_not_read);
+
+/**
+ * @brief Profiling hook called after each bus transaction, when attached by
+ * vl53l5cx_comms_profile(). syscalls is the number of ioctl() done for the
+ * transaction, elapsed_ns its wall time.
+ */
+
+typedef void (*VL53L5CX_CommsProfile)(
+		void *ctx,
+		uint16_t i2c_address,
+		uint16_t reg_address,
+		uint32_t count,
+		int write_not_read,
+		uint32_t syscalls,
+		int32_t status,
+		uint64_t elapsed_ns);
+
 /**
  * @brief Structure VL53L5CX_Platform needs to be filled by the customer,
  * depending on his platform. At least, it contains the VL53L5CX I2C address.
@@ -35,16 +65,78 @@ typedef struct
 	/* For Linux implementation, file descriptor */
 	int fd;
 
+	/* For Linux implementation, transport used by the descriptor :
+	 * VL53L5CX_TRANSPORT_I2C_DEV, VL53L5CX_TRANSPORT_KERNEL or
+	 * VL53L5CX_TRANSPORT_CUSTOM */
+	uint8_t transport;
+
+	/* For custom transport, hook attached by vl53l5cx_comms_attach() */
+	VL53L5CX_BusTransfer bus_transfer;
+	void *bus_ctx;
+
+	/* Profiling hook attached by vl53l5cx_comms_profile() (NULL if not
+	 * used) */
+	VL53L5CX_CommsProfile comms_profile;
+	void *comms_profile_ctx;
+
+	/* For Linux kernel transport, frame ring mapped by vl53l5cx_ring_open()
+	 * (NULL if not used) */
+	void *ring;
+
 } VL53L5CX_Platform;
 
 /*
- * @brief The macro below is used to define the number of target per zone sent
- * through I2C. This value can be changed by user, in order to tune I2C
- * transaction, and also the total memory size (a lower number of target per
- * zone means a lower RAM). The value must be between 1 and 4.
+ * @brief Transports supported by the Linux platform. VL53L5CX_TRANSPORT_I2C_DEV
+ * uses the raw i2c-dev interface (/dev/i2c-N) and polls for data ready.
+ * VL53L5CX_TRANSPORT_KERNEL uses the stmvl53l5cx kernel module
+ * (/dev/stmvl53l5cx or /dev/stmvl53l5cx<N>), which blocks on the INT line
+ * until data is ready. VL53L5CX_TRANSPORT_CUSTOM routes the accesses to a
+ * user hook and polls for data ready.
  */
 
-#define 	VL53L5CX_NB_TARGET_PER_ZONE		1U
+#define VL53L5CX_TRANSPORT_I2C_DEV		((uint8_t) 0U)
+#define VL53L5CX_TRANSPORT_KERNEL		((uint8_t) 1U)
+#define VL53L5CX_TRANSPORT_CUSTOM		((uint8_t) 2U)
+
+/*
+ * @brief Frame ring of the stmvl53l5cx kernel module. When enabled, the
+ * interrupt thread of the module reads each frame into the ring, with the
+ * timestamp of the INT edge. The layout is shared with the module: one header,
+ * then nslots slots starting at slot_offset. Each slot is a
+ * VL53L5CX_RingSlot followed by the frame (len bytes, not swapped).
+ */
+
+typedef struct
+{
+	uint32_t	magic;
+	uint32_t	ring_size;
+	uint32_t	slot_offset;
+	uint32_t	nslots;
+	uint32_t	slot_size;
+	uint32_t	frame_size;
+	uint32_t	head;		/* Written by the kernel module */
+	uint32_t	tail;		/* Written by the user */
+	uint32_t	dropped;
+	uint32_t	errors;
+} VL53L5CX_RingHeader;
+
+typedef struct
+{
+	uint64_t	timestamp_ns;	/* INT edge, CLOCK_MONOTONIC */
+	uint32_t	seq;
+	uint32_t	len;
+} VL53L5CX_RingSlot;
+
+#define VL53L5CX_RING_MAGIC			((uint32_t) 0x52353543U)
+
+/*
+ * @brief The macro below is used to define the maximum number of target per
+ * zone. Results and temporary buffers are sized for this number, the number
+ * sent through I2C is selected at runtime with vl53l5cx_set_nb_targets() (1 by
+ * default). The value must be between 1 and 4.
+ */
+
+#define 	VL53L5CX_NB_TARGET_PER_ZONE		4U
 
 /*
  * @brief The macro below can be used to avoid data conversion into the driver.
@@ -58,7 +150,8 @@ typedef struct
 /*
  * @brief All macro below are used to configure the sensor output. User can
  * define some macros if he wants to disable selected output, in order to reduce
- * I2C access.
+ * I2C access. Outputs can also be disabled at runtime per sensor, using
+ * function vl53l5cx_set_output_mask().
  */
 
 // #define VL53L5CX_DISABLE_AMBIENT_PER_SPAD
@@ -146,7 +239,9 @@ uint8_t VL53L5CX_Reset_Sensor(
 
 /**
  * @brief This function is used to wait for a new measurement. It can 
- * support both interrupt mode with kernel module and polling mode
+ * support both interrupt mode with kernel module and polling mode, depending
+ * on the transport of the platform. In interrupt mode, the wait can be aborted
+ * by a signal delivered to the calling thread.
  * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
  * structure.
  * @return (uint8_t) status : 1 if data is ready
@@ -177,12 +272,43 @@ uint8_t VL53L5CX_WaitMs(
 		uint32_t TimeMs);
 
 /**
- * @brief I2C communication channel initialization
+ * @brief I2C communication channel initialization, using the transport
+ * selected at compile time (STMVL53L5CX_KERNEL).
  * @param (int) *fd : pointer on a I2C channel descriptor.
  * @return (uint8_t) status : 0 if OK
  */
 int32_t vl53l5cx_comms_init(VL53L5CX_Platform * p_platform);
 
+/**
+ * @brief Communication channel initialization with a transport selected at
+ * runtime. The I2C address must be filled by the user for the i2c-dev
+ * transport; it is not used by the kernel transport.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure.
+ * @param (uint8_t) transport : VL53L5CX_TRANSPORT_I2C_DEV or
+ * VL53L5CX_TRANSPORT_KERNEL.
+ * @param (const char*) dev_path : Device to open, e.g. "/dev/i2c-1" or
+ * "/dev/stmvl53l5cx0".
+ * @return (int32_t) status : 0 if OK
+ */
+int32_t vl53l5cx_comms_open(
+		VL53L5CX_Platform * p_platform,
+		uint8_t transport,
+		const char *dev_path);
+
+/**
+ * @brief Communication channel initialization with a custom transport. No
+ * descriptor is opened, all accesses are given to bus_transfer.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure. The I2C address must be filled by the user.
+ * @param (VL53L5CX_BusTransfer) bus_transfer : Transfer hook.
+ * @param (void*) ctx : Context given to bus_transfer.
+ * @return (int32_t) status : 0 if OK
+ */
+int32_t vl53l5cx_comms_attach(
+		VL53L5CX_Platform * p_platform,
+		VL53L5CX_BusTransfer bus_transfer,
+		void *ctx);
 
 /**
  * @brief I2C communication channel deletion
@@ -191,4 +317,64 @@ int32_t vl53l5cx_comms_init(VL53L5CX_Platform * p_platform);
  */
 int32_t vl53l5cx_comms_close(VL53L5CX_Platform * p_platform);
 
+/**
+ * @brief Attaches a profiling hook to the communication channel, for any
+ * transport. NULL disables profiling; the hook costs nothing when disabled.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure.
+ * @param (VL53L5CX_CommsProfile) comms_profile : Profiling hook.
+ * @param (void*) ctx : Context given to comms_profile.
+ */
+void vl53l5cx_comms_profile(
+		VL53L5CX_Platform * p_platform,
+		VL53L5CX_CommsProfile comms_profile,
+		void *ctx);
+
+/**
+ * @brief Enables the frame ring of the kernel module and maps it. Must be
+ * called after vl53l5cx_start_ranging(), with p_dev->data_read_size.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure, using the kernel transport.
+ * @param (uint32_t) frame_size : Number of bytes read for each frame.
+ * @return (int32_t) status : 0 if OK
+ */
+int32_t vl53l5cx_ring_open(
+		VL53L5CX_Platform * p_platform,
+		uint32_t frame_size);
+
+/**
+ * @brief Disables the frame ring of the kernel module and unmaps it.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure.
+ * @return (int32_t) status : 0 if OK
+ */
+int32_t vl53l5cx_ring_close(VL53L5CX_Platform * p_platform);
+
+/**
+ * @brief Waits until at least one frame is available into the ring. The wait
+ * can be aborted by a signal delivered to the calling thread.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure.
+ * @return (uint8_t) status : 1 if a frame is available
+ */
+uint8_t vl53l5cx_ring_wait(VL53L5CX_Platform * p_platform);
+
+/**
+ * @brief Gets the oldest frame of the ring, without copy. The slot stays valid
+ * until vl53l5cx_ring_release() is called.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure.
+ * @return (VL53L5CX_RingSlot*) slot : Oldest slot, or NULL if the ring is
+ * empty. The frame follows the slot header.
+ */
+VL53L5CX_RingSlot *vl53l5cx_ring_peek(VL53L5CX_Platform * p_platform);
+
+/**
+ * @brief Gives back the slot returned by vl53l5cx_ring_peek() to the kernel
+ * module.
+ * @param (VL53L5CX_Platform*) p_platform : Pointer of VL53L5CX platform
+ * structure.
+ */
+void vl53l5cx_ring_release(VL53L5CX_Platform * p_platform);
+
 #endif	// _PLATFORM_H_
@@ -72,6 +72,24 @@
 #define VL53L5CX_POWER_MODE_SLEEP		((uint8_t) 0U)
 #define VL53L5CX_POWER_MODE_WAKEUP		((uint8_t) 1U)
 
+/**
+ * @brief Macros VL53L5CX_OUTPUT_xxx are used to select at runtime the outputs
+ * streamed by the sensor, using function vl53l5cx_set_output_mask(). Disabling
+ * outputs reduces the size of data read through I2C for each frame. Outputs
+ * disabled in the 'platform.h' file are never streamed.
+ */
+
+#define VL53L5CX_OUTPUT_AMBIENT_PER_SPAD	((uint32_t) 0x008U)
+#define VL53L5CX_OUTPUT_NB_SPADS_ENABLED	((uint32_t) 0x010U)
+#define VL53L5CX_OUTPUT_NB_TARGET_DETECTED	((uint32_t) 0x020U)
+#define VL53L5CX_OUTPUT_SIGNAL_PER_SPAD		((uint32_t) 0x040U)
+#define VL53L5CX_OUTPUT_RANGE_SIGMA_MM		((uint32_t) 0x080U)
+#define VL53L5CX_OUTPUT_DISTANCE_MM		((uint32_t) 0x100U)
+#define VL53L5CX_OUTPUT_REFLECTANCE_PERCENT	((uint32_t) 0x200U)
+#define VL53L5CX_OUTPUT_TARGET_STATUS		((uint32_t) 0x400U)
+#define VL53L5CX_OUTPUT_MOTION_INDICATOR	((uint32_t) 0x800U)
+#define VL53L5CX_OUTPUT_ALL			((uint32_t) 0xFF8U)
+
 /**
  * @brief Macro VL53L5CX_STATUS_OK indicates that VL53L5 sensor has no error.
  * Macro VL53L5CX_STATUS_ERROR indicates that something is wrong (value,
@@ -91,7 +109,7 @@
  * @brief Definitions for Range results block headers
  */
 
-#if VL53L5CX_NB_TARGET_PER_ZONE == 1
+/* Streamed with 1 target per zone */
 
 #define VL53L5CX_START_BH				((uint32_t)0x0000000DU)
 #define VL53L5CX_METADATA_BH			((uint32_t)0x54B400C0U)
@@ -117,31 +135,26 @@
 #define VL53L5CX_TARGET_STATUS_IDX		((uint16_t)0xE084U)
 #define VL53L5CX_MOTION_DETEC_IDX		((uint16_t)0xD858U)
 
-#else
-#define VL53L5CX_START_BH				((uint32_t)0x0000000DU)
-#define VL53L5CX_METADATA_BH			((uint32_t)0x54B400C0U)
-#define VL53L5CX_COMMONDATA_BH			((uint32_t)0x54C00040U)
-#define VL53L5CX_AMBIENT_RATE_BH		((uint32_t)0x54D00104U)
-#define VL53L5CX_NB_TARGET_DETECTED_BH	((uint32_t)0x57D00401U)
-#define VL53L5CX_SPAD_COUNT_BH			((uint32_t)0x55D00404U)
-#define VL53L5CX_SIGNAL_RATE_BH			((uint32_t)0x58900404U)
-#define VL53L5CX_RANGE_SIGMA_MM_BH		((uint32_t)0x64900402U)
-#define VL53L5CX_DISTANCE_BH			((uint32_t)0x66900402U)
-#define VL53L5CX_REFLECTANCE_BH			((uint32_t)0x6A900401U)
-#define VL53L5CX_TARGET_STATUS_BH		((uint32_t)0x6B900401U)
-#define VL53L5CX_MOTION_DETECT_BH		((uint32_t)0xCC5008C0U)
+/**
+ * @brief Block headers streamed with 2 to 4 targets per zone (see
+ * vl53l5cx_set_nb_targets()). Per zone blocks are the same as above.
+ */
 
-#define VL53L5CX_METADATA_IDX			((uint16_t)0x54B4U)
-#define VL53L5CX_SPAD_COUNT_IDX			((uint16_t)0x55D0U)
-#define VL53L5CX_AMBIENT_RATE_IDX		((uint16_t)0x54D0U)
-#define VL53L5CX_NB_TARGET_DETECTED_IDX	((uint16_t)0x57D0U)
-#define VL53L5CX_SIGNAL_RATE_IDX		((uint16_t)0x5890U)
-#define VL53L5CX_RANGE_SIGMA_MM_IDX		((uint16_t)0x6490U)
-#define VL53L5CX_DISTANCE_IDX			((uint16_t)0x6690U)
-#define VL53L5CX_REFLECTANCE_EST_PC_IDX	((uint16_t)0x6A90U)
-#define VL53L5CX_TARGET_STATUS_IDX		((uint16_t)0x6B90U)
-#define VL53L5CX_MOTION_DETEC_IDX		((uint16_t)0xCC50U)
-#endif
+#define VL53L5CX_MT_NB_TARGET_DETECTED_BH	((uint32_t)0x57D00401U)
+#define VL53L5CX_MT_SIGNAL_RATE_BH		((uint32_t)0x58900404U)
+#define VL53L5CX_MT_RANGE_SIGMA_MM_BH		((uint32_t)0x64900402U)
+#define VL53L5CX_MT_DISTANCE_BH			((uint32_t)0x66900402U)
+#define VL53L5CX_MT_REFLECTANCE_BH		((uint32_t)0x6A900401U)
+#define VL53L5CX_MT_TARGET_STATUS_BH		((uint32_t)0x6B900401U)
+#define VL53L5CX_MT_MOTION_DETECT_BH		((uint32_t)0xCC5008C0U)
+
+#define VL53L5CX_MT_NB_TARGET_DETECTED_IDX	((uint16_t)0x57D0U)
+#define VL53L5CX_MT_SIGNAL_RATE_IDX		((uint16_t)0x5890U)
+#define VL53L5CX_MT_RANGE_SIGMA_MM_IDX		((uint16_t)0x6490U)
+#define VL53L5CX_MT_DISTANCE_IDX		((uint16_t)0x6690U)
+#define VL53L5CX_MT_REFLECTANCE_EST_PC_IDX	((uint16_t)0x6A90U)
+#define VL53L5CX_MT_TARGET_STATUS_IDX		((uint16_t)0x6B90U)
+#define VL53L5CX_MT_MOTION_DETEC_IDX		((uint16_t)0xCC50U)
 
 
 /**
@@ -258,6 +271,45 @@
 #define VL53L5CX_TEMPORARY_BUFFER_SIZE ((uint32_t) VL53L5CX_MAX_RESULTS_SIZE)
 #endif
 
+/**
+ * @brief Macro VL53L5CX_NB_OUTPUT_BLOCKS is the number of entries of the output
+ * list sent by function vl53l5cx_start_ranging(). It is also the maximum number
+ * of blocks located into the block table.
+ */
+
+#define VL53L5CX_NB_OUTPUT_BLOCKS		((uint8_t) 12U)
+
+/**
+ * @brief Macro VL53L5CX_NO_FIELD is used into the block table for blocks which
+ * are not copied into the VL53L5CX_ResultsData structure (common data, ...).
+ */
+
+#define VL53L5CX_NO_FIELD			((uint16_t) 0xFFFFU)
+
+/**
+ * @brief Structure VL53L5CX_BlockEntry locates one output block into the
+ * temporary buffer (after swap). The block table is built by function
+ * vl53l5cx_start_ranging(), as the frame layout is fixed during a ranging
+ * session. It is checked and used by vl53l5cx_get_ranging_data() to copy
+ * results without parsing all the block headers.
+ */
+
+typedef struct
+{
+	/* Block header streamed by the sensor, used to check the layout */
+	uint32_t		header;
+	/* Position of the block header into the temporary buffer */
+	uint16_t		offset;
+	/* Size of the block data in bytes */
+	uint16_t		size;
+	/* Position of the field into VL53L5CX_ResultsData, or VL53L5CX_NO_FIELD */
+	uint16_t		field;
+	/* Position of the copied bytes into the temporary buffer */
+	uint16_t		copy_pos;
+	/* Number of bytes copied into the field */
+	uint16_t		copy_size;
+} VL53L5CX_BlockEntry;
+
 
 /**
  * @brief Structure VL53L5CX_Configuration contains the sensor configuration.
@@ -284,6 +336,19 @@ typedef struct
 	 uint8_t	        temp_buffer[VL53L5CX_TEMPORARY_BUFFER_SIZE];
 	/* Auto-stop flag for stopping the sensor */
 	uint8_t				is_auto_stop_enabled;
+	/* Location of the output blocks into the temporary buffer */
+	VL53L5CX_BlockEntry	block_table[VL53L5CX_NB_OUTPUT_BLOCKS];
+	/* Number of blocks into the block table */
+	uint8_t				nb_blocks;
+	/* Flag set when the block table matches the streamed frames */
+	uint8_t				is_block_table_valid;
+	/* Outputs selected at runtime (VL53L5CX_OUTPUT_xxx) */
+	uint32_t			output_mask;
+	/* Outputs streamed since the last vl53l5cx_start_ranging(), converted
+	 * by the decoder */
+	uint32_t			streamed_mask;
+	/* Targets per zone streamed by the sensor, selected at runtime */
+	uint8_t				nb_target_per_zone;
 } VL53L5CX_Configuration;
 
 
@@ -295,7 +360,8 @@ typedef struct
  * , nb_target_detected and nb_spads_enabled).
  * - Per target results : These results are different relative to the detected
  * target (signal_per_spad, range_sigma_mm, distance_mm, reflectance,
- * target_status).
+ * target_status). Target t of zone z is at index
+ * (p_dev->nb_target_per_zone * z) + t.
  */
 
 typedef struct
@@ -433,6 +499,61 @@ uint8_t vl53l5cx_set_power_mode(
 		VL53L5CX_Configuration		*p_dev,
 		uint8_t				power_mode);
 
+/**
+ * @brief This function selects the outputs streamed by the sensor, using macros
+ * VL53L5CX_OUTPUT_xxx. All outputs are selected by vl53l5cx_init(). The mask
+ * is applied by the next call to vl53l5cx_start_ranging(), and only selected
+ * outputs are converted by vl53l5cx_get_ranging_data(). Fields of the results
+ * structure related to other outputs are not updated.
+ * @param (VL53L5CX_Configuration) *p_dev : VL53L5CX configuration structure.
+ * @param (uint32_t) output_mask : Combination of VL53L5CX_OUTPUT_xxx macros.
+ * @return (uint8_t) status : 0 if OK, or 127 if the mask contains unknown
+ * outputs.
+ */
+
+uint8_t vl53l5cx_set_output_mask(
+		VL53L5CX_Configuration		*p_dev,
+		uint32_t			output_mask);
+
+/**
+ * @brief This function gets the outputs selected with
+ * vl53l5cx_set_output_mask().
+ * @param (VL53L5CX_Configuration) *p_dev : VL53L5CX configuration structure.
+ * @param (uint32_t) *p_output_mask : Combination of VL53L5CX_OUTPUT_xxx macros.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l5cx_get_output_mask(
+		VL53L5CX_Configuration		*p_dev,
+		uint32_t			*p_output_mask);
+
+/**
+ * @brief This function sets the number of targets per zone streamed by the
+ * sensor, between 1 and VL53L5CX_NB_TARGET_PER_ZONE. Results buffers are sized
+ * for VL53L5CX_NB_TARGET_PER_ZONE targets, only the selected number is
+ * transferred through I2C. 1 target is selected by vl53l5cx_init(). The
+ * number is applied by the next call to vl53l5cx_start_ranging().
+ * @param (VL53L5CX_Configuration) *p_dev : VL53L5CX configuration structure.
+ * @param (uint8_t) nb_targets : Number of targets per zone.
+ * @return (uint8_t) status : 0 if OK, or 127 if the number is out of range.
+ */
+
+uint8_t vl53l5cx_set_nb_targets(
+		VL53L5CX_Configuration		*p_dev,
+		uint8_t				nb_targets);
+
+/**
+ * @brief This function gets the number of targets per zone selected with
+ * vl53l5cx_set_nb_targets().
+ * @param (VL53L5CX_Configuration) *p_dev : VL53L5CX configuration structure.
+ * @param (uint8_t) *p_nb_targets : Number of targets per zone.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l5cx_get_nb_targets(
+		VL53L5CX_Configuration		*p_dev,
+		uint8_t				*p_nb_targets);
+
 /**
  * @brief This function starts a ranging session. When the sensor streams, host
  * cannot change settings 'on-the-fly'.
@@ -478,6 +599,43 @@ uint8_t vl53l5cx_get_ranging_data(
 		VL53L5CX_Configuration		*p_dev,
 		VL53L5CX_ResultsData		*p_results);
 
+/**
+ * @brief This function decodes a frame already copied into the temporary
+ * buffer (p_dev->temp_buffer), as read from the sensor : p_dev->data_read_size
+ * bytes from address 0x0, not swapped. It is used by
+ * vl53l5cx_get_ranging_data(), and can be used when frames are read by another
+ * layer (e.g. the frame ring of the kernel module).
+ * @param (VL53L5CX_Configuration) *p_dev : VL53L5CX configuration structure.
+ * @param (VL53L5CX_ResultsData) *p_results : VL53L5 results structure.
+ * @return (uint8_t) status : 0 data are successfully decoded.
+ */
+
+uint8_t vl53l5cx_decode_ranging_data(
+		VL53L5CX_Configuration		*p_dev,
+		VL53L5CX_ResultsData		*p_results);
+
+/**
+ * @brief This function gives a direct access to one output block of the last
+ * frame read by vl53l5cx_get_ranging_data(), without copy. Data are in the
+ * firmware format (not converted), and are valid until the next access to the
+ * sensor.
+ * @param (VL53L5CX_Configuration) *p_dev : VL53L5CX configuration structure.
+ * @param (uint16_t) block_idx : Index of the block (VL53L5CX_DISTANCE_IDX,
+ * VL53L5CX_TARGET_STATUS_IDX, ...). The single target and the multiple targets
+ * (VL53L5CX_MT_*_IDX) index of an output are equivalent: the block streamed
+ * for the current number of targets per zone is returned.
+ * @param (uint8_t) **pp_data : Pointer updated to the block data into the
+ * temporary buffer.
+ * @param (uint32_t) *p_size : Size of the block data in bytes.
+ * @return (uint8_t) status : 0 if OK, or 127 if the block is not streamed.
+ */
+
+uint8_t vl53l5cx_get_block_view(
+		VL53L5CX_Configuration		*p_dev,
+		uint16_t			block_idx,
+		uint8_t				**pp_data,
+		uint32_t			*p_size);
+
 /**
  * @brief This function gets the current resolution (4x4 or 8x8).
  * @param (VL53L5CX_Configuration) *p_dev : VL53L5CX configuration structure.
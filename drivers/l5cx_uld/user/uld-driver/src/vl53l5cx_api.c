@@ -10,6 +10,7 @@
   ******************************************************************************
   */
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include "vl53l5cx_api.h"
@@ -214,6 +215,216 @@ static uint8_t _vl53l5cx_send_xtalk_data(
 	return status;
 }
 
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to know if a block index can be streamed by the sensor.
+ */
+
+static uint8_t _vl53l5cx_is_output_block(
+		uint16_t			idx)
+{
+	uint8_t is_output;
+
+	switch(idx){
+		case VL53L5CX_METADATA_IDX:
+		case (uint16_t)(VL53L5CX_COMMONDATA_BH >> 16):
+		case VL53L5CX_AMBIENT_RATE_IDX:
+		case VL53L5CX_SPAD_COUNT_IDX:
+		case VL53L5CX_NB_TARGET_DETECTED_IDX:
+		case VL53L5CX_SIGNAL_RATE_IDX:
+		case VL53L5CX_RANGE_SIGMA_MM_IDX:
+		case VL53L5CX_DISTANCE_IDX:
+		case VL53L5CX_REFLECTANCE_EST_PC_IDX:
+		case VL53L5CX_TARGET_STATUS_IDX:
+		case VL53L5CX_MOTION_DETEC_IDX:
+		case VL53L5CX_MT_NB_TARGET_DETECTED_IDX:
+		case VL53L5CX_MT_SIGNAL_RATE_IDX:
+		case VL53L5CX_MT_RANGE_SIGMA_MM_IDX:
+		case VL53L5CX_MT_DISTANCE_IDX:
+		case VL53L5CX_MT_REFLECTANCE_EST_PC_IDX:
+		case VL53L5CX_MT_TARGET_STATUS_IDX:
+		case VL53L5CX_MT_MOTION_DETEC_IDX:
+			is_output = (uint8_t)1;
+			break;
+		default:
+			is_output = (uint8_t)0;
+			break;
+	}
+
+	return is_output;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to set the VL53L5CX_ResultsData field filled by a block of the block table.
+ */
+
+#define _VL53L5CX_RESULTS_FIELD(name) \
+	field = (uint16_t)offsetof(VL53L5CX_ResultsData, name); \
+	max_size = (uint32_t)sizeof(((VL53L5CX_ResultsData *)0)->name)
+
+static void _vl53l5cx_set_block_field(
+		VL53L5CX_BlockEntry		*p_entry)
+{
+	union Block_header *bh_ptr = (union Block_header *)&(p_entry->header);
+	uint16_t field = VL53L5CX_NO_FIELD;
+	uint16_t copy_pos = p_entry->offset + (uint16_t)4;
+	uint32_t max_size = 0;
+
+	switch(bh_ptr->idx){
+		case VL53L5CX_METADATA_IDX:
+			_VL53L5CX_RESULTS_FIELD(silicon_temp_degc);
+			copy_pos = p_entry->offset + (uint16_t)12;
+			break;
+#ifndef VL53L5CX_DISABLE_AMBIENT_PER_SPAD
+		case VL53L5CX_AMBIENT_RATE_IDX:
+			_VL53L5CX_RESULTS_FIELD(ambient_per_spad);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_NB_SPADS_ENABLED
+		case VL53L5CX_SPAD_COUNT_IDX:
+			_VL53L5CX_RESULTS_FIELD(nb_spads_enabled);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_NB_TARGET_DETECTED
+		case VL53L5CX_NB_TARGET_DETECTED_IDX:
+		case VL53L5CX_MT_NB_TARGET_DETECTED_IDX:
+			_VL53L5CX_RESULTS_FIELD(nb_target_detected);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_SIGNAL_PER_SPAD
+		case VL53L5CX_SIGNAL_RATE_IDX:
+		case VL53L5CX_MT_SIGNAL_RATE_IDX:
+			_VL53L5CX_RESULTS_FIELD(signal_per_spad);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_RANGE_SIGMA_MM
+		case VL53L5CX_RANGE_SIGMA_MM_IDX:
+		case VL53L5CX_MT_RANGE_SIGMA_MM_IDX:
+			_VL53L5CX_RESULTS_FIELD(range_sigma_mm);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_DISTANCE_MM
+		case VL53L5CX_DISTANCE_IDX:
+		case VL53L5CX_MT_DISTANCE_IDX:
+			_VL53L5CX_RESULTS_FIELD(distance_mm);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_REFLECTANCE_PERCENT
+		case VL53L5CX_REFLECTANCE_EST_PC_IDX:
+		case VL53L5CX_MT_REFLECTANCE_EST_PC_IDX:
+			_VL53L5CX_RESULTS_FIELD(reflectance);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_TARGET_STATUS
+		case VL53L5CX_TARGET_STATUS_IDX:
+		case VL53L5CX_MT_TARGET_STATUS_IDX:
+			_VL53L5CX_RESULTS_FIELD(target_status);
+			break;
+#endif
+#ifndef VL53L5CX_DISABLE_MOTION_INDICATOR
+		case VL53L5CX_MOTION_DETEC_IDX:
+		case VL53L5CX_MT_MOTION_DETEC_IDX:
+			_VL53L5CX_RESULTS_FIELD(motion_indicator);
+			break;
+#endif
+		default:
+			break;
+	}
+
+	p_entry->field = field;
+	p_entry->copy_pos = copy_pos;
+	if(bh_ptr->idx == VL53L5CX_METADATA_IDX)
+	{
+		p_entry->copy_size = (uint16_t)max_size;
+	}
+	else
+	{
+		/* Never copy more than the field size, even for a corrupted frame */
+		p_entry->copy_size = ((uint32_t)p_entry->size > max_size)
+			? (uint16_t)max_size : p_entry->size;
+	}
+}
+
+#undef _VL53L5CX_RESULTS_FIELD
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to build the block table by parsing all the block headers of the frame stored
+ * into the temporary buffer (after swap).
+ */
+
+static void _vl53l5cx_scan_block_table(
+		VL53L5CX_Configuration		*p_dev)
+{
+	union Block_header *bh_ptr;
+	VL53L5CX_BlockEntry *p_entry;
+	uint32_t i, msize;
+
+	p_dev->nb_blocks = 0;
+
+	/* Start conversion at position 16 to avoid headers */
+	for (i = (uint32_t)16; i
+             < (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
+	{
+		bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
+		if ((bh_ptr->type > (uint32_t)0x1)
+                    && (bh_ptr->type < (uint32_t)0xd))
+		{
+			msize = bh_ptr->type * bh_ptr->size;
+		}
+		else
+		{
+			msize = bh_ptr->size;
+		}
+
+		if((_vl53l5cx_is_output_block((uint16_t)bh_ptr->idx) != (uint8_t)0)
+			&& ((i + (uint32_t)4 + msize) <= p_dev->data_read_size)
+			&& (p_dev->nb_blocks < VL53L5CX_NB_OUTPUT_BLOCKS))
+		{
+			p_entry = &(p_dev->block_table[p_dev->nb_blocks]);
+			p_entry->header = bh_ptr->bytes;
+			p_entry->offset = (uint16_t)i;
+			p_entry->size = (uint16_t)msize;
+			_vl53l5cx_set_block_field(p_entry);
+			p_dev->nb_blocks++;
+		}
+		i += msize;
+	}
+
+	p_dev->is_block_table_valid = (uint8_t)1;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to check that the frame stored into the temporary buffer (after swap) has
+ * its blocks at the positions of the block table.
+ */
+
+static uint8_t _vl53l5cx_check_block_table(
+		VL53L5CX_Configuration		*p_dev)
+{
+	uint32_t i, header;
+
+	if(p_dev->is_block_table_valid == (uint8_t)0)
+	{
+		return 0;
+	}
+
+	for (i = 0; i < (uint32_t)p_dev->nb_blocks; i++)
+	{
+		(void)memcpy(&header,
+			&(p_dev->temp_buffer[p_dev->block_table[i].offset]),
+			sizeof(header));
+		if(header != p_dev->block_table[i].header)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
 uint8_t vl53l5cx_is_alive(
 		VL53L5CX_Configuration		*p_dev,
 		uint8_t				*p_is_alive)
@@ -238,16 +449,41 @@ uint8_t vl53l5cx_is_alive(
 	return status;
 }
 
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to send the number of targets per zone selected at runtime. With 1 target
+ * per zone, the firmware computes 2 targets internally.
+ */
+
+static uint8_t _vl53l5cx_send_nb_targets(
+		VL53L5CX_Configuration		*p_dev)
+{
+	uint8_t tmp, status = VL53L5CX_STATUS_OK;
+	uint8_t pipe_ctrl[] = {p_dev->nb_target_per_zone, 0x00, 0x01, 0x00};
+
+	status |= vl53l5cx_dci_write_data(p_dev, (uint8_t*)&pipe_ctrl,
+		VL53L5CX_DCI_PIPE_CONTROL, (uint16_t)sizeof(pipe_ctrl));
+	tmp = (p_dev->nb_target_per_zone == (uint8_t)1)
+		? (uint8_t)2 : p_dev->nb_target_per_zone;
+	status |= vl53l5cx_dci_replace_data(p_dev, p_dev->temp_buffer,
+		VL53L5CX_DCI_FW_NB_TARGET, 16,
+		(uint8_t*)&tmp, 1, 0x0C);
+
+	return status;
+}
+
 uint8_t vl53l5cx_init(
 		VL53L5CX_Configuration		*p_dev)
 {
 	uint8_t tmp, status = VL53L5CX_STATUS_OK;
-	uint8_t pipe_ctrl[] = {VL53L5CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
 	uint32_t single_range = 0x01;
 
 	p_dev->default_xtalk = (uint8_t*)VL53L5CX_DEFAULT_XTALK;
 	p_dev->default_configuration = (uint8_t*)VL53L5CX_DEFAULT_CONFIGURATION;
 	p_dev->is_auto_stop_enabled = (uint8_t)0x0;
+	p_dev->output_mask = VL53L5CX_OUTPUT_ALL;
+	p_dev->streamed_mask = VL53L5CX_OUTPUT_ALL;
+	p_dev->nb_target_per_zone = (uint8_t)1;
 
 	/* SW reboot sequence */
 	status |= VL53L5CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
@@ -382,14 +618,7 @@ uint8_t vl53l5cx_init(
 	status |= _vl53l5cx_poll_for_answer(p_dev, 4, 1,
 		VL53L5CX_UI_CMD_STATUS, 0xff, 0x03);
 
-	status |= vl53l5cx_dci_write_data(p_dev, (uint8_t*)&pipe_ctrl,
-		VL53L5CX_DCI_PIPE_CONTROL, (uint16_t)sizeof(pipe_ctrl));
-#if VL53L5CX_NB_TARGET_PER_ZONE != 1
-	tmp = VL53L5CX_NB_TARGET_PER_ZONE;
-	status |= vl53l5cx_dci_replace_data(p_dev, p_dev->temp_buffer,
-		VL53L5CX_DCI_FW_NB_TARGET, 16,
-	(uint8_t*)&tmp, 1, 0x0C);
-#endif
+	status |= _vl53l5cx_send_nb_targets(p_dev);
 
 	status |= vl53l5cx_dci_write_data(p_dev, (uint8_t*)&single_range,
 			VL53L5CX_DCI_SINGLE_RANGE,
@@ -483,15 +712,70 @@ uint8_t vl53l5cx_set_power_mode(
 	return status;
 }
 
+uint8_t vl53l5cx_set_output_mask(
+		VL53L5CX_Configuration		*p_dev,
+		uint32_t			output_mask)
+{
+	uint8_t status = VL53L5CX_STATUS_OK;
+
+	if((output_mask & ~VL53L5CX_OUTPUT_ALL) != (uint32_t)0)
+	{
+		status |= VL53L5CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_dev->output_mask = output_mask;
+	}
+
+	return status;
+}
+
+uint8_t vl53l5cx_get_output_mask(
+		VL53L5CX_Configuration		*p_dev,
+		uint32_t			*p_output_mask)
+{
+	*p_output_mask = p_dev->output_mask;
+	return VL53L5CX_STATUS_OK;
+}
+
+uint8_t vl53l5cx_set_nb_targets(
+		VL53L5CX_Configuration		*p_dev,
+		uint8_t				nb_targets)
+{
+	uint8_t status = VL53L5CX_STATUS_OK;
+
+	if((nb_targets < (uint8_t)1)
+		|| (nb_targets > (uint8_t)VL53L5CX_NB_TARGET_PER_ZONE))
+	{
+		status = VL53L5CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_dev->nb_target_per_zone = nb_targets;
+	}
+
+	return status;
+}
+
+uint8_t vl53l5cx_get_nb_targets(
+		VL53L5CX_Configuration		*p_dev,
+		uint8_t				*p_nb_targets)
+{
+	*p_nb_targets = p_dev->nb_target_per_zone;
+
+	return VL53L5CX_STATUS_OK;
+}
+
 uint8_t vl53l5cx_start_ranging(
 		VL53L5CX_Configuration		*p_dev)
 {
 	uint8_t resolution, status = VL53L5CX_STATUS_OK;
 	uint16_t tmp;
-	uint32_t i;
+	uint32_t i, msize, position;
 	uint32_t header_config[2] = {0, 0};
 
 	union Block_header *bh_ptr;
+	VL53L5CX_BlockEntry *p_entry;
 	uint8_t cmd[] = {0x00, 0x03, 0x00, 0x00};
 
 	status |= vl53l5cx_get_resolution(p_dev, &resolution);
@@ -519,7 +803,21 @@ uint8_t vl53l5cx_start_ranging(
 		VL53L5CX_TARGET_STATUS_BH,
 		VL53L5CX_MOTION_DETECT_BH};
 
-	/* Enable selected outputs in the 'platform.h' file */
+	/* Per target blocks are streamed at other addresses with 2 targets or
+	 * more */
+	if(p_dev->nb_target_per_zone > (uint8_t)1)
+	{
+		output[5] = VL53L5CX_MT_NB_TARGET_DETECTED_BH;
+		output[6] = VL53L5CX_MT_SIGNAL_RATE_BH;
+		output[7] = VL53L5CX_MT_RANGE_SIGMA_MM_BH;
+		output[8] = VL53L5CX_MT_DISTANCE_BH;
+		output[9] = VL53L5CX_MT_REFLECTANCE_BH;
+		output[10] = VL53L5CX_MT_TARGET_STATUS_BH;
+		output[11] = VL53L5CX_MT_MOTION_DETECT_BH;
+	}
+	status |= _vl53l5cx_send_nb_targets(p_dev);
+
+	/* Enable outputs selected in the 'platform.h' file and at runtime */
 #ifndef VL53L5CX_DISABLE_AMBIENT_PER_SPAD
 	output_bh_enable[0] += (uint32_t)8;
 #endif
@@ -547,6 +845,8 @@ uint8_t vl53l5cx_start_ranging(
 #ifndef VL53L5CX_DISABLE_MOTION_INDICATOR
 	output_bh_enable[0] += (uint32_t)2048;
 #endif
+	output_bh_enable[0] &= (p_dev->output_mask | ~VL53L5CX_OUTPUT_ALL);
+	p_dev->streamed_mask = p_dev->output_mask;
 
 	/* Update data size */
 	for (i = 0; i < (uint32_t)(sizeof(output)/sizeof(uint32_t)); i++)
@@ -570,7 +870,7 @@ uint8_t vl53l5cx_start_ranging(
 			else
 			{
 				bh_ptr->size = (uint16_t)((uint16_t)resolution
-                                  * (uint16_t)VL53L5CX_NB_TARGET_PER_ZONE);
+                                  * (uint16_t)p_dev->nb_target_per_zone);
 			}
 			p_dev->data_read_size += bh_ptr->type * bh_ptr->size;
 		}
@@ -582,6 +882,40 @@ uint8_t vl53l5cx_start_ranging(
 	}
 	p_dev->data_read_size += (uint32_t)24;
 
+	/* Build the block table. Enabled blocks are streamed in the output list
+	 * order, after the 16 bytes of frame header. The first entry is the start
+	 * block, which is part of the frame header. */
+	p_dev->nb_blocks = 0;
+	position = (uint32_t)16;
+	for (i = 1; i < (uint32_t)(sizeof(output)/sizeof(uint32_t)); i++)
+	{
+		if ((output_bh_enable[i/(uint32_t)32]
+                     &((uint32_t)1 << (i%(uint32_t)32))) == (uint32_t)0)
+		{
+			continue;
+		}
+
+		bh_ptr = (union Block_header *)&(output[i]);
+		if ((bh_ptr->type > (uint32_t)0x1)
+                    && (bh_ptr->type < (uint32_t)0xd))
+		{
+			msize = bh_ptr->type * bh_ptr->size;
+		}
+		else
+		{
+			msize = bh_ptr->size;
+		}
+
+		p_entry = &(p_dev->block_table[p_dev->nb_blocks]);
+		p_entry->header = output[i];
+		p_entry->offset = (uint16_t)position;
+		p_entry->size = (uint16_t)msize;
+		_vl53l5cx_set_block_field(p_entry);
+		p_dev->nb_blocks++;
+		position += (uint32_t)4 + msize;
+	}
+	p_dev->is_block_table_valid = (uint8_t)1;
+
 	status |= vl53l5cx_dci_write_data(p_dev,
 			(uint8_t*)&(output), VL53L5CX_DCI_OUTPUT_LIST,
 			(uint16_t)sizeof(output));
@@ -710,149 +1044,134 @@ uint8_t vl53l5cx_get_ranging_data(
 		VL53L5CX_ResultsData		*p_results)
 {
 	uint8_t status = VL53L5CX_STATUS_OK;
-	union Block_header *bh_ptr;
-	uint16_t header_id, footer_id;
-	uint32_t i, j, msize;
 
 	status |= VL53L5CX_RdMulti(&(p_dev->platform), 0x0,
 			p_dev->temp_buffer, p_dev->data_read_size);
+	status |= vl53l5cx_decode_ranging_data(p_dev, p_results);
+
+	return status;
+}
+
+uint8_t vl53l5cx_decode_ranging_data(
+		VL53L5CX_Configuration		*p_dev,
+		VL53L5CX_ResultsData		*p_results)
+{
+	uint8_t status = VL53L5CX_STATUS_OK;
+	VL53L5CX_BlockEntry *p_entry;
+	uint16_t header_id, footer_id;
+	uint32_t i, j;
+
 	p_dev->streamcount = p_dev->temp_buffer[0];
 	VL53L5CX_SwapBuffer(p_dev->temp_buffer, (uint16_t)p_dev->data_read_size);
 
-	/* Start conversion at position 16 to avoid headers */
-	for (i = (uint32_t)16; i 
-             < (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
+	/* The frame layout is fixed during a ranging session. Block headers are
+	 * only parsed again if they are not at the positions of the block table */
+	if(_vl53l5cx_check_block_table(p_dev) == (uint8_t)0)
 	{
-		bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
-		if ((bh_ptr->type > (uint32_t)0x1) 
-                    && (bh_ptr->type < (uint32_t)0xd))
-		{
-			msize = bh_ptr->type * bh_ptr->size;
-		}
-		else
-		{
-			msize = bh_ptr->size;
-		}
-
-		switch(bh_ptr->idx){
-			case VL53L5CX_METADATA_IDX:
-				p_results->silicon_temp_degc =
-						(int8_t)p_dev->temp_buffer[i + (uint32_t)12];
-				break;
+		_vl53l5cx_scan_block_table(p_dev);
+	}
 
-#ifndef VL53L5CX_DISABLE_AMBIENT_PER_SPAD
-			case VL53L5CX_AMBIENT_RATE_IDX:
-				(void)memcpy(p_results->ambient_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_NB_SPADS_ENABLED
-			case VL53L5CX_SPAD_COUNT_IDX:
-				(void)memcpy(p_results->nb_spads_enabled,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_NB_TARGET_DETECTED
-			case VL53L5CX_NB_TARGET_DETECTED_IDX:
-				(void)memcpy(p_results->nb_target_detected,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_SIGNAL_PER_SPAD
-			case VL53L5CX_SIGNAL_RATE_IDX:
-				(void)memcpy(p_results->signal_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_RANGE_SIGMA_MM
-			case VL53L5CX_RANGE_SIGMA_MM_IDX:
-				(void)memcpy(p_results->range_sigma_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_DISTANCE_MM
-			case VL53L5CX_DISTANCE_IDX:
-				(void)memcpy(p_results->distance_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_REFLECTANCE_PERCENT
-			case VL53L5CX_REFLECTANCE_EST_PC_IDX:
-				(void)memcpy(p_results->reflectance,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_TARGET_STATUS
-			case VL53L5CX_TARGET_STATUS_IDX:
-				(void)memcpy(p_results->target_status,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-#ifndef VL53L5CX_DISABLE_MOTION_INDICATOR
-			case VL53L5CX_MOTION_DETEC_IDX:
-				(void)memcpy(&p_results->motion_indicator,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
-#endif
-			default:
-				break;
+	for (i = 0; i < (uint32_t)p_dev->nb_blocks; i++)
+	{
+		p_entry = &(p_dev->block_table[i]);
+		if(p_entry->field != VL53L5CX_NO_FIELD)
+		{
+			(void)memcpy(&(((uint8_t*)p_results)[p_entry->field]),
+				&(p_dev->temp_buffer[p_entry->copy_pos]),
+				p_entry->copy_size);
 		}
-		i += msize;
 	}
 
 #ifndef VL53L5CX_USE_RAW_FORMAT
 
-	/* Convert data into their real format */
+	/* Convert data into their real format. Only outputs streamed since the
+	 * last vl53l5cx_start_ranging() are converted: the mask can be changed
+	 * while ranging, the frame layout cannot */
 #ifndef VL53L5CX_DISABLE_AMBIENT_PER_SPAD
-	for(i = 0; i < (uint32_t)VL53L5CX_RESOLUTION_8X8; i++)
+	if((p_dev->streamed_mask & VL53L5CX_OUTPUT_AMBIENT_PER_SPAD) != (uint32_t)0)
 	{
-		p_results->ambient_per_spad[i] /= (uint32_t)2048;
+		for(i = 0; i < (uint32_t)VL53L5CX_RESOLUTION_8X8; i++)
+		{
+			p_results->ambient_per_spad[i] /= (uint32_t)2048;
+		}
 	}
 #endif
 
-	for(i = 0; i < (uint32_t)(VL53L5CX_RESOLUTION_8X8
-			*VL53L5CX_NB_TARGET_PER_ZONE); i++)
-	{
 #ifndef VL53L5CX_DISABLE_DISTANCE_MM
-		p_results->distance_mm[i] /= 4;
-		if(p_results->distance_mm[i] < 0)
+	if((p_dev->streamed_mask & VL53L5CX_OUTPUT_DISTANCE_MM) != (uint32_t)0)
+	{
+		for(i = 0; i < (uint32_t)(VL53L5CX_RESOLUTION_8X8
+				*p_dev->nb_target_per_zone); i++)
 		{
-			p_results->distance_mm[i] = 0;
+			p_results->distance_mm[i] /= 4;
+			if(p_results->distance_mm[i] < 0)
+			{
+				p_results->distance_mm[i] = 0;
+			}
 		}
+	}
 #endif
 #ifndef VL53L5CX_DISABLE_REFLECTANCE_PERCENT
-		p_results->reflectance[i] /= (uint8_t)2;
+	if((p_dev->streamed_mask & VL53L5CX_OUTPUT_REFLECTANCE_PERCENT) != (uint32_t)0)
+	{
+		for(i = 0; i < (uint32_t)(VL53L5CX_RESOLUTION_8X8
+				*p_dev->nb_target_per_zone); i++)
+		{
+			p_results->reflectance[i] /= (uint8_t)2;
+		}
+	}
 #endif
 #ifndef VL53L5CX_DISABLE_RANGE_SIGMA_MM
-		p_results->range_sigma_mm[i] /= (uint16_t)128;
+	if((p_dev->streamed_mask & VL53L5CX_OUTPUT_RANGE_SIGMA_MM) != (uint32_t)0)
+	{
+		for(i = 0; i < (uint32_t)(VL53L5CX_RESOLUTION_8X8
+				*p_dev->nb_target_per_zone); i++)
+		{
+			p_results->range_sigma_mm[i] /= (uint16_t)128;
+		}
+	}
 #endif
 #ifndef VL53L5CX_DISABLE_SIGNAL_PER_SPAD
-		p_results->signal_per_spad[i] /= (uint32_t)2048;
-#endif
+	if((p_dev->streamed_mask & VL53L5CX_OUTPUT_SIGNAL_PER_SPAD) != (uint32_t)0)
+	{
+		for(i = 0; i < (uint32_t)(VL53L5CX_RESOLUTION_8X8
+				*p_dev->nb_target_per_zone); i++)
+		{
+			p_results->signal_per_spad[i] /= (uint32_t)2048;
+		}
 	}
+#endif
 
 	/* Set target status to 255 if no target is detected for this zone */
-#ifndef VL53L5CX_DISABLE_NB_TARGET_DETECTED
-	for(i = 0; i < (uint32_t)VL53L5CX_RESOLUTION_8X8; i++)
+#if !defined(VL53L5CX_DISABLE_NB_TARGET_DETECTED) \
+	&& !defined(VL53L5CX_DISABLE_TARGET_STATUS)
+	if(((p_dev->streamed_mask & VL53L5CX_OUTPUT_NB_TARGET_DETECTED)
+			!= (uint32_t)0)
+		&& ((p_dev->streamed_mask & VL53L5CX_OUTPUT_TARGET_STATUS)
+			!= (uint32_t)0))
 	{
-		if(p_results->nb_target_detected[i] == (uint8_t)0){
-			for(j = 0; j < (uint32_t)
-				VL53L5CX_NB_TARGET_PER_ZONE; j++)
-			{
-#ifndef VL53L5CX_DISABLE_TARGET_STATUS
-				p_results->target_status
-				[((uint32_t)VL53L5CX_NB_TARGET_PER_ZONE
-					*(uint32_t)i) + j]=(uint8_t)255;
-#endif
+		for(i = 0; i < (uint32_t)VL53L5CX_RESOLUTION_8X8; i++)
+		{
+			if(p_results->nb_target_detected[i] == (uint8_t)0){
+				for(j = 0; j < (uint32_t)
+					p_dev->nb_target_per_zone; j++)
+				{
+					p_results->target_status
+					[((uint32_t)p_dev->nb_target_per_zone
+						*(uint32_t)i) + j]=(uint8_t)255;
+				}
 			}
 		}
 	}
 #endif
 
 #ifndef VL53L5CX_DISABLE_MOTION_INDICATOR
-	for(i = 0; i < (uint32_t)32; i++)
+	if((p_dev->streamed_mask & VL53L5CX_OUTPUT_MOTION_INDICATOR) != (uint32_t)0)
 	{
-		p_results->motion_indicator.motion[i] /= (uint32_t)65535;
+		for(i = 0; i < (uint32_t)32; i++)
+		{
+			p_results->motion_indicator.motion[i] /= (uint32_t)65535;
+		}
 	}
 #endif
 
@@ -876,6 +1195,70 @@ uint8_t vl53l5cx_get_ranging_data(
 	return status;
 }
 
+/**
+ * @brief Inner function, not available outside this file. This function gives
+ * the idx of the same output in the other stream format (single target <->
+ * multiple targets), or the idx itself if the output has only one format.
+ */
+
+static uint16_t _vl53l5cx_paired_idx(
+		uint16_t			idx)
+{
+	static const uint16_t pairs[][2] = {
+		{VL53L5CX_NB_TARGET_DETECTED_IDX,
+			VL53L5CX_MT_NB_TARGET_DETECTED_IDX},
+		{VL53L5CX_SIGNAL_RATE_IDX, VL53L5CX_MT_SIGNAL_RATE_IDX},
+		{VL53L5CX_RANGE_SIGMA_MM_IDX, VL53L5CX_MT_RANGE_SIGMA_MM_IDX},
+		{VL53L5CX_DISTANCE_IDX, VL53L5CX_MT_DISTANCE_IDX},
+		{VL53L5CX_REFLECTANCE_EST_PC_IDX,
+			VL53L5CX_MT_REFLECTANCE_EST_PC_IDX},
+		{VL53L5CX_TARGET_STATUS_IDX, VL53L5CX_MT_TARGET_STATUS_IDX},
+		{VL53L5CX_MOTION_DETEC_IDX, VL53L5CX_MT_MOTION_DETEC_IDX},
+	};
+	uint32_t i;
+
+	for (i = 0; i < (uint32_t)(sizeof(pairs) / sizeof(pairs[0])); i++)
+	{
+		if(pairs[i][0] == idx)
+		{
+			return pairs[i][1];
+		}
+		if(pairs[i][1] == idx)
+		{
+			return pairs[i][0];
+		}
+	}
+
+	return idx;
+}
+
+uint8_t vl53l5cx_get_block_view(
+		VL53L5CX_Configuration		*p_dev,
+		uint16_t			block_idx,
+		uint8_t				**pp_data,
+		uint32_t			*p_size)
+{
+	union Block_header *bh_ptr;
+	uint16_t paired_idx = _vl53l5cx_paired_idx(block_idx);
+	uint32_t i;
+
+	for (i = 0; i < (uint32_t)p_dev->nb_blocks; i++)
+	{
+		bh_ptr = (union Block_header *)&(p_dev->block_table[i].header);
+		if((bh_ptr->idx == block_idx) || (bh_ptr->idx == paired_idx))
+		{
+			*pp_data = &(p_dev->temp_buffer[
+				p_dev->block_table[i].offset + (uint16_t)4]);
+			*p_size = p_dev->block_table[i].size;
+			return VL53L5CX_STATUS_OK;
+		}
+	}
+
+	*pp_data = NULL;
+	*p_size = 0;
+	return VL53L5CX_STATUS_INVALID_PARAM;
+}
+
 uint8_t vl53l5cx_get_resolution(
 		VL53L5CX_Configuration		*p_dev,
 		uint8_t				*p_resolution)
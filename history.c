@@ -0,0 +1,191 @@
+#include "history.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_ZONES 64
+#define MASK_BYTES (MAX_ZONES / 8)
+
+// Самая длинная запись кадра: заголовок, две маски, 64 разности по 3
+// байта и 64 статуса. Блок с меньшим остатком закрывается
+#define MAX_FRAME_BYTES                                                        \
+  (1 + 10 + 1 + 2 * MASK_BYTES + MAX_ZONES * 3 + MAX_ZONES)
+
+HistoryStore *history_store = NULL;
+
+static size_t store_size = 0;
+static HistoryIndex *index_table = NULL;
+static uint8_t *blocks = NULL;
+
+// Состояние текущего блока: прошлый кадр каждого датчика (кадры до
+// первого в блоке — нули) и время прошлой записи
+static uint16_t last_distances[HISTORY_MAX_SENSORS][MAX_ZONES];
+static uint8_t last_statuses[HISTORY_MAX_SENSORS][MAX_ZONES];
+static uint64_t last_us = 0;
+static int block_open = 0;
+
+// Кадры L5CX на модуле ядра приходят из потоков чтения
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+int history_open(uint32_t megabytes, int sensor_count) {
+  if (megabytes > HISTORY_MAX_MB)
+    megabytes = HISTORY_MAX_MB;
+  uint32_t count = (uint32_t)((uint64_t)megabytes * 1024 * 1024 /
+                              (HISTORY_BLOCK_SIZE + sizeof(HistoryIndex)));
+  if (count < HISTORY_MIN_BLOCKS)
+    count = HISTORY_MIN_BLOCKS;
+
+  // История прошлого запуска заменяется новой
+  shm_unlink(HISTORY_SHM_NAME);
+  int fd = shm_open(HISTORY_SHM_NAME, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return -1;
+
+  size_t size = sizeof(HistoryStore) +
+                count * (sizeof(HistoryIndex) + (size_t)HISTORY_BLOCK_SIZE);
+  fchmod(fd, 0644);
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    return -1;
+  }
+  HistoryStore *store =
+      mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (store == MAP_FAILED)
+    return -1;
+
+  // Файл после ftruncate заполнен нулями: все блоки пусты (seq 0)
+  store->version = HISTORY_VERSION;
+  store->sensor_count = sensor_count > HISTORY_MAX_SENSORS
+                            ? HISTORY_MAX_SENSORS
+                            : sensor_count;
+  store->block_size = HISTORY_BLOCK_SIZE;
+  store->block_count = count;
+  __atomic_store_n(&store->magic, HISTORY_MAGIC, __ATOMIC_RELEASE);
+
+  index_table = (HistoryIndex *)(store + 1);
+  blocks = (uint8_t *)(index_table + count);
+  block_open = 0;
+  store_size = size;
+  history_store = store;
+  return 0;
+}
+
+void history_close(void) {
+  if (!history_store)
+    return;
+  pthread_mutex_lock(&lock);
+  HistoryStore *store = history_store;
+  history_store = NULL;
+  munmap(store, store_size);
+  pthread_mutex_unlock(&lock);
+}
+
+void history_set_sensor(int sensor, const char *name) {
+  if (history_store && sensor >= 0 && sensor < history_store->sensor_count)
+    strncpy(history_store->names[sensor], name,
+            sizeof(history_store->names[sensor]) - 1);
+}
+
+// Новый блок на месте самого старого
+static HistoryIndex *start_block(uint64_t timestamp_us) {
+  uint32_t number = history_store->head;
+  HistoryIndex *ix = &index_table[number % history_store->block_count];
+
+  // Блок помечается пустым раньше, чем меняется его содержимое
+  __atomic_store_n(&ix->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  ix->used = 0;
+  ix->frames = 0;
+  ix->first_us = timestamp_us;
+  ix->last_us = timestamp_us;
+  __atomic_store_n(&ix->seq, number + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&history_store->head, number + 1, __ATOMIC_RELEASE);
+
+  memset(last_distances, 0, sizeof(last_distances));
+  memset(last_statuses, 0, sizeof(last_statuses));
+  last_us = timestamp_us;
+  block_open = 1;
+  return ix;
+}
+
+static uint8_t *put_varint(uint8_t *p, uint64_t value) {
+  while (value >= 0x80) {
+    *p++ = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  *p++ = (uint8_t)value;
+  return p;
+}
+
+void history_record(int sensor, const uint16_t *distances,
+                    const uint8_t *statuses, uint8_t zones) {
+  if (sensor < 0 || sensor >= HISTORY_MAX_SENSORS || zones > MAX_ZONES)
+    return;
+
+  pthread_mutex_lock(&lock);
+  if (!history_store) {
+    pthread_mutex_unlock(&lock);
+    return;
+  }
+
+  uint64_t timestamp_us = now_us();
+  HistoryIndex *ix =
+      &index_table[(history_store->head - 1) % history_store->block_count];
+  if (!block_open || ix->used + MAX_FRAME_BYTES > HISTORY_BLOCK_SIZE ||
+      timestamp_us < last_us)
+    ix = start_block(timestamp_us);
+
+  uint8_t *block = blocks + (size_t)(ix - index_table) * HISTORY_BLOCK_SIZE;
+  uint8_t *p = block + ix->used;
+  uint16_t *prev_d = last_distances[sensor];
+  uint8_t *prev_s = last_statuses[sensor];
+  int mask_bytes = (zones + 7) / 8;
+
+  *p++ = (uint8_t)sensor;
+  p = put_varint(p, timestamp_us - last_us);
+  *p++ = zones;
+
+  // Маски изменившихся зон
+  uint8_t *dist_mask = p;
+  uint8_t *status_mask = p + mask_bytes;
+  memset(p, 0, 2 * mask_bytes);
+  for (int i = 0; i < zones; i++) {
+    dist_mask[i / 8] |= (uint8_t)((distances[i] != prev_d[i]) << (i % 8));
+    status_mask[i / 8] |= (uint8_t)((statuses[i] != prev_s[i]) << (i % 8));
+  }
+  p += 2 * mask_bytes;
+
+  for (int i = 0; i < zones; i++) {
+    if (distances[i] == prev_d[i])
+      continue;
+    int32_t delta = (int32_t)distances[i] - prev_d[i];
+    p = put_varint(p, (uint32_t)((delta << 1) ^ (delta >> 31)));
+    prev_d[i] = distances[i];
+  }
+  for (int i = 0; i < zones; i++) {
+    if (statuses[i] == prev_s[i])
+      continue;
+    *p++ = statuses[i];
+    prev_s[i] = statuses[i];
+  }
+
+  ix->frames++;
+  ix->last_us = timestamp_us;
+  last_us = timestamp_us;
+
+  // used последним: читатель видит только дописанные кадры
+  __atomic_store_n(&ix->used, (uint32_t)(p - block), __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&lock);
+}
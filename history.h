@@ -0,0 +1,76 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+// История кадров в памяти (--history МБ): все кадры всех датчиков за
+// последние минуты или часы в сегменте /sensors2shm_history, без записи на
+// SD-карту. Сегмент делится на блоки по HISTORY_BLOCK_SIZE байт, новые
+// блоки занимают место самых старых. Кадр хранится разностью с прошлым
+// кадром того же датчика в блоке: маски изменившихся зон и zigzag-varint
+// разности расстояний, поэтому кадр тихой сцены занимает десяток байт.
+// Первый кадр датчика в блоке кодируется от нуля — каждый блок читается
+// отдельно, а индекс блоков (время первого и последнего кадра) даёт
+// доступ по времени. history_dump.py расшифровывает сегмент или его копию.
+//
+// Запись кадра (HistoryFrame и далее по порядку):
+//   u8 датчик, varint мкс от прошлого кадра блока (первый — от first_us),
+//   u8 зон, маска зон с новым расстоянием, маска зон с новым статусом
+//   (по (зон + 7) / 8 байт, бит i — зона i), zigzag-varint разности
+//   расстояний для зон из первой маски, u8 статусы для зон из второй.
+//
+// Читатель блока: seq (acquire), used (acquire), копия used байт, снова
+// seq. Изменившийся seq — блок перезаписан во время копии.
+
+#include <stdint.h>
+
+#define HISTORY_SHM_NAME "/sensors2shm_history"
+#define HISTORY_MAGIC 0x48533253u // "S2SH"
+#define HISTORY_VERSION 1
+#define HISTORY_MAX_SENSORS 64
+#define HISTORY_BLOCK_SIZE 16384
+#define HISTORY_MIN_BLOCKS 4
+
+// Размер истории в мегабайтах
+#define HISTORY_MAX_MB 256
+
+typedef struct {
+  uint32_t seq;      // Номер блока + 1, 0 — блок пуст или начат заново
+  uint32_t used;     // Байт записано в блок
+  uint64_t first_us; // CLOCK_REALTIME первого кадра блока, мкс
+  uint64_t last_us;  // CLOCK_REALTIME последнего кадра блока, мкс
+  uint32_t frames;   // Кадров в блоке
+  uint32_t reserved;
+} HistoryIndex;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t sensor_count;
+  uint32_t block_size;  // HISTORY_BLOCK_SIZE
+  uint32_t block_count; // Блоков в кольце
+  uint32_t head;        // Блоков начато с запуска; текущий — head - 1
+  uint32_t reserved;
+  char names[HISTORY_MAX_SENSORS][32];
+  // Далее HistoryIndex[block_count], затем блоки по block_size байт
+} HistoryStore;
+
+// Создание сегмента на megabytes МБ. 0 — успех. Сегмент остаётся в
+// /dev/shm после завершения демона, чтобы разобрать историю
+int history_open(uint32_t megabytes, int sensor_count);
+void history_close(void);
+
+void history_set_sensor(int sensor, const char *name);
+
+// Кадр датчика из zones зон (1 для VL53L1X)
+void history_record(int sensor, const uint16_t *distances,
+                    const uint8_t *statuses, uint8_t zones);
+
+// NULL — история выключена
+extern HistoryStore *history_store;
+
+static inline void history_frame(int sensor, const uint16_t *distances,
+                                 const uint8_t *statuses, uint8_t zones) {
+  if (history_store)
+    history_record(sensor, distances, statuses, zones);
+}
+
+#endif
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Расшифровка истории кадров демона (--history) в CSV
+Запуск: python3 history_dump.py [сегмент] [--from ВРЕМЯ] [--to ВРЕМЯ] [-o файл]
+
+Сегмент — /dev/shm/sensors2shm_history (по умолчанию) или его копия. Время —
+ISO 8601 (2026-10-18T12:30:00) или секунды Unix; --last N — последние N
+секунд истории. Расшифровываются только блоки, попавшие в интервал по
+индексу. Формат сегмента описан в history.h
+"""
+
+import argparse
+import csv
+import mmap
+import struct
+import sys
+from datetime import datetime
+
+HISTORY_MAGIC = 0x48533253
+HISTORY_VERSION = 1
+HISTORY_MAX_SENSORS = 64
+
+HEADER = struct.Struct("<IHHIIII")
+NAME_SIZE = 32
+INDEX = struct.Struct("<IIQQII")
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def load_blocks(buf):
+    """Имена датчиков и целые блоки (индекс, байты) в порядке записи. Блок,
+    перезаписанный во время копии, отбрасывается"""
+    magic, version, sensor_count, block_size, block_count, head, _ = HEADER.unpack_from(
+        buf, 0
+    )
+    if magic != HISTORY_MAGIC or version != HISTORY_VERSION:
+        raise ValueError("не история sensors2shm")
+
+    names = []
+    for i in range(sensor_count):
+        raw = buf[HEADER.size + i * NAME_SIZE : HEADER.size + (i + 1) * NAME_SIZE]
+        names.append(raw.split(b"\0", 1)[0].decode(errors="replace"))
+
+    index_offset = HEADER.size + HISTORY_MAX_SENSORS * NAME_SIZE
+    blocks_offset = index_offset + block_count * INDEX.size
+    blocks = []
+    for slot in range(block_count):
+        at = index_offset + slot * INDEX.size
+        seq, used, first_us, last_us, frames, _ = INDEX.unpack_from(buf, at)
+        if seq == 0:
+            continue
+        start = blocks_offset + slot * block_size
+        data = bytes(buf[start : start + used])
+        if struct.unpack_from("<I", buf, at)[0] != seq:
+            continue
+        blocks.append((seq, first_us, last_us, frames, data))
+    blocks.sort()
+    return names, blocks, block_size, block_count
+
+
+def decode_block(first_us, data):
+    """Кадры блока: (мкс, датчик, расстояния, статусы)"""
+    last_distances = {}
+    last_statuses = {}
+    timestamp = first_us
+    pos = 0
+    while pos < len(data):
+        sensor = data[pos]
+        delta_us, pos = read_varint(data, pos + 1)
+        zones = data[pos]
+        pos += 1
+        mask_bytes = (zones + 7) // 8
+        dist_mask = int.from_bytes(data[pos : pos + mask_bytes], "little")
+        status_mask = int.from_bytes(
+            data[pos + mask_bytes : pos + 2 * mask_bytes], "little"
+        )
+        pos += 2 * mask_bytes
+
+        distances = last_distances.setdefault(sensor, [0] * 64)
+        statuses = last_statuses.setdefault(sensor, [0] * 64)
+        for i in range(zones):
+            if dist_mask >> i & 1:
+                value, pos = read_varint(data, pos)
+                distances[i] = (distances[i] + ((value >> 1) ^ -(value & 1))) & 0xFFFF
+        for i in range(zones):
+            if status_mask >> i & 1:
+                statuses[i] = data[pos]
+                pos += 1
+
+        timestamp += delta_us
+        yield timestamp, sensor, distances[:zones], statuses[:zones]
+
+
+def parse_time(text):
+    try:
+        return int(float(text) * 1e6)
+    except ValueError:
+        return int(datetime.fromisoformat(text).timestamp() * 1e6)
+
+
+def format_time(timestamp_us):
+    return datetime.fromtimestamp(timestamp_us / 1e6).isoformat(timespec="microseconds")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("segment", nargs="?", default="/dev/shm/sensors2shm_history")
+    parser.add_argument("--from", dest="start", type=parse_time)
+    parser.add_argument("--to", dest="end", type=parse_time)
+    parser.add_argument("--last", type=float, help="последние N секунд")
+    parser.add_argument("--sensor", help="только датчик с этим именем")
+    parser.add_argument("--info", action="store_true", help="только сводка по блокам")
+    parser.add_argument("-o", "--output", help="CSV (по умолчанию stdout)")
+    args = parser.parse_args()
+
+    with open(args.segment, "rb") as f:
+        buf = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        try:
+            names, blocks, block_size, block_count = load_blocks(buf)
+        except (ValueError, struct.error) as e:
+            print(f"{args.segment}: {e}", file=sys.stderr)
+            return 1
+        finally:
+            buf.close()
+
+    if not blocks:
+        print("история пуста", file=sys.stderr)
+        return 0
+
+    if args.info:
+        frames = sum(b[3] for b in blocks)
+        used = sum(len(b[4]) for b in blocks)
+        span = (blocks[-1][2] - blocks[0][1]) / 1e6
+        print(f"датчики: {', '.join(names)}")
+        print(f"блоков: {len(blocks)} из {block_count} по {block_size} байт")
+        print(f"с {format_time(blocks[0][1])} по {format_time(blocks[-1][2])} ({span:.1f} с)")
+        print(f"кадров: {frames}, {used / max(frames, 1):.1f} байт на кадр")
+        if frames and span > 0:
+            capacity = block_count * block_size / used * span
+            print(f"ёмкость при той же нагрузке: {capacity / 60:.1f} мин")
+        return 0
+
+    start = args.start
+    end = args.end
+    if args.last is not None:
+        start = blocks[-1][2] - int(args.last * 1e6)
+    sensor_filter = None
+    if args.sensor:
+        if args.sensor not in names:
+            print(f"нет датчика {args.sensor}", file=sys.stderr)
+            return 1
+        sensor_filter = names.index(args.sensor)
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.writer(out)
+    writer.writerow(["time", "sensor", "zones", "distances", "statuses"])
+    count = 0
+    for _, first_us, last_us, _, data in blocks:
+        # Индекс: блоки вне интервала не расшифровываются
+        if (start is not None and last_us < start) or (end is not None and first_us > end):
+            continue
+        for timestamp, sensor, distances, statuses in decode_block(first_us, data):
+            if (start is not None and timestamp < start) or (
+                end is not None and timestamp > end
+            ):
+                continue
+            if sensor_filter is not None and sensor != sensor_filter:
+                continue
+            name = names[sensor] if sensor < len(names) else str(sensor)
+            writer.writerow(
+                [
+                    format_time(timestamp),
+                    name,
+                    len(distances),
+                    " ".join(map(str, distances)),
+                    " ".join(map(str, statuses)),
+                ]
+            )
+            count += 1
+    if args.output:
+        out.close()
+        print(f"{count} кадров -> {args.output}", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
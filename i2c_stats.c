@@ -0,0 +1,142 @@
+#include "i2c_stats.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+static const char *call_names[I2C_CALL_COUNT] = {
+    "init", "config", "start_stop", "check_ready", "read_frame", "clear_int",
+    "other"};
+
+// Таблица [датчик][вызов]; последняя строка — транзакции вне датчиков.
+// В строку датчика пишут основной цикл (запуск, остановка) и поток чтения
+// датчика, в строку "bus" — все потоки: счётчики атомарные, без блокировок
+static I2cCallStats *table = NULL;
+static const char **names = NULL;
+static int sensors = 0;
+static uint64_t start_ns = 0;
+
+static __thread int current_sensor = -1;
+static __thread I2cCall current_call = I2C_CALL_OTHER;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int i2c_stats_enable(int sensor_count) {
+  table = calloc((size_t)(sensor_count + 1) * I2C_CALL_COUNT,
+                 sizeof(I2cCallStats));
+  names = calloc(sensor_count + 1, sizeof(*names));
+  if (!table || !names) {
+    free(table);
+    free(names);
+    table = NULL;
+    names = NULL;
+    return -1;
+  }
+  sensors = sensor_count;
+  start_ns = now_ns();
+  return 0;
+}
+
+int i2c_stats_enabled(void) { return table != NULL; }
+
+void i2c_stats_set_name(int sensor, const char *name) {
+  if (table && sensor >= 0 && sensor < sensors)
+    names[sensor] = name;
+}
+
+void i2c_stats_context(int sensor, I2cCall call) {
+  current_sensor = sensor;
+  current_call = call;
+}
+
+void i2c_stats_call(I2cCall call) { current_call = call; }
+
+static inline void add(uint64_t *counter, uint64_t value) {
+  __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+// Копия строки таблицы: 64-битные счётчики читаются целиком и на 32-битных
+// платформах
+static void load(const I2cCallStats *src, I2cCallStats *dst) {
+  dst->transactions = __atomic_load_n(&src->transactions, __ATOMIC_RELAXED);
+  dst->syscalls = __atomic_load_n(&src->syscalls, __ATOMIC_RELAXED);
+  dst->bytes_read = __atomic_load_n(&src->bytes_read, __ATOMIC_RELAXED);
+  dst->bytes_written = __atomic_load_n(&src->bytes_written, __ATOMIC_RELAXED);
+  dst->errors = __atomic_load_n(&src->errors, __ATOMIC_RELAXED);
+  dst->time_ns = __atomic_load_n(&src->time_ns, __ATOMIC_RELAXED);
+  dst->max_ns = __atomic_load_n(&src->max_ns, __ATOMIC_RELAXED);
+}
+
+void i2c_stats_record(void *ctx, uint16_t i2c_address, uint16_t reg_address,
+                      uint32_t count, int write_not_read, uint32_t syscalls,
+                      int32_t status, uint64_t elapsed_ns) {
+  (void)ctx;
+  (void)i2c_address;
+  (void)reg_address;
+
+  if (!table)
+    return;
+  int row = current_sensor >= 0 && current_sensor < sensors ? current_sensor
+                                                            : sensors;
+  I2cCallStats *st = &table[row * I2C_CALL_COUNT + current_call];
+
+  add(&st->transactions, 1);
+  add(&st->syscalls, syscalls);
+  add(write_not_read ? &st->bytes_written : &st->bytes_read, count);
+  if (status != 0)
+    add(&st->errors, 1);
+  add(&st->time_ns, elapsed_ns);
+
+  uint64_t max = __atomic_load_n(&st->max_ns, __ATOMIC_RELAXED);
+  while (elapsed_ns > max &&
+         !__atomic_compare_exchange_n(&st->max_ns, &max, elapsed_ns, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+void i2c_stats_dump(FILE *out) {
+  if (!table)
+    return;
+
+  uint64_t wall_ns = now_ns() - start_ns;
+  uint64_t bus_ns = 0, transactions = 0;
+
+  fprintf(out, "I2C profile, %.3f s\n", wall_ns / 1e9);
+  fprintf(out, "%-20s %-12s %10s %10s %12s %12s %7s %10s %9s %9s %6s\n",
+          "sensor", "call", "xfers", "syscalls", "read_B", "write_B",
+          "errors", "total_ms", "avg_us", "max_us", "bus_%");
+  for (int row = 0; row <= sensors; row++) {
+    const char *name = row < sensors ? names[row] : "bus";
+    for (int call = 0; call < I2C_CALL_COUNT; call++) {
+      I2cCallStats snap;
+      const I2cCallStats *st = &snap;
+      load(&table[row * I2C_CALL_COUNT + call], &snap);
+      if (!st->transactions)
+        continue;
+
+      fprintf(out,
+              "%-20.20s %-12s %10llu %10llu %12llu %12llu %7llu %10.3f "
+              "%9.1f %9.1f %6.2f\n",
+              name ? name : "?", call_names[call],
+              (unsigned long long)st->transactions,
+              (unsigned long long)st->syscalls,
+              (unsigned long long)st->bytes_read,
+              (unsigned long long)st->bytes_written,
+              (unsigned long long)st->errors, st->time_ns / 1e6,
+              st->time_ns / 1e3 / st->transactions, st->max_ns / 1e3,
+              wall_ns ? 100.0 * st->time_ns / wall_ns : 0.0);
+      bus_ns += st->time_ns;
+      transactions += st->transactions;
+    }
+  }
+
+  // Доля времени, когда шина занята транзакциями: по ней видно, сколько
+  // ещё датчиков поместится на шину
+  fprintf(out, "total: %llu transactions, %.3f ms on the bus (%.2f %%)\n",
+          (unsigned long long)transactions, bus_ns / 1e6,
+          wall_ns ? 100.0 * bus_ns / wall_ns : 0.0);
+  fflush(out);
+}
@@ -0,0 +1,56 @@
+#ifndef I2C_STATS_H
+#define I2C_STATS_H
+
+// Профиль транзакций I2C (--profile-i2c): число транзакций, системных
+// вызовов, байт и время на шине для каждого датчика и вызова API драйвера.
+// Платформенные слои ULD вызывают i2c_stats_record() после каждой
+// транзакции; без --profile-i2c хуки не подключаются и не стоят ничего.
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Вызов API, к которому относится транзакция. Задаётся демоном перед
+// вызовом драйвера и действует до следующей смены в том же потоке
+typedef enum {
+  I2C_CALL_INIT,        // Загрузка, прошивка, смена адреса
+  I2C_CALL_CONFIG,      // Настройка (для VL53L5CX — записи и чтения DCI)
+  I2C_CALL_START_STOP,  // Запуск и остановка измерений
+  I2C_CALL_CHECK_READY, // Опрос готовности кадра
+  I2C_CALL_READ_FRAME,  // Чтение кадра
+  I2C_CALL_CLEAR_INT,   // Сброс прерывания (VL53L1X)
+  I2C_CALL_OTHER,
+  I2C_CALL_COUNT
+} I2cCall;
+
+typedef struct {
+  uint64_t transactions;
+  uint64_t syscalls;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+  uint64_t errors;
+  uint64_t time_ns; // Суммарное время транзакций
+  uint64_t max_ns;  // Самая долгая транзакция
+} I2cCallStats;
+
+// Включение профиля для sensor_count датчиков. 0 — успех
+int i2c_stats_enable(int sensor_count);
+int i2c_stats_enabled(void);
+
+// Имя датчика в отчёте (строка должна жить до конца работы)
+void i2c_stats_set_name(int sensor, const char *name);
+
+// Датчик и вызов для следующих транзакций текущего потока. Транзакции вне
+// датчиков (sensor < 0) учитываются в строке "bus"
+void i2c_stats_context(int sensor, I2cCall call);
+void i2c_stats_call(I2cCall call);
+
+// Хук платформенных слоёв (VL53L5CX_CommsProfile, VL53L1_CommsProfile)
+void i2c_stats_record(void *ctx, uint16_t i2c_address, uint16_t reg_address,
+                      uint32_t count, int write_not_read, uint32_t syscalls,
+                      int32_t status, uint64_t elapsed_ns);
+
+// Отчёт с момента включения: строка на каждую пару датчик/вызов и итог
+// с долей времени занятости шины
+void i2c_stats_dump(FILE *out);
+
+#endif
@@ -0,0 +1,80 @@
+#include "int_line.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#ifdef SENSORS2SHM_SIM
+#include <wiringPi.h>
+
+int int_line_open(IntLine *line, int pin) {
+  line->pin = pin;
+  line->fd = -1;
+  return 0;
+}
+
+void int_line_close(IntLine *line) { line->pin = -1; }
+
+// Модель не даёт событий: уровень INT проверяется раз в миллисекунду
+int int_line_wait(IntLine *line, int timeout_ms) {
+  for (int waited = 0; waited <= timeout_ms; waited++) {
+    if (digitalRead(line->pin) == LOW)
+      return 1;
+    delay(1);
+  }
+  return 0;
+}
+#else
+#include <linux/gpio.h>
+
+int int_line_open(IntLine *line, int pin) {
+  struct gpioevent_request req;
+
+  line->pin = pin;
+  line->fd = -1;
+  int chip = open(INT_LINE_CHIP, O_RDONLY | O_CLOEXEC);
+  if (chip < 0)
+    return -1;
+
+  memset(&req, 0, sizeof(req));
+  req.lineoffset = (uint32_t)pin;
+  req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+  req.eventflags = GPIOEVENT_REQUEST_FALLING_EDGE;
+  strncpy(req.consumer_label, "sensors2shm", sizeof(req.consumer_label) - 1);
+  int status = ioctl(chip, GPIO_GET_LINEEVENT_IOCTL, &req);
+  close(chip);
+  if (status < 0)
+    return -1;
+  line->fd = req.fd;
+  return 0;
+}
+
+void int_line_close(IntLine *line) {
+  if (line->fd >= 0)
+    close(line->fd);
+  line->fd = -1;
+}
+
+int int_line_wait(IntLine *line, int timeout_ms) {
+  struct gpiohandle_data level;
+  struct gpioevent_data event;
+  struct pollfd pfd = {.fd = line->fd, .events = POLLIN};
+
+  // Кадр мог прийти до начала ожидания: INT уже в низком уровне
+  memset(&level, 0, sizeof(level));
+  if (ioctl(line->fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &level) == 0 &&
+      level.values[0] == 0)
+    return 1;
+
+  int ready = poll(&pfd, 1, timeout_ms);
+  if (ready <= 0)
+    return ready;
+  if (read(line->fd, &event, sizeof(event)) != sizeof(event))
+    return errno == EINTR ? -1 : 1;
+  return 1;
+}
+#endif
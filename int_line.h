@@ -0,0 +1,24 @@
+#ifndef INT_LINE_H
+#define INT_LINE_H
+
+// Линия INT датчика на GPIO (опция int_pin= в конфиге): поток датчика спит
+// в ядре до спада INT вместо опроса готовности по I2C. Линия запрашивается
+// у /dev/gpiochip0 как событие по спаду (номер пина — BCM, как у XSHUT).
+// В симуляторе INT модели читается через digitalRead().
+
+#define INT_LINE_CHIP "/dev/gpiochip0"
+
+typedef struct {
+  int pin;
+  int fd;
+} IntLine;
+
+// 0 — успех
+int int_line_open(IntLine *line, int pin);
+void int_line_close(IntLine *line);
+
+// Ожидание INT: 1 — линия в низком уровне или пришёл спад, 0 — таймаут,
+// -1 — ошибка или прерывание сигналом (errno)
+int int_line_wait(IntLine *line, int timeout_ms);
+
+#endif
@@ -0,0 +1,145 @@
+#include "metrics.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Состояние для среднего периода; как и поля сегмента, у каждого датчика
+// его меняет только опрашивающий поток
+typedef struct {
+  uint64_t last_poll_ns;
+  uint64_t period_sum_ns;
+  uint64_t periods;
+} PollState;
+
+static MetricsRegion *region = NULL;
+static PollState polls[METRICS_MAX_SENSORS];
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static SensorMetrics *sensor_metrics(int sensor) {
+  if (!region || sensor < 0 || sensor >= region->sensor_count)
+    return NULL;
+  return &region->sensors[sensor];
+}
+
+static void store(uint32_t *field, uint32_t value) {
+  __atomic_store_n(field, value, __ATOMIC_RELAXED);
+}
+
+// Увеличение счётчика: писатель у поля один, чтение-запись без lock-префикса
+static void add(uint32_t *field, uint32_t value) {
+  store(field, __atomic_load_n(field, __ATOMIC_RELAXED) + value);
+}
+
+static uint32_t clamp_u32(uint64_t value) {
+  return value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+}
+
+int metrics_open(int sensor_count) {
+  int fd = shm_open(METRICS_SHM_NAME, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return -1;
+
+  // Клиенты только читают сегмент
+  fchmod(fd, 0644);
+  if (ftruncate(fd, sizeof(MetricsRegion)) != 0) {
+    close(fd);
+    return -1;
+  }
+  region = mmap(NULL, sizeof(MetricsRegion), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+  close(fd);
+  if (region == MAP_FAILED) {
+    region = NULL;
+    return -1;
+  }
+
+  memset(region, 0, sizeof(*region));
+  memset(polls, 0, sizeof(polls));
+  region->sensor_count = sensor_count > METRICS_MAX_SENSORS
+                             ? METRICS_MAX_SENSORS
+                             : sensor_count;
+  region->pid = (uint32_t)getpid();
+  region->start_time = (uint32_t)time(NULL);
+  region->version = METRICS_VERSION;
+
+  // magic последним: клиент не примет сегмент до конца заполнения
+  __atomic_store_n(&region->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+  return 0;
+}
+
+void metrics_close(void) {
+  if (!region)
+    return;
+  munmap(region, sizeof(MetricsRegion));
+  region = NULL;
+  shm_unlink(METRICS_SHM_NAME);
+}
+
+void metrics_set_sensor(int sensor, const char *name, uint8_t type) {
+  SensorMetrics *m = sensor_metrics(sensor);
+  if (!m)
+    return;
+  strncpy(m->name, name, sizeof(m->name) - 1);
+  m->type = type;
+}
+
+void metrics_poll(int sensor) {
+  SensorMetrics *m = sensor_metrics(sensor);
+  if (!m)
+    return;
+
+  PollState *p = &polls[sensor];
+  uint64_t now = now_ns();
+  if (p->last_poll_ns) {
+    uint32_t period = clamp_u32(now - p->last_poll_ns);
+    p->period_sum_ns += period;
+    p->periods++;
+    if (!m->loop_min_ns || period < m->loop_min_ns)
+      store(&m->loop_min_ns, period);
+    if (period > m->loop_max_ns)
+      store(&m->loop_max_ns, period);
+    store(&m->loop_avg_ns, clamp_u32(p->period_sum_ns / p->periods));
+  }
+  p->last_poll_ns = now;
+}
+
+void metrics_frame_read(int sensor, uint64_t read_ns) {
+  SensorMetrics *m = sensor_metrics(sensor);
+  if (!m)
+    return;
+  add(&m->frames_read, 1);
+  store(&m->last_read_ns, clamp_u32(read_ns));
+}
+
+void metrics_frame_published(int sensor) {
+  SensorMetrics *m = sensor_metrics(sensor);
+  if (m)
+    add(&m->frames_published, 1);
+}
+
+void metrics_frames_dropped(int sensor, uint32_t count) {
+  SensorMetrics *m = sensor_metrics(sensor);
+  if (m)
+    add(&m->frames_dropped, count);
+}
+
+void metrics_i2c_error(int sensor) {
+  SensorMetrics *m = sensor_metrics(sensor);
+  if (m)
+    add(&m->i2c_errors, 1);
+}
+
+void metrics_corrupted_frame(int sensor) {
+  SensorMetrics *m = sensor_metrics(sensor);
+  if (m)
+    add(&m->corrupted_frames, 1);
+}
@@ -0,0 +1,63 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Счётчики работы демона в shared memory (/sensors2shm_stats): кадры,
+// пропуски, ошибки I2C и период опроса каждого датчика. Демон не пишет
+// журнал, а после daemonize() вывод уходит в никуда — сегмент читает
+// sensors2shm-top или любой клиент.
+//
+// Каждое поле пишет один поток (тот, что опрашивает датчик), отдельными
+// 32-битными атомарными записями без блокировок. Поля независимы: читатель
+// берёт их по одному и не ждёт демон. Счётчики переполняются через 2^32,
+// разность двух чтений по модулю 2^32 остаётся верной.
+
+#include <stdint.h>
+
+#define METRICS_SHM_NAME "/sensors2shm_stats"
+#define METRICS_MAGIC 0x4D533253u // "S2SM"
+#define METRICS_VERSION 1
+#define METRICS_MAX_SENSORS 64
+
+typedef struct {
+  char name[32]; // Имя сегмента датчика (обрезается)
+  uint8_t type;  // SensorType, как sensor_type в SensorData
+  uint8_t reserved[3];
+  uint32_t frames_read;      // Кадров прочитано с датчика
+  uint32_t frames_published; // Кадров записано в shared memory
+  uint32_t frames_dropped;   // Пропуски по счётчику кадров VL53L5CX
+  uint32_t i2c_errors;       // Ошибки опроса готовности и чтения кадра
+  uint32_t corrupted_frames; // Заголовок и окончание кадра не совпали
+  uint32_t last_read_ns;     // Длительность последнего чтения кадра
+  uint32_t loop_min_ns;      // Период опроса датчика с запуска
+  uint32_t loop_avg_ns;
+  uint32_t loop_max_ns;
+  uint32_t reserved2[2];
+} SensorMetrics;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t sensor_count;
+  uint32_t pid;        // Процесс демона
+  uint32_t start_time; // Время запуска (time())
+  SensorMetrics sensors[METRICS_MAX_SENSORS];
+} MetricsRegion;
+
+// Создание сегмента для sensor_count датчиков. 0 — успех; без сегмента
+// остальные функции ничего не делают
+int metrics_open(int sensor_count);
+void metrics_close(void);
+
+void metrics_set_sensor(int sensor, const char *name, uint8_t type);
+
+// Начало очередного опроса датчика: обновляет период min/avg/max
+void metrics_poll(int sensor);
+
+// Кадр прочитан, read_ns — длительность чтения (0 — прочитан модулем ядра)
+void metrics_frame_read(int sensor, uint64_t read_ns);
+void metrics_frame_published(int sensor);
+void metrics_frames_dropped(int sensor, uint32_t count);
+void metrics_i2c_error(int sensor);
+void metrics_corrupted_frame(int sensor);
+
+#endif
@@ -0,0 +1,31 @@
+#include "motion.h"
+
+#include <stdio.h>
+
+int motion_parse_window(const char *text, uint16_t *min_mm,
+                        uint16_t *max_mm) {
+  int low = 0, high = 0, consumed = 0;
+
+  if (sscanf(text, "%d-%d%n", &low, &high, &consumed) != 2 ||
+      text[consumed] != '\0')
+    return -1;
+  if (low < MOTION_MIN_MM || high > MOTION_MAX_MM || high <= low ||
+      high - low > MOTION_MAX_WINDOW_MM)
+    return -1;
+  *min_mm = (uint16_t)low;
+  *max_mm = (uint16_t)high;
+  return 0;
+}
+
+uint8_t motion_count(const MotionParams *params, const uint32_t *motion,
+                     uint8_t aggregates, uint8_t detected) {
+  if (params->threshold == 0)
+    return detected;
+
+  if (aggregates > MOTION_AGGREGATES)
+    aggregates = MOTION_AGGREGATES;
+  uint8_t count = 0;
+  for (int i = 0; i < aggregates; i++)
+    count += motion[i] >= params->threshold;
+  return count;
+}
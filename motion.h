@@ -0,0 +1,63 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+// Индикатор движения VL53L5CX (опция motion= в конфиге): плагин ULD
+// vl53l5cx_plugin_motion_indicator сравнивает гистограммы зон между кадрами
+// на самом датчике в заданном окне расстояний и отдаёт до 32 агрегатов
+// (групп зон) с величиной движения и глобальные индикаторы. Демон
+// публикует их в сегмент <имя>_motion; с publish=motion кадры датчика
+// уходят в shared memory только при движении (и раз в heartbeat_ms), так
+// что новый frame.seq сам служит сигналом движения без сравнения кадров
+// на хосте.
+
+#include <stdint.h>
+
+#include "shm_layout.h"
+
+#define MOTION_MAGIC 0x56533253u // "S2SV"
+#define MOTION_VERSION 1
+#define MOTION_AGGREGATES 32
+
+// Окно расстояний плагина: от 400 до 4000 мм, не шире 1500 мм
+#define MOTION_MIN_MM 400
+#define MOTION_MAX_MM 4000
+#define MOTION_MAX_WINDOW_MM 1500
+#define MOTION_DEFAULT_MIN_MM 400
+#define MOTION_DEFAULT_MAX_MM 1500
+#define MOTION_DEFAULT_AGGREGATES 1
+
+typedef struct {
+  int enabled;
+  uint16_t min_mm;
+  uint16_t max_mm;
+  // Порог величины движения агрегата; 0 — агрегаты, отмеченные датчиком
+  uint32_t threshold;
+  uint8_t min_aggregates; // Агрегатов с движением для сигнала
+} MotionParams;
+
+// Сегмент <имя>_motion, читается по seqlock (shm_seq_read)
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t aggregates;  // Агрегатов в кадре
+  uint8_t detected;    // Агрегатов с движением, отмеченных датчиком
+  uint32_t write_seq;  // Счётчик seqlock, нечётный — идёт запись
+  uint32_t reserved;
+  FrameInfo frame;     // Смещение 16: номер публикации как у <имя>
+  uint32_t global_indicator_1; // Смещение 56
+  uint32_t global_indicator_2; // Смещение 60
+  uint8_t status;              // Смещение 64: статус плагина
+  uint8_t moving;   // Смещение 65: агрегатов выше порога motion_threshold
+  uint16_t reserved2;
+  uint32_t motion[MOTION_AGGREGATES]; // Смещение 68: величина движения
+} MotionData;
+
+// Окно из конфига: "мин-макс" в мм. 0 — успех
+int motion_parse_window(const char *text, uint16_t *min_mm,
+                        uint16_t *max_mm);
+
+// Агрегатов с движением в кадре по порогу params
+uint8_t motion_count(const MotionParams *params, const uint32_t *motion,
+                     uint8_t aggregates, uint8_t detected);
+
+#endif
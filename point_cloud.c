@@ -0,0 +1,96 @@
+#include "point_cloud.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEG_TO_RAD(deg) ((deg) * (float)M_PI / 180.0f)
+
+int cloud_parse_pose(const char *text, CloudPose *pose) {
+  CloudPose p;
+  int consumed = 0;
+
+  if (sscanf(text, "%f,%f,%f,%f,%f,%f%n", &p.x, &p.y, &p.z, &p.roll,
+             &p.pitch, &p.yaw, &consumed) != 6 ||
+      text[consumed] != '\0')
+    return -1;
+  *pose = p;
+  return 0;
+}
+
+// Лучи зон матрицы side x side: центр зоны смещён от оси обзора на
+// (номер + 0.5 - side / 2) шагов по FOV / side в каждом направлении
+static void build_rays(CloudRays *rays, int side, float r[3][3]) {
+  float step = DEG_TO_RAD(CLOUD_FOV_DEG) / side;
+
+  for (int row = 0; row < side; row++) {
+    for (int col = 0; col < side; col++) {
+      float tx = tanf((col + 0.5f - side / 2.0f) * step);
+      float ty = tanf((row + 0.5f - side / 2.0f) * step);
+      float norm = sqrtf(tx * tx + ty * ty + 1.0f);
+      float v[3] = {1.0f / norm, tx / norm, ty / norm};
+      int zone = row * side + col;
+
+      rays->x[zone] = r[0][0] * v[0] + r[0][1] * v[1] + r[0][2] * v[2];
+      rays->y[zone] = r[1][0] * v[0] + r[1][1] * v[1] + r[1][2] * v[2];
+      rays->z[zone] = r[2][0] * v[0] + r[2][1] * v[1] + r[2][2] * v[2];
+    }
+  }
+}
+
+void cloud_pose_rotation(const CloudPose *pose, float r[3][3]) {
+  float cr = cosf(DEG_TO_RAD(pose->roll)), sr = sinf(DEG_TO_RAD(pose->roll));
+  float cp = cosf(DEG_TO_RAD(pose->pitch)), sp = sinf(DEG_TO_RAD(pose->pitch));
+  float cy = cosf(DEG_TO_RAD(pose->yaw)), sy = sinf(DEG_TO_RAD(pose->yaw));
+
+  // Rz(yaw) * Ry(pitch) * Rx(roll)
+  r[0][0] = cy * cp;
+  r[0][1] = cy * sp * sr - sy * cr;
+  r[0][2] = cy * sp * cr + sy * sr;
+  r[1][0] = sy * cp;
+  r[1][1] = sy * sp * sr + cy * cr;
+  r[1][2] = sy * sp * cr - cy * sr;
+  r[2][0] = -sp;
+  r[2][1] = cp * sr;
+  r[2][2] = cp * cr;
+}
+
+void cloud_init(PointCloud *cloud, const CloudPose *pose) {
+  float r[3][3];
+
+  memset(cloud, 0, sizeof(*cloud));
+  cloud->pose = *pose;
+  cloud_pose_rotation(pose, r);
+  build_rays(&cloud->rays_4x4, 4, r);
+  build_rays(&cloud->rays_8x8, 8, r);
+}
+
+void cloud_build(const PointCloud *cloud, const uint16_t *distances,
+                 const uint8_t *statuses, uint8_t resolution, CloudData *out) {
+  const CloudRays *rays =
+      resolution == 16 ? &cloud->rays_4x4 : &cloud->rays_8x8;
+  float x[CLOUD_MAX_POINTS], y[CLOUD_MAX_POINTS], z[CLOUD_MAX_POINTS];
+  int zones = resolution > CLOUD_MAX_POINTS ? CLOUD_MAX_POINTS : resolution;
+
+  // Все зоны без ветвлений, затем только достоверные в выход
+  for (int i = 0; i < zones; i++) {
+    float d = distances[i] * 0.001f;
+    x[i] = cloud->pose.x + d * rays->x[i];
+    y[i] = cloud->pose.y + d * rays->y[i];
+    z[i] = cloud->pose.z + d * rays->z[i];
+  }
+
+  int count = 0;
+  for (int i = 0; i < zones; i++) {
+    if (statuses[i] != 5 && statuses[i] != 9)
+      continue;
+    out->points[count][0] = x[i];
+    out->points[count][1] = y[i];
+    out->points[count][2] = z[i];
+    out->zones[count] = (uint8_t)i;
+    count++;
+  }
+
+  out->resolution = (uint8_t)zones;
+  out->count = (uint8_t)count;
+}
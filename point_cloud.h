@@ -0,0 +1,72 @@
+#ifndef POINT_CLOUD_H
+#define POINT_CLOUD_H
+
+// Облако точек VL53L5CX (опция cloud=on в конфиге): расстояния достоверных
+// зон переводятся в координаты X, Y, Z и публикуются в сегмент
+// <имя>_cloud. Направления лучей зон считаются один раз при старте для
+// 4x4 и 8x8 из поля зрения 45° по стороне (63° по диагонали) и сразу
+// поворачиваются положением датчика (опция pose=); на кадр остаётся одно
+// умножение и сложение на координату без тригонометрии.
+//
+// Система датчика: X — ось обзора, Y — вдоль столбцов зон, Z — вдоль
+// строк; зона 0 в углу -Y, -Z. При нулевом положении датчик смотрит по оси
+// X робота. Расстояние зоны считается вдоль её луча.
+
+#include <stdint.h>
+
+#include "shm_layout.h"
+
+#define CLOUD_MAGIC 0x43533253u // "S2SC"
+#define CLOUD_VERSION 1
+#define CLOUD_MAX_POINTS 64
+
+// Поле зрения VL53L5CX по стороне матрицы, градусы
+#define CLOUD_FOV_DEG 45.0f
+
+// Сегмент <имя>_cloud, читается по seqlock (shm_seq_read)
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t resolution;  // Зон в кадре: 16 или 64
+  uint8_t count;       // Точек в кадре: достоверные зоны (статус 5 или 9)
+  uint32_t write_seq;  // Счётчик seqlock, нечётный — идёт запись
+  uint32_t reserved;
+  FrameInfo frame;     // Смещение 16: номер публикации как у <имя>
+  float points[CLOUD_MAX_POINTS][3]; // Смещение 56: X, Y, Z в метрах
+  uint8_t zones[CLOUD_MAX_POINTS];   // Смещение 824: номер зоны точки
+} CloudData;
+
+// Положение датчика в системе робота: смещение в метрах, повороты в
+// градусах вокруг X (roll), Y (pitch) и Z (yaw), применяются в этом порядке
+typedef struct {
+  float x, y, z;
+  float roll, pitch, yaw;
+} CloudPose;
+
+// Лучи зон после поворота, по координатам (для векторизации)
+typedef struct {
+  float x[CLOUD_MAX_POINTS];
+  float y[CLOUD_MAX_POINTS];
+  float z[CLOUD_MAX_POINTS];
+} CloudRays;
+
+typedef struct {
+  CloudPose pose;
+  CloudRays rays_4x4;
+  CloudRays rays_8x8;
+} PointCloud;
+
+// Положение из конфига: "x,y,z,roll,pitch,yaw". 0 — успех
+int cloud_parse_pose(const char *text, CloudPose *pose);
+
+// Матрица поворота положения: столбцы — оси датчика в системе робота
+void cloud_pose_rotation(const CloudPose *pose, float r[3][3]);
+
+void cloud_init(PointCloud *cloud, const CloudPose *pose);
+
+// Точки кадра из resolution зон в out (без заголовка и frame). Вызывается
+// между shm_seq_write_begin() и shm_seq_write_end()
+void cloud_build(const PointCloud *cloud, const uint16_t *distances,
+                 const uint8_t *statuses, uint8_t resolution, CloudData *out);
+
+#endif
@@ -0,0 +1,212 @@
+#include "polar_map.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RAD_TO_DEG (180.0f / (float)M_PI)
+#define DEG_TO_RAD ((float)M_PI / 180.0f)
+
+// Битовая маска секторов
+#define BIN_WORDS ((POLAR_BINS + 63) / 64)
+
+typedef struct {
+  float position[3];  // Положение датчика в системе робота, м
+  float axis[3];      // Ось обзора в системе робота
+  float tan_half_fov; // Для датчиков с одним расстоянием
+  uint64_t covered[BIN_WORDS]; // Сектора с расстоянием датчика
+} PolarSensor;
+
+PolarMap *polar_map = NULL;
+
+static int sensor_limit = 0;
+static PolarSensor sensors[POLAR_MAX_SENSORS];
+
+// Расстояния каждого датчика по секторам и датчики, видящие сектор
+static uint16_t sensor_range[POLAR_MAX_SENSORS][POLAR_BINS];
+static uint64_t bin_sensors[POLAR_BINS];
+
+// Кадры L5CX на модуле ядра приходят из потоков чтения
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int polar_open(int sensor_count) {
+  int fd = shm_open(POLAR_SHM_NAME, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return -1;
+
+  // Клиенты только читают сегмент
+  fchmod(fd, 0644);
+  if (ftruncate(fd, sizeof(PolarMap)) != 0) {
+    close(fd);
+    return -1;
+  }
+  PolarMap *map =
+      mmap(NULL, sizeof(PolarMap), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return -1;
+
+  memset(map, 0, sizeof(*map));
+  memset(map->range_mm, 0xFF, sizeof(map->range_mm));
+  memset(map->sensor, POLAR_NO_SENSOR, sizeof(map->sensor));
+  memset(sensor_range, 0xFF, sizeof(sensor_range));
+  memset(bin_sensors, 0, sizeof(bin_sensors));
+  memset(sensors, 0, sizeof(sensors));
+  sensor_limit = sensor_count > POLAR_MAX_SENSORS ? POLAR_MAX_SENSORS
+                                                  : sensor_count;
+  map->version = POLAR_VERSION;
+  map->bins = POLAR_BINS;
+
+  // magic последним: клиент не примет сегмент до конца заполнения
+  __atomic_store_n(&map->magic, POLAR_MAGIC, __ATOMIC_RELEASE);
+  polar_map = map;
+  return 0;
+}
+
+void polar_close(void) {
+  if (!polar_map)
+    return;
+  munmap(polar_map, sizeof(PolarMap));
+  polar_map = NULL;
+  shm_unlink(POLAR_SHM_NAME);
+}
+
+void polar_set_sensor(int sensor, const CloudPose *pose, float half_fov_deg) {
+  if (sensor < 0 || sensor >= sensor_limit)
+    return;
+
+  float r[3][3];
+  cloud_pose_rotation(pose, r);
+
+  PolarSensor *s = &sensors[sensor];
+  s->position[0] = pose->x;
+  s->position[1] = pose->y;
+  s->position[2] = pose->z;
+  for (int i = 0; i < 3; i++)
+    s->axis[i] = r[i][0];
+  s->tan_half_fov = tanf(half_fov_deg * DEG_TO_RAD);
+}
+
+// Точка кадра в сектора fresh: сектор точки и соседние, которые закрывает
+// пятно зоны шириной 2 * lateral метров поперёк луча
+static void add_point(uint16_t *fresh, uint64_t *touched, float x, float y,
+                      float lateral) {
+  float range = hypotf(x, y);
+  if (range < 0.001f)
+    return;
+
+  float azimuth = atan2f(y, x) * RAD_TO_DEG;
+  float half = atan2f(lateral, range) * RAD_TO_DEG;
+  int first = (int)floorf(azimuth - half);
+  int last = (int)floorf(azimuth + half);
+  if (last - first >= POLAR_BINS)
+    last = first + POLAR_BINS - 1;
+
+  float mm = range * 1000.0f + 0.5f;
+  uint16_t value = mm >= POLAR_NO_RANGE ? POLAR_NO_RANGE - 1 : (uint16_t)mm;
+  for (int b = first; b <= last; b++) {
+    int bin = ((b % POLAR_BINS) + POLAR_BINS) % POLAR_BINS;
+    if (value < fresh[bin])
+      fresh[bin] = value;
+    touched[bin / 64] |= 1ull << (bin % 64);
+  }
+}
+
+// Ближайшее расстояние сектора по датчикам, которые его видят
+static void update_bin(int bin) {
+  uint16_t best = POLAR_NO_RANGE;
+  uint8_t best_sensor = POLAR_NO_SENSOR;
+
+  for (uint64_t mask = bin_sensors[bin]; mask; mask &= mask - 1) {
+    int sensor = __builtin_ctzll(mask);
+    if (sensor_range[sensor][bin] < best) {
+      best = sensor_range[sensor][bin];
+      best_sensor = (uint8_t)sensor;
+    }
+  }
+  polar_map->range_mm[bin] = best;
+  polar_map->sensor[bin] = best_sensor;
+}
+
+// Сектора кадра датчика в карту: пересчитываются сектора этого и прошлого
+// кадра датчика, остальные не меняются
+static void commit_frame(int sensor, const uint16_t *fresh,
+                         const uint64_t *touched) {
+  PolarSensor *s = &sensors[sensor];
+  uint64_t bit = 1ull << sensor;
+  uint64_t now = now_ns();
+
+  shm_seq_write_begin(&polar_map->write_seq);
+  for (int w = 0; w < BIN_WORDS; w++) {
+    for (uint64_t bins = touched[w] | s->covered[w]; bins; bins &= bins - 1) {
+      int bin = w * 64 + __builtin_ctzll(bins);
+      sensor_range[sensor][bin] = fresh[bin];
+      if (fresh[bin] != POLAR_NO_RANGE)
+        bin_sensors[bin] |= bit;
+      else
+        bin_sensors[bin] &= ~bit;
+      update_bin(bin);
+    }
+    s->covered[w] = touched[w];
+  }
+  polar_map->sensor_ns[sensor] = now;
+  polar_map->update_ns = now;
+  polar_map->updates++;
+  shm_seq_write_end(&polar_map->write_seq);
+}
+
+void polar_update_points(int sensor, const float (*points)[3], int count,
+                         float zone_half_deg) {
+  if (!polar_map || sensor < 0 || sensor >= sensor_limit)
+    return;
+
+  const PolarSensor *s = &sensors[sensor];
+  float tan_half = tanf(zone_half_deg * DEG_TO_RAD);
+  uint16_t fresh[POLAR_BINS];
+  uint64_t touched[BIN_WORDS] = {0};
+
+  memset(fresh, 0xFF, sizeof(fresh));
+  for (int i = 0; i < count; i++) {
+    float dx = points[i][0] - s->position[0];
+    float dy = points[i][1] - s->position[1];
+    float dz = points[i][2] - s->position[2];
+    float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+    add_point(fresh, touched, points[i][0], points[i][1],
+              distance * tan_half);
+  }
+
+  pthread_mutex_lock(&lock);
+  commit_frame(sensor, fresh, touched);
+  pthread_mutex_unlock(&lock);
+}
+
+void polar_update_range(int sensor, uint16_t distance_mm, int valid) {
+  if (!polar_map || sensor < 0 || sensor >= sensor_limit)
+    return;
+
+  const PolarSensor *s = &sensors[sensor];
+  uint16_t fresh[POLAR_BINS];
+  uint64_t touched[BIN_WORDS] = {0};
+
+  memset(fresh, 0xFF, sizeof(fresh));
+  if (valid && distance_mm > 0) {
+    float d = distance_mm * 0.001f;
+    add_point(fresh, touched, s->position[0] + d * s->axis[0],
+              s->position[1] + d * s->axis[1], d * s->tan_half_fov);
+  }
+
+  pthread_mutex_lock(&lock);
+  commit_frame(sensor, fresh, touched);
+  pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,63 @@
+#ifndef POLAR_MAP_H
+#define POLAR_MAP_H
+
+// Полярная карта расстояний вокруг робота (--polar): все датчики по их
+// положению из конфига (опция pose=) сводятся в один сегмент
+// /sensors2shm_polar — 360 секторов по 1°, в каждом ближайшее препятствие
+// от центра робота. Сектор 0 — [0°, 1°) от оси X робота против часовой
+// стрелки к оси Y; поиск ближайшего препятствия в секторе — одно чтение.
+//
+// Каждый датчик хранит свои расстояния по секторам; новый кадр датчика
+// пересчитывает только сектора, которые он покрывал в этом или прошлом
+// кадре: минимум по датчикам, видящим сектор. Кадры из потоков чтения
+// сводятся под мьютексом, сегмент читается по seqlock (shm_seq_read).
+
+#include <stdint.h>
+
+#include "point_cloud.h"
+
+#define POLAR_SHM_NAME "/sensors2shm_polar"
+#define POLAR_MAGIC 0x50533253u // "S2SP"
+#define POLAR_VERSION 1
+#define POLAR_BINS 360
+#define POLAR_MAX_SENSORS 64
+
+// Сектор без препятствия
+#define POLAR_NO_RANGE 0xFFFF
+#define POLAR_NO_SENSOR 255
+
+// Поле зрения VL53L1X (полный угол), градусы
+#define POLAR_L1X_FOV_DEG 27.0f
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t bins;       // POLAR_BINS
+  uint32_t write_seq;  // Счётчик seqlock, нечётный — идёт запись
+  uint32_t updates;    // Кадров, обновивших карту
+  uint64_t update_ns;  // CLOCK_MONOTONIC последнего обновления
+  uint64_t sensor_ns[POLAR_MAX_SENSORS]; // Последний кадр каждого датчика
+  uint16_t range_mm[POLAR_BINS]; // Смещение 536: ближайшее препятствие
+  uint8_t sensor[POLAR_BINS];    // Смещение 1256: датчик этого расстояния
+} PolarMap;
+
+// NULL — карта выключена
+extern PolarMap *polar_map;
+
+// Создание сегмента для sensor_count датчиков. 0 — успех
+int polar_open(int sensor_count);
+void polar_close(void);
+
+// Положение датчика; half_fov_deg — половина поля зрения для датчиков с
+// одним расстоянием (polar_update_range)
+void polar_set_sensor(int sensor, const CloudPose *pose, float half_fov_deg);
+
+// Кадр датчика: точки в системе робота (метры); зона видна под углом
+// ±zone_half_deg от своего луча
+void polar_update_points(int sensor, const float (*points)[3], int count,
+                         float zone_half_deg);
+
+// Кадр датчика с одним расстоянием по оси обзора; valid 0 — препятствия нет
+void polar_update_range(int sensor, uint16_t distance_mm, int valid);
+
+#endif
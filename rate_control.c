@@ -0,0 +1,83 @@
+#include "rate_control.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int rate_parse(const char *text, RateParams *params) {
+  RateParams p = *params;
+  const char *s = text;
+
+  p.count = 0;
+  while (*s) {
+    char *end;
+    if (p.count == RATE_MAX_BANDS)
+      return -1;
+    long mm = strtol(s, &end, 10);
+    if (end == s || *end != ':' || mm < 1 || mm > UINT16_MAX)
+      return -1;
+    s = end + 1;
+    long value = strtol(s, &end, 10);
+    if (end == s || (*end != ',' && *end != '\0') || value < 1 ||
+        value > UINT16_MAX)
+      return -1;
+    if (p.count && mm <= p.below_mm[p.count - 1])
+      return -1;
+    p.below_mm[p.count] = (uint16_t)mm;
+    p.value[p.count] = (uint16_t)value;
+    p.count++;
+    s = *end ? end + 1 : end;
+  }
+  if (p.count == 0)
+    return -1;
+
+  *params = p;
+  return 0;
+}
+
+void rate_init(RateControl *rc, const RateParams *params) {
+  memset(rc, 0, sizeof(*rc));
+  rc->params = *params;
+  rc->band = params->count;
+}
+
+// Первая полоса, граница которой (со сдвигом margin) дальше nearest_mm;
+// count — сцена дальше всех полос
+static uint8_t band_for(const RateParams *p, uint32_t nearest_mm,
+                        uint32_t margin) {
+  uint8_t band = 0;
+  while (band < p->count && nearest_mm >= p->below_mm[band] + margin)
+    band++;
+  return band;
+}
+
+int rate_update(RateControl *rc, uint16_t nearest_mm, uint64_t now_ns,
+                uint8_t *band) {
+  const RateParams *p = &rc->params;
+  // Кадр без достоверных зон — ничего рядом нет
+  uint32_t nearest = nearest_mm ? nearest_mm : UINT32_MAX;
+
+  uint8_t closer = band_for(p, nearest, 0);
+  if (closer < rc->band) {
+    *band = closer;
+    return 1;
+  }
+
+  // Назад — по границе, отодвинутой на гистерезис, после выдержки
+  uint8_t farther = band_for(p, nearest, p->hysteresis_mm);
+  if (farther <= rc->band) {
+    rc->far_since_ns = 0;
+    return 0;
+  }
+  if (rc->far_since_ns == 0)
+    rc->far_since_ns = now_ns;
+  if (now_ns - rc->far_since_ns < (uint64_t)p->hold_ms * 1000000ull)
+    return 0;
+
+  *band = farther;
+  return 1;
+}
+
+void rate_commit(RateControl *rc, uint8_t band) {
+  rc->band = band;
+  rc->far_since_ns = 0;
+}
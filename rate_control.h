@@ -0,0 +1,53 @@
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+// Частота измерений по близости сцены (опции rate_bands=, rate_hysteresis_mm=,
+// rate_hold_ms= в конфиге): пока ничего нет рядом, датчик меряет с базовой
+// частотой (frequency_hz= у VL53L5CX, timing_budget_ms= у VL53L1X), а когда
+// ближайшее достоверное расстояние кадра становится меньше границы полосы,
+// датчик переключается на частоту этой полосы. Быстрее — сразу, на первом
+// же близком кадре; обратно — только когда сцена дальше границы на
+// rate_hysteresis_mm и остаётся там rate_hold_ms, чтобы шум на границе не
+// перезапускал измерения каждый кадр.
+//
+// Значение полосы — частота в Гц у VL53L5CX и бюджет времени в мс у
+// VL53L1X. Полосы задаются по возрастанию границы: "300:15,1000:10".
+
+#include <stdint.h>
+
+#define RATE_MAX_BANDS 4
+
+#define RATE_DEFAULT_HYSTERESIS_MM 100
+#define RATE_DEFAULT_HOLD_MS 1000
+
+typedef struct {
+  uint8_t count;                     // Полос, 0 — выключено
+  uint16_t below_mm[RATE_MAX_BANDS]; // Граница полосы, по возрастанию
+  uint16_t value[RATE_MAX_BANDS];    // Гц VL53L5CX или мс VL53L1X
+  uint16_t hysteresis_mm;
+  uint32_t hold_ms;
+} RateParams;
+
+typedef struct {
+  RateParams params;
+  uint8_t band;          // Текущая полоса, count — базовая частота
+  uint64_t far_since_ns; // Сцена дальше текущей полосы с этого момента
+} RateControl;
+
+// Полосы из конфига: пары граница_мм:значение через запятую, не больше
+// RATE_MAX_BANDS, границы по возрастанию. 0 — успех
+int rate_parse(const char *text, RateParams *params);
+
+void rate_init(RateControl *rc, const RateParams *params);
+
+// Полоса по ближайшему достоверному расстоянию кадра (nearest_mm, 0 — в
+// кадре нет достоверных зон). 1 — пора сменить полосу на *band; текущая
+// полоса не меняется до rate_commit(), пока датчик не перешёл на новую
+// частоту, и при неудаче переход повторится со следующим кадром
+int rate_update(RateControl *rc, uint16_t nearest_mm, uint64_t now_ns,
+                uint8_t *band);
+
+// Датчик перешёл на частоту полосы band
+void rate_commit(RateControl *rc, uint8_t band);
+
+#endif
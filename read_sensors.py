@@ -13,6 +13,72 @@ import sys
 from typing import Dict, Optional
 import posix_ipc
 
+# Сегменты версии 2 и новее: счётчик seqlock write_seq по смещению 240,
+# размер сегмента 248 байт. Демон пишет их без семафора
+SHM_WRITE_SEQ_OFFSET = 240
+SHM_SEQLOCK_SIZE = 248
+
+# Версия 3: сводка кадра по смещению 256 (FrameSummary в shm_layout.h) —
+# маска достоверных зон, их число, зона минимума, min/max/среднее в мм
+SHM_SUMMARY_OFFSET = 256
+SHM_SUMMARY_SIZE = 272
+
+# Версия 4: период измерений датчика в мкс по смещению 244 (0 — неизвестен)
+# и полоса частоты по близости сцены по смещению 248 (255 — базовая частота)
+SHM_PERIOD_OFFSET = 244
+SHM_RATE_BAND_OFFSET = 248
+
+# Облако точек <имя>_cloud (point_cloud.h): заголовок, write_seq по смещению
+# 8, блок frame по смещению 16, точки float32 X, Y, Z с 56, номера зон с 824
+CLOUD_MAGIC = 0x43533253
+CLOUD_WRITE_SEQ_OFFSET = 8
+CLOUD_POINTS_OFFSET = 56
+CLOUD_ZONES_OFFSET = 824
+CLOUD_SIZE = 888
+
+# Сектора <имя>_sectors (sector_map.h, опция sectors=): write_seq по
+# смещению 8, ближайшее расстояние секторов с 56, статусы с 72, зоны с 80,
+# маски зон с 88
+SECTOR_MAGIC = 0x53533253
+SECTOR_WRITE_SEQ_OFFSET = 8
+SECTOR_MIN_OFFSET = 56
+SECTOR_STATUS_OFFSET = 72
+SECTOR_ZONE_OFFSET = 80
+SECTOR_MASKS_OFFSET = 88
+SECTOR_SIZE = 152
+SECTOR_NO_RANGE = 0xFFFF
+
+# Индикатор движения <имя>_motion (motion.h, опция motion=): write_seq по
+# смещению 8, глобальные индикаторы с 56, агрегаты uint32 с 68
+MOTION_MAGIC = 0x56533253
+MOTION_WRITE_SEQ_OFFSET = 8
+MOTION_GLOBAL_OFFSET = 56
+MOTION_AGGREGATES_OFFSET = 68
+MOTION_SIZE = 200
+
+# Стек целей <имя>_targets (target_stack.h, опция targets=): write_seq по
+# смещению 8, найдено целей в зоне с 56, по 4 цели на зону: расстояния
+# uint16 с 120, погрешности uint16 с 632, статусы с 1144
+TARGETS_MAGIC = 0x47533253
+TARGETS_WRITE_SEQ_OFFSET = 8
+TARGETS_DETECTED_OFFSET = 56
+TARGETS_DISTANCE_OFFSET = 120
+TARGETS_SIGMA_OFFSET = 632
+TARGETS_STATUS_OFFSET = 1144
+TARGETS_MAX = 4
+TARGETS_SIZE = 1400
+
+# Полярная карта /sensors2shm_polar (polar_map.h, --polar): 360 секторов по
+# 1°, ближайшее препятствие в мм с 536, номер датчика с 1256
+POLAR_SHM_NAME = "sensors2shm_polar"
+POLAR_MAGIC = 0x50533253
+POLAR_WRITE_SEQ_OFFSET = 8
+POLAR_BINS = 360
+POLAR_RANGE_OFFSET = 536
+POLAR_SENSOR_OFFSET = 1256
+POLAR_SIZE = 1616
+POLAR_NO_RANGE = 0xFFFF
+
 
 # Структура данных датчика (должна соответствовать C структуре)
 class SensorData:
@@ -45,6 +111,29 @@ class SensorData:
             )  # Для обратной совместимости
             self.status = statuses[0] if statuses else 0
 
+        # Сводка демона (версия 3): без неё None
+        self.summary = None
+        if len(data) >= SHM_SUMMARY_SIZE:
+            mask, count, argmin, low, high, mean = struct.unpack_from(
+                "<QBBHHH", data, SHM_SUMMARY_OFFSET
+            )
+            self.summary = {
+                "valid_mask": mask,
+                "valid_count": count,
+                "argmin_zone": argmin,
+                "min_mm": low,
+                "max_mm": high,
+                "mean_mm": mean,
+            }
+
+        # Частота измерений (версия 4): без неё None
+        self.period_us = None
+        self.rate_band = None
+        if len(data) >= SHM_SUMMARY_SIZE and data[7] >= 4:
+            self.period_us, self.rate_band = struct.unpack_from(
+                "<IB", data, SHM_PERIOD_OFFSET
+            )
+
     def __str__(self):
         sensor_names = {0: "VL53L1X", 1: "VL53L5CX", 2: "TCS34725"}
         sensor_name = sensor_names.get(self.sensor_type, f"Unknown({self.sensor_type})")
@@ -98,8 +187,9 @@ class SensorReader:
             print(f"Ошибка открытия семафора {sem_name}: {e}")
             return None
 
-    def open_shared_memory(self, shm_name: str) -> Optional[tuple]:
-        """Открывает shared memory сегмент"""
+    def open_shared_memory(self, shm_name: str, seqlock=False) -> Optional[tuple]:
+        """Открывает shared memory сегмент. seqlock — сегмент нового формата,
+        который читается только по seqlock"""
         try:
             # Открываем shared memory для чтения
             fd = os.open(f"/dev/shm/{shm_name}", os.O_RDONLY)
@@ -112,6 +202,10 @@ class SensorReader:
             mmap_obj = mmap.mmap(fd, size, mmap.MAP_SHARED, mmap.PROT_READ)
 
             print(f"Открыт shared memory: {shm_name} (размер: {size} байт)")
+            if seqlock or size >= SHM_SEQLOCK_SIZE:
+                return (fd, mmap_obj, None)
+
+            # Старый демон пишет сегмент под семафором
             sem = self.open_semaphore(shm_name)
             if not sem:
                 os.close(fd)
@@ -125,6 +219,128 @@ class SensorReader:
             print(f"Ошибка открытия {shm_name}: {e}")
             return None
 
+    def read_snapshot(
+        self, mmap_obj, seq_offset=SHM_WRITE_SEQ_OFFSET, size=SHM_SEQLOCK_SIZE
+    ) -> bytes:
+        """Снимок сегмента по seqlock: копия повторяется, пока счётчик
+        write_seq нечётный или изменился за время копирования"""
+        while True:
+            begin = struct.unpack_from("<I", mmap_obj, seq_offset)[0]
+            if begin & 1:
+                time.sleep(0)
+                continue
+            data = mmap_obj[:size]
+            end = struct.unpack_from("<I", mmap_obj, seq_offset)[0]
+            if begin == end:
+                return data
+
+    def read_cloud(self, shm_name: str) -> Optional[tuple]:
+        """Облако точек датчика (опция cloud=on): номер публикации кадра и
+        список (зона, x, y, z) в метрах"""
+        cloud_name = f"{shm_name}_cloud"
+        if cloud_name not in self.shm_handles:
+            handle = self.open_shared_memory(cloud_name)
+            if handle is None:
+                return None
+            self.shm_handles[cloud_name] = handle
+
+        mmap_obj = self.shm_handles[cloud_name][1]
+        data = self.read_snapshot(mmap_obj, CLOUD_WRITE_SEQ_OFFSET, CLOUD_SIZE)
+        magic, _, _, count = struct.unpack_from("<IHBB", data, 0)
+        if magic != CLOUD_MAGIC:
+            return None
+        seq = struct.unpack_from("<I", data, 16)[0]
+        points = []
+        for i in range(count):
+            x, y, z = struct.unpack_from("<3f", data, CLOUD_POINTS_OFFSET + 12 * i)
+            points.append((data[CLOUD_ZONES_OFFSET + i], x, y, z))
+        return seq, points
+
+    def read_sectors(self, shm_name: str) -> Optional[tuple]:
+        """Сектора датчика (опция sectors=): номер публикации кадра и список
+        (расстояние мм, статус, зона) по секторам; без достоверных зон —
+        (SECTOR_NO_RANGE, 255, 255)"""
+        sectors_name = f"{shm_name}_sectors"
+        if sectors_name not in self.shm_handles:
+            handle = self.open_shared_memory(sectors_name, seqlock=True)
+            if handle is None:
+                return None
+            self.shm_handles[sectors_name] = handle
+
+        mmap_obj = self.shm_handles[sectors_name][1]
+        data = self.read_snapshot(mmap_obj, SECTOR_WRITE_SEQ_OFFSET, SECTOR_SIZE)
+        magic, _, _, count = struct.unpack_from("<IHBB", data, 0)
+        if magic != SECTOR_MAGIC:
+            return None
+        seq = struct.unpack_from("<I", data, 16)[0]
+        ranges = struct.unpack_from(f"<{count}H", data, SECTOR_MIN_OFFSET)
+        sectors = [
+            (ranges[k], data[SECTOR_STATUS_OFFSET + k], data[SECTOR_ZONE_OFFSET + k])
+            for k in range(count)
+        ]
+        return seq, sectors
+
+    def read_motion(self, shm_name: str) -> Optional[dict]:
+        """Индикатор движения датчика (опция motion=): номер публикации кадра,
+        глобальные индикаторы, число агрегатов с движением и их величины"""
+        motion_name = f"{shm_name}_motion"
+        if motion_name not in self.shm_handles:
+            handle = self.open_shared_memory(motion_name, seqlock=True)
+            if handle is None:
+                return None
+            self.shm_handles[motion_name] = handle
+
+        mmap_obj = self.shm_handles[motion_name][1]
+        data = self.read_snapshot(mmap_obj, MOTION_WRITE_SEQ_OFFSET, MOTION_SIZE)
+        magic, _, aggregates, detected = struct.unpack_from("<IHBB", data, 0)
+        if magic != MOTION_MAGIC:
+            return None
+        global_1, global_2, status, moving = struct.unpack_from(
+            "<IIBB", data, MOTION_GLOBAL_OFFSET
+        )
+        return {
+            "seq": struct.unpack_from("<I", data, 16)[0],
+            "global_indicator_1": global_1,
+            "global_indicator_2": global_2,
+            "status": status,
+            "detected": detected,
+            "moving": moving,
+            "motion": list(
+                struct.unpack_from(f"<{aggregates}I", data, MOTION_AGGREGATES_OFFSET)
+            ),
+        }
+
+    def read_targets(self, shm_name: str) -> Optional[tuple]:
+        """Стек целей датчика (опция targets= больше 1): номер публикации
+        кадра и по зонам список целей (расстояние мм, погрешность мм,
+        статус) — только найденные в зоне, в порядке target_order="""
+        targets_name = f"{shm_name}_targets"
+        if targets_name not in self.shm_handles:
+            handle = self.open_shared_memory(targets_name, seqlock=True)
+            if handle is None:
+                return None
+            self.shm_handles[targets_name] = handle
+
+        mmap_obj = self.shm_handles[targets_name][1]
+        data = self.read_snapshot(mmap_obj, TARGETS_WRITE_SEQ_OFFSET, TARGETS_SIZE)
+        magic, _, resolution, targets = struct.unpack_from("<IHBB", data, 0)
+        if magic != TARGETS_MAGIC:
+            return None
+        seq = struct.unpack_from("<I", data, 16)[0]
+        count = resolution * TARGETS_MAX
+        distances = struct.unpack_from(f"<{count}H", data, TARGETS_DISTANCE_OFFSET)
+        sigmas = struct.unpack_from(f"<{count}H", data, TARGETS_SIGMA_OFFSET)
+        zones = []
+        for z in range(resolution):
+            found = min(data[TARGETS_DETECTED_OFFSET + z], targets)
+            zones.append(
+                [
+                    (distances[k], sigmas[k], data[TARGETS_STATUS_OFFSET + k])
+                    for k in range(z * TARGETS_MAX, z * TARGETS_MAX + found)
+                ]
+            )
+        return seq, zones
+
     def read_sensor_data(self, shm_name: str) -> Optional[SensorData]:
         """Читает данные датчика из shared memory"""
         if shm_name not in self.shm_handles:
@@ -134,6 +350,14 @@ class SensorReader:
             self.shm_handles[shm_name] = handle
 
         fd, mmap_obj, sem = self.shm_handles[shm_name]
+        if sem is None:
+            data = self.read_snapshot(
+                mmap_obj, size=min(len(mmap_obj), SHM_SUMMARY_SIZE)
+            )
+            if data[3] == 1 and data[2] == 0:
+                print(f"{shm_name}: Некорректное разрешение (0), пропуск чтения")
+                return None
+            return SensorData(data)
 
         try:
             sem.acquire(timeout=1)  # Ждём максимум 1 сек
@@ -182,13 +406,31 @@ class SensorReader:
             sem.release()
             return None
 
+    def read_polar(self) -> Optional[tuple]:
+        """Полярная карта демона (--polar): расстояния по секторам в мм
+        (POLAR_NO_RANGE — препятствия нет) и номера датчиков"""
+        if POLAR_SHM_NAME not in self.shm_handles:
+            handle = self.open_shared_memory(POLAR_SHM_NAME)
+            if handle is None:
+                return None
+            self.shm_handles[POLAR_SHM_NAME] = handle
+
+        mmap_obj = self.shm_handles[POLAR_SHM_NAME][1]
+        data = self.read_snapshot(mmap_obj, POLAR_WRITE_SEQ_OFFSET, POLAR_SIZE)
+        if struct.unpack_from("<I", data, 0)[0] != POLAR_MAGIC:
+            return None
+        ranges = struct.unpack_from(f"<{POLAR_BINS}H", data, POLAR_RANGE_OFFSET)
+        sensors = data[POLAR_SENSOR_OFFSET : POLAR_SENSOR_OFFSET + POLAR_BINS]
+        return ranges, sensors
+
     def close_shared_memory(self, shm_name: str):
         """Закрывает shared memory сегмент"""
         if shm_name in self.shm_handles:
             fd, mmap_obj, sem = self.shm_handles[shm_name]
             mmap_obj.close()
             os.close(fd)
-            sem.close()
+            if sem is not None:
+                sem.close()
             del self.shm_handles[shm_name]
             print(f"Закрыт shared memory: {shm_name}")
 
@@ -0,0 +1,95 @@
+#include "record.h"
+
+#include <string.h>
+#include <time.h>
+
+// Буфер stdio: записи копятся в памяти и сбрасываются крупными блоками
+#define RECORD_BUFFER_SIZE (256 * 1024)
+
+uint64_t record_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int recorder_open(Recorder *rec, const char *path) {
+  RecordFileHeader fh = {RECORD_MAGIC, RECORD_VERSION, 0};
+
+  memset(rec, 0, sizeof(*rec));
+  rec->file = fopen(path, "wb");
+  if (!rec->file) {
+    perror("Failed to open record file");
+    return -1;
+  }
+  setvbuf(rec->file, NULL, _IOFBF, RECORD_BUFFER_SIZE);
+  pthread_mutex_init(&rec->lock, NULL);
+
+  if (fwrite(&fh, sizeof(fh), 1, rec->file) != 1) {
+    perror("Failed to write record header");
+    fclose(rec->file);
+    rec->file = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+void recorder_close(Recorder *rec) {
+  if (!rec->file)
+    return;
+
+  pthread_mutex_lock(&rec->lock);
+  fclose(rec->file);
+  rec->file = NULL;
+  pthread_mutex_unlock(&rec->lock);
+  pthread_mutex_destroy(&rec->lock);
+}
+
+int recorder_write(Recorder *rec, uint8_t kind, uint8_t sensor,
+                   uint64_t timestamp_ns, const void *data, uint16_t len) {
+  RecordHeader hdr;
+  int status = 0;
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.timestamp_ns = timestamp_ns;
+  hdr.len = len;
+  hdr.kind = kind;
+  hdr.sensor = sensor;
+
+  pthread_mutex_lock(&rec->lock);
+  if (!rec->file || fwrite(&hdr, sizeof(hdr), 1, rec->file) != 1 ||
+      fwrite(data, 1, len, rec->file) != len) {
+    status = -1;
+  } else {
+    if (kind == RECORD_FRAME)
+      rec->frames++;
+    rec->bytes += sizeof(hdr) + len;
+  }
+  pthread_mutex_unlock(&rec->lock);
+  return status;
+}
+
+FILE *record_open_read(const char *path) {
+  RecordFileHeader fh;
+  FILE *file = fopen(path, "rb");
+
+  if (!file) {
+    perror("Failed to open record file");
+    return NULL;
+  }
+  if (fread(&fh, sizeof(fh), 1, file) != 1 || fh.magic != RECORD_MAGIC ||
+      fh.version != RECORD_VERSION) {
+    fprintf(stderr, "%s: not a sensors2shm record (version %d)\n", path,
+            RECORD_VERSION);
+    fclose(file);
+    return NULL;
+  }
+  return file;
+}
+
+int record_read(FILE *file, RecordHeader *hdr, uint8_t *buf) {
+  if (fread(hdr, sizeof(*hdr), 1, file) != 1)
+    return feof(file) ? 0 : -1;
+  if (fread(buf, 1, hdr->len, file) != hdr->len)
+    return -1;
+  return 1;
+}
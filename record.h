@@ -0,0 +1,70 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+// Запись сырых кадров датчиков в двоичный файл и чтение записи для
+// воспроизведения. Формат файла: RecordFileHeader, затем записи
+// RecordHeader + len байт данных. Сначала идут описания датчиков
+// (RECORD_SENSOR), затем кадры (RECORD_FRAME) в порядке чтения.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define RECORD_MAGIC 0x52533253u // "S2SR"
+#define RECORD_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+} RecordFileHeader;
+
+typedef enum { RECORD_SENSOR = 1, RECORD_FRAME = 2 } RecordKind;
+
+typedef struct {
+  uint64_t timestamp_ns; // CLOCK_MONOTONIC: чтение кадра или фронт INT
+  uint16_t len;          // Размер данных после заголовка
+  uint8_t kind;          // RecordKind
+  uint8_t sensor;        // Номер датчика в конфигурации
+  uint32_t reserved;
+} RecordHeader;
+
+// Описание датчика (RECORD_SENSOR), после него — имя shared memory
+typedef struct {
+  uint8_t type;       // SensorType
+  uint8_t resolution; // 16/64 для VL53L5CX, 1 для одиночных датчиков
+  uint8_t targets;    // Целей на зону VL53L5CX, 0 в старых записях — одна
+  uint8_t reserved;
+  uint32_t outputs;    // Маска выходов VL53L5CX (VL53L5CX_OUTPUT_*)
+  uint32_t frame_size; // Размер сырого кадра в байтах
+} RecordSensor;
+
+// Максимальный размер данных одной записи
+#define RECORD_MAX_LEN 0xFFFF
+
+typedef struct {
+  FILE *file;
+  pthread_mutex_t lock; // Кадры пишут основной цикл и потоки чтения
+  uint64_t frames;
+  uint64_t bytes;
+} Recorder;
+
+// Открытие файла записи (лучше на tmpfs: /dev/shm или /run). 0 — успех
+int recorder_open(Recorder *rec, const char *path);
+void recorder_close(Recorder *rec);
+
+// Добавление записи; безопасно из нескольких потоков. 0 — успех
+int recorder_write(Recorder *rec, uint8_t kind, uint8_t sensor,
+                   uint64_t timestamp_ns, const void *data, uint16_t len);
+
+// Открытие записи для воспроизведения с проверкой заголовка
+FILE *record_open_read(const char *path);
+
+// Чтение следующей записи в buf (не меньше RECORD_MAX_LEN байт).
+// 1 — запись прочитана, 0 — конец файла, -1 — ошибка формата
+int record_read(FILE *file, RecordHeader *hdr, uint8_t *buf);
+
+// Монотонное время в нс
+uint64_t record_now_ns(void);
+
+#endif
@@ -0,0 +1,102 @@
+#include "sector_map.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Зона 8x8 в маске
+#define CELL(row, col) (1ull << ((row) * 8 + (col)))
+
+// Зоны 4x4 из масок 8x8: зона 4x4 закрывает квадрат 2x2 зон 8x8
+static uint64_t mask_4x4(uint64_t mask_8x8) {
+  uint64_t mask = 0;
+  for (int row = 0; row < 4; row++)
+    for (int col = 0; col < 4; col++)
+      if (mask_8x8 & (0x303ull << (row * 16 + col * 2)))
+        mask |= 1ull << (row * 4 + col);
+  return mask;
+}
+
+// Сетка cols x rows секторов одинаковой ширины, нумерация по строкам
+static void build_grid(SectorMap *map, int cols, int rows) {
+  for (int row = 0; row < 8; row++)
+    for (int col = 0; col < 8; col++)
+      map->masks_8x8[(row * rows / 8) * cols + col * cols / 8] |=
+          CELL(row, col);
+  map->count = (uint8_t)(cols * rows);
+}
+
+int sector_parse(const char *text, SectorMap *map) {
+  SectorMap m;
+  int a = 0, b = 0, consumed = 0;
+
+  memset(&m, 0, sizeof(m));
+  if (sscanf(text, "cols:%d%n", &a, &consumed) == 1 && !text[consumed]) {
+    if (a < 1 || a > SECTOR_MAX)
+      return -1;
+    build_grid(&m, a, 1);
+  } else if (sscanf(text, "rows:%d%n", &a, &consumed) == 1 &&
+             !text[consumed]) {
+    if (a < 1 || a > SECTOR_MAX)
+      return -1;
+    build_grid(&m, 1, a);
+  } else if (sscanf(text, "grid:%dx%d%n", &a, &b, &consumed) == 2 &&
+             !text[consumed]) {
+    if (a < 1 || b < 1 || a > 8 || b > 8 || a * b > SECTOR_MAX)
+      return -1;
+    build_grid(&m, a, b);
+  } else {
+    // Маски 8x8 через запятую
+    const char *p = text;
+    while (*p) {
+      char *end;
+      if (m.count == SECTOR_MAX)
+        return -1;
+      uint64_t mask = strtoull(p, &end, 16);
+      if (end == p || mask == 0 || (*end != ',' && *end != '\0'))
+        return -1;
+      m.masks_8x8[m.count++] = mask;
+      p = *end ? end + 1 : end;
+    }
+    if (m.count == 0)
+      return -1;
+  }
+
+  for (int k = 0; k < m.count; k++)
+    m.masks_4x4[k] = mask_4x4(m.masks_8x8[k]);
+  *map = m;
+  return 0;
+}
+
+void sector_compute(const SectorMap *map, const uint16_t *distances,
+                    const uint8_t *statuses, uint8_t resolution,
+                    SectorData *out) {
+  const uint64_t *masks =
+      resolution == 16 ? map->masks_4x4 : map->masks_8x8;
+  int zones = resolution > 64 ? 64 : resolution;
+  uint64_t valid = 0;
+
+  // Маска достоверных зон (статус 5 или 9) без ветвлений
+  for (int i = 0; i < zones; i++)
+    valid |= (uint64_t)((statuses[i] == 5) | (statuses[i] == 9)) << i;
+
+  // В каждом секторе обходятся только его достоверные зоны
+  for (int k = 0; k < map->count; k++) {
+    uint16_t best = SECTOR_NO_RANGE;
+    uint8_t zone = SECTOR_NO_ZONE;
+    for (uint64_t m = masks[k] & valid; m; m &= m - 1) {
+      int i = __builtin_ctzll(m);
+      if (distances[i] < best) {
+        best = distances[i];
+        zone = (uint8_t)i;
+      }
+    }
+    out->min_mm[k] = best;
+    out->zone[k] = zone;
+    out->status[k] = zone == SECTOR_NO_ZONE ? SECTOR_NO_STATUS : statuses[zone];
+    out->masks[k] = masks[k];
+  }
+
+  out->resolution = (uint8_t)zones;
+  out->count = map->count;
+}
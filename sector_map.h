@@ -0,0 +1,60 @@
+#ifndef SECTOR_MAP_H
+#define SECTOR_MAP_H
+
+// Ближайшее препятствие по секторам матрицы VL53L5CX (опция sectors= в
+// конфиге): зоны делятся на несколько групп — столбцы слева направо, строки
+// пол/не пол или произвольные маски, — и на каждый кадр в сегмент
+// <имя>_sectors публикуются минимальное достоверное расстояние группы, его
+// статус и зона. Маски зон считаются при разборе конфига для 8x8 и 4x4;
+// на кадр — одна маска достоверных зон и обход её пересечения с маской
+// сектора, клиент читает несколько байт вместо всей матрицы.
+//
+// Зоны нумеруются как в кадре: зона = строка * сторона + столбец. Маски в
+// конфиге задаются для 8x8; зона 4x4 входит в сектор, если в него входит
+// хотя бы одна из четырёх зон 8x8 под ней.
+
+#include <stdint.h>
+
+#include "shm_layout.h"
+
+#define SECTOR_MAGIC 0x53533253u // "S2SS"
+#define SECTOR_VERSION 1
+#define SECTOR_MAX 8
+
+// Сектор без достоверных зон
+#define SECTOR_NO_RANGE 0xFFFF
+#define SECTOR_NO_STATUS 255
+#define SECTOR_NO_ZONE 255
+
+typedef struct {
+  uint8_t count;               // Секторов, 0 — выключено
+  uint64_t masks_8x8[SECTOR_MAX];
+  uint64_t masks_4x4[SECTOR_MAX];
+} SectorMap;
+
+// Сегмент <имя>_sectors, читается по seqlock (shm_seq_read)
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t resolution; // Зон в кадре: 16 или 64
+  uint8_t count;      // Секторов
+  uint32_t write_seq; // Счётчик seqlock, нечётный — идёт запись
+  uint32_t reserved;
+  FrameInfo frame;    // Смещение 16: номер публикации как у <имя>
+  uint16_t min_mm[SECTOR_MAX]; // Смещение 56: SECTOR_NO_RANGE — нет зон
+  uint8_t status[SECTOR_MAX];  // Смещение 72: статус ближайшей зоны
+  uint8_t zone[SECTOR_MAX];    // Смещение 80: номер ближайшей зоны
+  uint64_t masks[SECTOR_MAX];  // Смещение 88: зоны секторов в кадре
+} SectorData;
+
+// Разбиение из конфига: "cols:N", "rows:N", "grid:CxR" (до SECTOR_MAX
+// секторов) или маски 8x8 через запятую ("0xFF,0xFF00"). 0 — успех
+int sector_parse(const char *text, SectorMap *map);
+
+// Сектора кадра из resolution зон в out (без заголовка и frame).
+// Вызывается между shm_seq_write_begin() и shm_seq_write_end()
+void sector_compute(const SectorMap *map, const uint16_t *distances,
+                    const uint8_t *statuses, uint8_t resolution,
+                    SectorData *out);
+
+#endif
@@ -0,0 +1,152 @@
+// sensors2shm-top: счётчики демона из METRICS_SHM_NAME раз в интервал —
+// кадров в секунду (прочитано и опубликовано), пропуски, ошибки I2C,
+// повреждённые кадры, длительность чтения и период опроса каждого датчика.
+// Только читает сегмент, демону не мешает.
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+static const char *type_names[] = {"L1X", "L5CX", "TCS"};
+
+static volatile int running = 1;
+
+static void signal_handler(int sig) { running = 0; }
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint32_t load(const uint32_t *field) {
+  return __atomic_load_n(field, __ATOMIC_RELAXED);
+}
+
+static const MetricsRegion *open_region(void) {
+  int fd = shm_open(METRICS_SHM_NAME, O_RDONLY, 0);
+  if (fd < 0)
+    return NULL;
+
+  const MetricsRegion *region =
+      mmap(NULL, sizeof(MetricsRegion), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (region == MAP_FAILED)
+    return NULL;
+  if (__atomic_load_n(&region->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC ||
+      region->version != METRICS_VERSION) {
+    munmap((void *)region, sizeof(MetricsRegion));
+    return NULL;
+  }
+  return region;
+}
+
+// Счётчики кадров с прошлого отчёта, для кадров в секунду
+typedef struct {
+  uint32_t frames_read;
+  uint32_t frames_published;
+} FrameCounters;
+
+static void save_counters(const MetricsRegion *region, FrameCounters *prev) {
+  for (int i = 0; i < region->sensor_count; i++) {
+    prev[i].frames_read = load(&region->sensors[i].frames_read);
+    prev[i].frames_published = load(&region->sensors[i].frames_published);
+  }
+}
+
+static void print_table(const MetricsRegion *region,
+                        const FrameCounters *prev, double interval_s) {
+  int alive = kill((pid_t)region->pid, 0) == 0;
+  time_t uptime = time(NULL) - (time_t)region->start_time;
+
+  printf("sensors2shm pid %u %s, up %lld s, %u sensors\n", region->pid,
+         alive ? "running" : "NOT RUNNING", (long long)uptime,
+         region->sensor_count);
+  printf("%-20s %-4s %7s %7s %8s %7s %7s %8s %8s %8s %8s\n", "sensor", "type",
+         "read/s", "pub/s", "dropped", "i2c_err", "corrupt", "read_us",
+         "loop_min", "loop_avg", "loop_max");
+
+  for (int i = 0; i < region->sensor_count; i++) {
+    const SensorMetrics *m = &region->sensors[i];
+    uint32_t frames_read = load(&m->frames_read);
+    uint32_t frames_published = load(&m->frames_published);
+
+    printf("%-20.20s %-4s %7.1f %7.1f %8u %7u %7u %8.1f %8.2f %8.2f %8.2f\n",
+           m->name, m->type < 3 ? type_names[m->type] : "?",
+           (uint32_t)(frames_read - prev[i].frames_read) / interval_s,
+           (uint32_t)(frames_published - prev[i].frames_published) /
+               interval_s,
+           load(&m->frames_dropped), load(&m->i2c_errors),
+           load(&m->corrupted_frames), load(&m->last_read_ns) / 1e3,
+           load(&m->loop_min_ns) / 1e6, load(&m->loop_avg_ns) / 1e6,
+           load(&m->loop_max_ns) / 1e6);
+  }
+  printf("loop times in ms\n");
+  fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+  double interval_s = 1.0;
+  int count = 0; // Число отчётов, 0 — до Ctrl+C
+  int opt;
+
+  while ((opt = getopt(argc, argv, "i:n:")) != -1) {
+    switch (opt) {
+    case 'i':
+      interval_s = atof(optarg);
+      break;
+    case 'n':
+      count = atoi(optarg);
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-i SECONDS] [-n COUNT]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (interval_s <= 0) {
+    fprintf(stderr, "Interval must be positive\n");
+    return EXIT_FAILURE;
+  }
+
+  const MetricsRegion *region = open_region();
+  if (!region) {
+    fprintf(stderr, "No metrics in /dev/shm%s: is background_ranging "
+                    "running?\n",
+            METRICS_SHM_NAME);
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGINT, signal_handler);
+  signal(SIGTERM, signal_handler);
+
+  // Экран очищается только в терминале, в файл идут отчёты подряд
+  int tty = isatty(STDOUT_FILENO);
+  FrameCounters prev[METRICS_MAX_SENSORS];
+  uint64_t prev_ns = now_ns();
+  save_counters(region, prev);
+
+  for (int n = 0; running && (count == 0 || n < count); n++) {
+    struct timespec pause = {(time_t)interval_s,
+                             (long)((interval_s - (time_t)interval_s) * 1e9)};
+    nanosleep(&pause, NULL);
+    if (!running)
+      break;
+
+    uint64_t now = now_ns();
+    if (tty)
+      printf("\033[H\033[2J");
+    print_table(region, prev, (now - prev_ns) / 1e9);
+    save_counters(region, prev);
+    prev_ns = now;
+  }
+
+  munmap((void *)region, sizeof(MetricsRegion));
+  return EXIT_SUCCESS;
+}
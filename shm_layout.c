@@ -0,0 +1,136 @@
+#include "shm_layout.h"
+
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+void shm_seq_write_begin(uint32_t *write_seq) {
+  uint32_t seq = *write_seq;
+
+  // Нечётный счётчик виден читателям раньше любых новых данных
+  __atomic_store_n(write_seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void shm_seq_write_end(uint32_t *write_seq) {
+  __atomic_store_n(write_seq, *write_seq + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t shm_seq_read(const uint32_t *write_seq, const void *src, void *dst,
+                      size_t size) {
+  uint32_t retries = 0;
+
+  for (;; retries++) {
+    uint32_t begin = __atomic_load_n(write_seq, __ATOMIC_ACQUIRE);
+    if (begin & 1) {
+      // Запись занимает доли микросекунды; при вытеснении писателя
+      // уступаем процессор
+      if (retries > 100)
+        sched_yield();
+      continue;
+    }
+    memcpy(dst, src, size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(write_seq, __ATOMIC_RELAXED) == begin)
+      return retries;
+  }
+}
+
+void shm_write_begin(SensorData *data) {
+  shm_seq_write_begin(&data->write_seq);
+}
+
+void shm_write_end(SensorData *data) { shm_seq_write_end(&data->write_seq); }
+
+uint32_t shm_read_snapshot(const SensorData *data, SensorData *snap) {
+  return shm_seq_read(&data->write_seq, data, snap, sizeof(*snap));
+}
+
+void shm_fill_single(SensorData *data, uint8_t sensor_type, uint16_t distance,
+                     uint8_t status) {
+  data->timestamp = (uint32_t)time(NULL);
+  data->sensor_type = sensor_type;
+  data->resolution = 1;  // Одиночное измерение
+  data->data_format = 0; // Формат одиночного измерения
+  data->data.single.distance_mm = distance;
+  data->data.single.status = status;
+  shm_summarize(&data->summary, sensor_type, &distance, &status, 1);
+}
+
+void shm_fill_matrix(SensorData *data, uint8_t sensor_type,
+                     const uint16_t *distances, const uint8_t *statuses,
+                     uint8_t resolution) {
+  data->timestamp = (uint32_t)time(NULL);
+  data->sensor_type = sensor_type;
+  data->resolution = resolution; // 16 для 4x4, 64 для 8x8
+  data->data_format = 1;         // Формат матричного измерения
+
+  // Копируем данные матрицы
+  memcpy(data->data.matrix.distances, distances,
+         resolution * sizeof(*distances));
+  memcpy(data->data.matrix.statuses, statuses, resolution);
+  shm_summarize(&data->summary, sensor_type, distances, statuses, resolution);
+}
+
+void shm_publish_frame(SensorData *data, FrameInfo *frame,
+                       uint64_t publish_ns) {
+  frame->seq++;
+  frame->publish_ns = publish_ns;
+  data->reserved = SHM_LAYOUT_VERSION;
+  data->frame = *frame;
+
+  // Счётчик пропусков накапливается, метки относятся только к этому кадру
+  shm_skip_frame(frame);
+}
+
+void shm_skip_frame(FrameInfo *frame) {
+  frame->ready_ns = 0;
+  frame->detect_ns = 0;
+  frame->read_ns = 0;
+}
+
+// Достоверная зона: VL53L5CX — статус 5 или 9, VL53L1X — статус 0
+static inline uint16_t zone_valid(uint8_t sensor_type, uint8_t status) {
+  if (sensor_type == 1)
+    return (status == 5) | (status == 9);
+  return sensor_type == 0 && status == 0;
+}
+
+void shm_summarize(FrameSummary *summary, uint8_t sensor_type,
+                   const uint16_t *distances, const uint8_t *statuses,
+                   uint8_t zones) {
+  uint64_t mask = 0;
+  uint16_t min = UINT16_MAX;
+  uint16_t max = 0;
+  uint32_t sum = 0;
+
+  if (zones > 64)
+    zones = 64;
+
+  // Один проход без ветвлений: недостоверная зона даёт 0xFFFF для min и 0
+  // для max и суммы
+  for (int i = 0; i < zones; i++) {
+    uint16_t valid = zone_valid(sensor_type, statuses[i]);
+    uint16_t keep = (uint16_t)-valid;
+    uint16_t low = distances[i] | (uint16_t)~keep;
+    uint16_t high = distances[i] & keep;
+    min = low < min ? low : min;
+    max = high > max ? high : max;
+    sum += high;
+    mask |= (uint64_t)valid << i;
+  }
+
+  // Первая достоверная зона с минимальным расстоянием
+  uint64_t at_min = 0;
+  for (int i = 0; i < zones; i++)
+    at_min |= (uint64_t)(distances[i] == min) << i;
+  at_min &= mask;
+
+  uint8_t count = (uint8_t)__builtin_popcountll(mask);
+  summary->valid_mask = mask;
+  summary->valid_count = count;
+  summary->argmin_zone = at_min ? (uint8_t)__builtin_ctzll(at_min) : 255;
+  summary->min_mm = count ? min : 0;
+  summary->max_mm = max;
+  summary->mean_mm = count ? (uint16_t)((sum + count / 2) / count) : 0;
+}
@@ -0,0 +1,130 @@
+#ifndef SHM_LAYOUT_H
+#define SHM_LAYOUT_H
+
+// Формат сегментов shared memory, которые публикует демон, и заполнение
+// сегмента. Общий для демона и читателей на C (bench/). Поле reserved
+// заголовка — версия формата: 0 — только SensorData без блока frame,
+// 1 — с блоком FrameInfo после данных, 2 — со счётчиком seqlock, 3 — со
+// сводкой кадра (маска достоверных зон, min/max/среднее), 4 — с текущим
+// периодом измерений датчика.
+// Первые 200 байт не меняются между версиями, старые читатели их читают
+// как раньше.
+//
+// С версии 2 демон не берёт семафор /sem_<имя>: запись защищена счётчиком
+// write_seq (seqlock), и число читателей не влияет на писателя. Семафор
+// по-прежнему создаётся, чтобы старые клиенты могли открыть сегмент.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHM_LAYOUT_VERSION 4
+
+// Путь кадра через демон (CLOCK_MONOTONIC, нс; 0 — этап неизвестен)
+typedef struct {
+  uint32_t seq;     // Номер публикации, растёт на 1 с каждым кадром
+  uint32_t dropped; // Кадров датчика, пропущенных демоном с запуска
+  uint64_t ready_ns;   // Кадр готов на датчике (фронт INT или модель)
+  uint64_t detect_ns;  // Демон увидел готовность (check_data_ready)
+  uint64_t read_ns;    // Кадр прочитан по I2C
+  uint64_t publish_ns; // Кадр записан в shared memory
+} FrameInfo;
+
+// Сводка кадра: достоверные зоны (VL53L5CX — статус 5 или 9, VL53L1X —
+// статус 0) и их расстояния. Без достоверных зон min, max и mean равны 0,
+// argmin_zone — 255
+typedef struct {
+  uint64_t valid_mask; // Бит i — зона i достоверна
+  uint8_t valid_count; // Достоверных зон
+  uint8_t argmin_zone; // Зона с минимальным расстоянием (первая из равных)
+  uint16_t min_mm;
+  uint16_t max_mm;
+  uint16_t mean_mm;
+} FrameSummary;
+
+// Структура данных датчика в shared memory
+typedef struct {
+  uint32_t timestamp;  // Временная метка
+  uint8_t sensor_type; // Тип датчика (0=VL53L1X, 1=VL53L5CX, 2=TCS34725)
+  uint8_t resolution;  // Разрешение (1 для одиночного, 16 для 4x4, 64 для 8x8)
+  uint8_t data_format; // Формат данных (0=одиночное, 1=матрица)
+  uint8_t reserved;    // Версия формата (SHM_LAYOUT_VERSION)
+
+  // Объединение для разных форматов данных
+  union {
+    // Одиночное измерение (VL53L1X, TCS34725)
+    struct {
+      uint16_t distance_mm; // Расстояние в мм
+      uint8_t status;       // Статус измерения
+      uint8_t reserved[5];  // Зарезервировано
+    } single;
+
+    // Матричное измерение (VL53L5CX)
+    struct {
+      uint16_t distances[64]; // Массив расстояний (максимум 8x8)
+      uint8_t statuses[64];   // Массив статусов
+    } matrix;
+  } data;
+
+  // Версия 1: метки времени этапов кадра (смещение 200)
+  FrameInfo frame;
+
+  // Версия 2: счётчик seqlock (смещение 240). Нечётный — идёт запись
+  uint32_t write_seq;
+
+  // Версия 4: период измерений датчика, с которым получен кадр (смещение
+  // 244, мкс; 0 — неизвестен), и полоса частоты по близости сцены (опция
+  // rate_bands=, 0 — ближняя; 255 — базовая частота или опция не задана)
+  uint32_t period_us;
+  uint8_t rate_band;
+  uint8_t reserved3[7];
+
+  // Версия 3: сводка кадра (смещение 256, в одной строке кэша)
+  FrameSummary summary;
+} SensorData;
+
+// Смещения для читателей на других языках
+#define SHM_WRITE_SEQ_OFFSET 240
+#define SHM_PERIOD_OFFSET 244
+#define SHM_RATE_BAND_OFFSET 248
+#define SHM_SUMMARY_OFFSET 256
+
+// Начало и конец записи: между ними write_seq нечётный. Писатель у сегмента
+// один, читатели не ждут его и не задерживают
+void shm_write_begin(SensorData *data);
+void shm_write_end(SensorData *data);
+
+// Снимок сегмента без блокировок: копия повторяется, пока она не попадёт
+// между записями. Возвращает число повторов
+uint32_t shm_read_snapshot(const SensorData *data, SensorData *snap);
+
+// Те же операции для других сегментов демона со своим счётчиком seqlock
+// (облако точек и т. п.): size байт сегмента src копируются в dst
+void shm_seq_write_begin(uint32_t *write_seq);
+void shm_seq_write_end(uint32_t *write_seq);
+uint32_t shm_seq_read(const uint32_t *write_seq, const void *src, void *dst,
+                      size_t size);
+
+// Заполнение данных одиночного измерения и матрицы (resolution зон) вместе
+// со сводкой кадра. Вызываются между shm_write_begin() и shm_write_end()
+void shm_fill_single(SensorData *data, uint8_t sensor_type, uint16_t distance,
+                     uint8_t status);
+void shm_fill_matrix(SensorData *data, uint8_t sensor_type,
+                     const uint16_t *distances, const uint8_t *statuses,
+                     uint8_t resolution);
+
+// Публикация кадра: номер, метка publish_ns и блок frame в сегмент. Метки
+// этапов в frame сбрасываются для следующего кадра, счётчик пропусков
+// накапливается
+void shm_publish_frame(SensorData *data, FrameInfo *frame,
+                       uint64_t publish_ns);
+
+// Кадр прочитан, но не публикуется (publish=changes): метки этапов
+// сбрасываются, как после публикации, номер публикации не меняется
+void shm_skip_frame(FrameInfo *frame);
+
+// Сводка кадра из zones зон; sensor_type — как в SensorData
+void shm_summarize(FrameSummary *summary, uint8_t sensor_type,
+                   const uint16_t *distances, const uint8_t *statuses,
+                   uint8_t zones);
+
+#endif
@@ -0,0 +1,139 @@
+#include "sim_bus.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static SimSensor *sensors[SIM_MAX_SENSORS];
+static int sensor_count = 0;
+
+// Уровни виртуальных пинов XSHUT
+static uint8_t pin_levels[SIM_INT_PIN_OFFSET];
+
+// Шина одна: транзакции выполняются по очереди, как на настоящей шине
+static pthread_mutex_t bus_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t sim_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int sim_add_sensor(SimSensorType type, int xshut_pin) {
+  if (sensor_count >= SIM_MAX_SENSORS || xshut_pin < 0 ||
+      xshut_pin >= SIM_INT_PIN_OFFSET)
+    return -1;
+
+  SimSensor *s = calloc(1, sizeof(SimSensor));
+  if (!s)
+    return -1;
+
+  s->type = type;
+  s->index = sensor_count;
+  s->xshut_pin = xshut_pin;
+
+  // XSHUT с подтяжкой: без управления пином датчик включён
+  s->powered = 1;
+  s->addr = SIM_DEFAULT_ADDR;
+  if (type == SIM_SENSOR_L1X)
+    sim_l1x_reset(s);
+  else
+    sim_l5cx_reset(s);
+  pin_levels[xshut_pin] = 1;
+
+  pthread_mutex_lock(&bus_lock);
+  sensors[sensor_count++] = s;
+  pthread_mutex_unlock(&bus_lock);
+  return s->index;
+}
+
+// Включённый датчик с 7-битным адресом addr (вызывается под bus_lock)
+static SimSensor *find_sensor(uint8_t addr) {
+  for (int i = 0; i < sensor_count; i++) {
+    if (sensors[i]->powered && sensors[i]->addr == addr)
+      return sensors[i];
+  }
+  return NULL;
+}
+
+int sim_bus_probe(uint8_t addr) {
+  pthread_mutex_lock(&bus_lock);
+  int found = find_sensor(addr) != NULL;
+  pthread_mutex_unlock(&bus_lock);
+  return found ? 0 : -1;
+}
+
+int32_t sim_bus_transfer(void *ctx, uint16_t address, uint16_t reg,
+                         uint8_t *data, uint32_t count, int write_not_read) {
+  int status = -1;
+
+  (void)ctx;
+  pthread_mutex_lock(&bus_lock);
+  SimSensor *s = find_sensor(address >> 1);
+  if (s) {
+    if (s->type == SIM_SENSOR_L1X)
+      status = sim_l1x_transfer(s, reg, data, count, write_not_read);
+    else
+      status = sim_l5cx_transfer(s, reg, data, count, write_not_read);
+  }
+  pthread_mutex_unlock(&bus_lock);
+  return status;
+}
+
+uint64_t sim_bus_ready_ns(uint8_t addr) {
+  uint64_t ready_ns = 0;
+
+  pthread_mutex_lock(&bus_lock);
+  SimSensor *s = find_sensor(addr);
+  if (s) {
+    ready_ns = s->type == SIM_SENSOR_L1X ? sim_l1x_ready_ns(s)
+                                         : sim_l5cx_ready_ns(s);
+  }
+  pthread_mutex_unlock(&bus_lock);
+  return ready_ns;
+}
+
+void sim_gpio_write(int pin, int value) {
+  if (pin < 0 || pin >= SIM_INT_PIN_OFFSET)
+    return;
+
+  pthread_mutex_lock(&bus_lock);
+  pin_levels[pin] = value ? 1 : 0;
+  for (int i = 0; i < sensor_count; i++) {
+    SimSensor *s = sensors[i];
+    if (s->xshut_pin != pin || s->powered == pin_levels[pin])
+      continue;
+
+    // Включение — загрузка с адресом по умолчанию и сброшенными регистрами
+    s->powered = pin_levels[pin];
+    if (s->powered) {
+      s->addr = SIM_DEFAULT_ADDR;
+      if (s->type == SIM_SENSOR_L1X)
+        sim_l1x_reset(s);
+      else
+        sim_l5cx_reset(s);
+    }
+  }
+  pthread_mutex_unlock(&bus_lock);
+}
+
+int sim_gpio_read(int pin) {
+  int level = 1;
+
+  if (pin >= 0 && pin < SIM_INT_PIN_OFFSET)
+    return pin_levels[pin];
+
+  // Линия INT: низкий уровень, пока есть непрочитанный кадр
+  pthread_mutex_lock(&bus_lock);
+  for (int i = 0; i < sensor_count; i++) {
+    SimSensor *s = sensors[i];
+    if (s->xshut_pin + SIM_INT_PIN_OFFSET != pin || !s->powered)
+      continue;
+    level = s->type == SIM_SENSOR_L1X ? sim_l1x_int_level(s)
+                                      : sim_l5cx_int_level(s);
+    break;
+  }
+  pthread_mutex_unlock(&bus_lock);
+  return level;
+}
@@ -0,0 +1,104 @@
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+// Программная модель шины I2C с датчиками VL53L1X и VL53L5CX. Позволяет
+// запускать демон без Raspberry Pi: заглушка wiringPi управляет питанием
+// моделей через XSHUT, а драйверы обращаются к моделям через bus_transfer
+// вместо /dev/i2c-1.
+
+#include <stdint.h>
+
+// Максимальное число моделей на шине
+#define SIM_MAX_SENSORS 128
+
+// Виртуальные пины: 0..SIM_INT_PIN_OFFSET-1 — XSHUT, пин XSHUT +
+// SIM_INT_PIN_OFFSET — линия INT того же датчика (активный низкий уровень)
+#define SIM_INT_PIN_OFFSET 1000
+
+// Адрес датчиков после включения питания (7 бит)
+#define SIM_DEFAULT_ADDR 0x29
+
+typedef enum { SIM_SENSOR_L1X, SIM_SENSOR_L5CX } SimSensorType;
+
+// Состояние модели VL53L1X
+typedef struct {
+  uint8_t regs[0x200];
+  int ranging;
+  uint64_t start_ns;
+  uint64_t consumed; // Номер последнего кадра, сброшенного через 0x86
+} SimL1X;
+
+// Запись DCI VL53L5CX (данные в формате хоста)
+typedef struct {
+  uint16_t idx;
+  uint16_t size;
+  uint8_t data[768]; // До 64 порогов плагина detection thresholds
+} SimDciEntry;
+
+#define SIM_L5CX_DCI_ENTRIES 32
+
+// Состояние модели VL53L5CX
+typedef struct {
+  uint8_t page;
+  uint8_t page0[0x100];
+  uint8_t ui[0x400]; // Окно команд 0x2C00..0x2FFF (страница 2)
+  SimDciEntry dci[SIM_L5CX_DCI_ENTRIES];
+  int dci_count;
+  int ranging;
+  int mcu_stopped;
+  uint64_t start_ns;
+  uint64_t frame_idx; // Номер кадра в frame[], 0 — кадра нет
+  uint64_t read_idx;  // Номер последнего прочитанного кадра
+  uint32_t frame_size;
+  uint8_t frame[8192]; // Кадр в формате шины (как его читает драйвер)
+} SimL5CX;
+
+typedef struct {
+  SimSensorType type;
+  int index; // Порядковый номер, задаёт синтетические данные
+  int xshut_pin;
+  int powered;
+  uint8_t addr; // Текущий 7-битный адрес
+  union {
+    SimL1X l1x;
+    SimL5CX l5cx;
+  } m;
+} SimSensor;
+
+// Добавляет модель, питание которой управляется пином xshut_pin.
+// Возвращает номер модели или -1
+int sim_add_sensor(SimSensorType type, int xshut_pin);
+
+// Проверка наличия включённого датчика по 7-битному адресу (0 — найден)
+int sim_bus_probe(uint8_t addr);
+
+// Транзакция I2C: address — 8-битный адрес, reg — 16-битный регистр.
+// Совместима с VL53L5CX_BusTransfer и VL53L1_BusTransfer. 0 — успех
+int32_t sim_bus_transfer(void *ctx, uint16_t address, uint16_t reg,
+                         uint8_t *data, uint32_t count, int write_not_read);
+
+// Время готовности последнего кадра датчика с 7-битным адресом addr
+// (CLOCK_MONOTONIC, нс; 0 — кадров нет). Для замеров задержки демона
+uint64_t sim_bus_ready_ns(uint8_t addr);
+
+// GPIO для заглушки wiringPi
+void sim_gpio_write(int pin, int value);
+int sim_gpio_read(int pin);
+
+// Монотонное время в нс
+uint64_t sim_now_ns(void);
+
+// Модели датчиков (sim_l1x.c, sim_l5cx.c)
+void sim_l1x_reset(SimSensor *s);
+int sim_l1x_transfer(SimSensor *s, uint16_t reg, uint8_t *data,
+                     uint32_t count, int write_not_read);
+int sim_l1x_int_level(SimSensor *s);
+uint64_t sim_l1x_ready_ns(SimSensor *s);
+
+void sim_l5cx_reset(SimSensor *s);
+int sim_l5cx_transfer(SimSensor *s, uint16_t reg, uint8_t *data,
+                      uint32_t count, int write_not_read);
+int sim_l5cx_int_level(SimSensor *s);
+uint64_t sim_l5cx_ready_ns(SimSensor *s);
+
+#endif
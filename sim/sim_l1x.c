@@ -0,0 +1,127 @@
+// Модель регистров VL53L1X: загрузка, смена адреса, запуск/остановка
+// измерений и результаты с периодом, заданным драйвером
+
+#include "sim_bus.h"
+
+#include <string.h>
+
+#define L1X_I2C_SLAVE__DEVICE_ADDRESS 0x0001
+#define L1X_GPIO_HV_MUX__CTRL 0x0030
+#define L1X_GPIO__TIO_HV_STATUS 0x0031
+#define L1X_SYSTEM__INTERMEASUREMENT_PERIOD 0x006C
+#define L1X_SYSTEM__INTERRUPT_CLEAR 0x0086
+#define L1X_SYSTEM__MODE_START 0x0087
+#define L1X_RESULT__RANGE_STATUS 0x0089
+#define L1X_RESULT__OSC_CALIBRATE_VAL 0x00DE
+#define L1X_FIRMWARE__SYSTEM_STATUS 0x00E5
+#define L1X_IDENTIFICATION__MODEL_ID 0x010F
+
+// Сырой статус 9 — «измерение корректно» (статус 0 в API)
+#define L1X_RANGE_STATUS_VALID 9
+
+void sim_l1x_reset(SimSensor *s) {
+  SimL1X *m = &s->m.l1x;
+
+  memset(m, 0, sizeof(*m));
+  m->regs[L1X_GPIO_HV_MUX__CTRL] = 0x01;
+  m->regs[L1X_RESULT__OSC_CALIBRATE_VAL] = 0x01;
+  m->regs[L1X_RESULT__OSC_CALIBRATE_VAL + 1] = 0x00;
+  m->regs[L1X_FIRMWARE__SYSTEM_STATUS] = 0x03;
+  m->regs[L1X_IDENTIFICATION__MODEL_ID] = 0xEA;
+  m->regs[L1X_IDENTIFICATION__MODEL_ID + 1] = 0xCC;
+}
+
+// Период измерений в нс из SYSTEM__INTERMEASUREMENT_PERIOD
+static uint64_t l1x_period_ns(SimL1X *m) {
+  const uint8_t *p = &m->regs[L1X_SYSTEM__INTERMEASUREMENT_PERIOD];
+  uint32_t period = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                    ((uint32_t)p[2] << 8) | p[3];
+  uint32_t osc = ((m->regs[L1X_RESULT__OSC_CALIBRATE_VAL] << 8) |
+                  m->regs[L1X_RESULT__OSC_CALIBRATE_VAL + 1]) &
+                 0x3FF;
+  uint64_t ms = osc ? (uint64_t)(period / (osc * 1.075)) : 0;
+
+  if (ms < 20)
+    ms = 20;
+  if (ms > 1000)
+    ms = 1000;
+  return ms * 1000000ull;
+}
+
+// Число измерений с момента запуска
+static uint64_t l1x_frames(SimL1X *m) {
+  if (!m->ranging)
+    return 0;
+  return (sim_now_ns() - m->start_ns) / l1x_period_ns(m);
+}
+
+// Обновление регистров состояния и результатов перед чтением
+static void l1x_update(SimSensor *s) {
+  SimL1X *m = &s->m.l1x;
+  uint64_t frames = l1x_frames(m);
+  int ready = frames > m->consumed;
+  int polarity = !((m->regs[L1X_GPIO_HV_MUX__CTRL] >> 4) & 1);
+  uint8_t *r = &m->regs[L1X_RESULT__RANGE_STATUS];
+
+  m->regs[L1X_GPIO__TIO_HV_STATUS] = ready ? polarity : !polarity;
+  if (!ready)
+    return;
+
+  // Пилообразное расстояние, своё для каждого датчика
+  uint16_t distance = 400 + 37 * s->index + (frames * 3) % 300;
+  uint16_t ambient = 20;
+  uint16_t signal = 1200;
+
+  memset(r, 0, 17);
+  r[0] = L1X_RANGE_STATUS_VALID;
+  r[3] = 16;
+  r[7] = ambient >> 8;
+  r[8] = ambient & 0xFF;
+  r[13] = distance >> 8;
+  r[14] = distance & 0xFF;
+  r[15] = signal >> 8;
+  r[16] = signal & 0xFF;
+}
+
+int sim_l1x_transfer(SimSensor *s, uint16_t reg, uint8_t *data,
+                     uint32_t count, int write_not_read) {
+  SimL1X *m = &s->m.l1x;
+
+  if ((uint32_t)reg + count > sizeof(m->regs))
+    return -1;
+
+  if (!write_not_read) {
+    l1x_update(s);
+    memcpy(data, &m->regs[reg], count);
+    return 0;
+  }
+
+  memcpy(&m->regs[reg], data, count);
+  for (uint32_t i = 0; i < count; i++) {
+    switch (reg + i) {
+    case L1X_I2C_SLAVE__DEVICE_ADDRESS:
+      s->addr = data[i] & 0x7F;
+      break;
+    case L1X_SYSTEM__INTERRUPT_CLEAR:
+      m->consumed = l1x_frames(m);
+      break;
+    case L1X_SYSTEM__MODE_START:
+      m->ranging = (data[i] & 0x40) != 0;
+      m->start_ns = sim_now_ns();
+      m->consumed = 0;
+      break;
+    }
+  }
+  return 0;
+}
+
+int sim_l1x_int_level(SimSensor *s) {
+  SimL1X *m = &s->m.l1x;
+  return l1x_frames(m) > m->consumed ? 0 : 1;
+}
+
+uint64_t sim_l1x_ready_ns(SimSensor *s) {
+  SimL1X *m = &s->m.l1x;
+  uint64_t frames = l1x_frames(m);
+  return frames ? m->start_ns + frames * l1x_period_ns(m) : 0;
+}
@@ -0,0 +1,464 @@
+// Модель VL53L5CX: страницы регистров, загрузка прошивки, команды DCI через
+// окно 0x2C00..0x2FFF и поток кадров с заголовком, блоками и футером в том
+// формате, который разбирает vl53l5cx_get_ranging_data()
+
+#include "sim_bus.h"
+
+#include <string.h>
+#include <vl53l5cx_api.h>
+#include <vl53l5cx_plugin_detection_thresholds.h>
+
+#define L5CX_PAGE_REG 0x7FFF
+#define L5CX_UI_BASE VL53L5CX_UI_CMD_STATUS
+#define L5CX_UI_SIZE 0x400
+
+// Данные о размере кадра, которые драйвер сверяет после запуска
+#define L5CX_DCI_UI_RANGE_DATA 0x5440
+
+// Ответ на любую команду: [0]=2 (NVM готов), [1]=3 (команда выполнена)
+static const uint8_t ui_status_ok[4] = {0x02, 0x03, 0x00, 0x00};
+
+void sim_l5cx_reset(SimSensor *s) {
+  SimL5CX *m = &s->m.l5cx;
+
+  memset(m, 0, sizeof(*m));
+  m->page0[0x00] = 0xF0; // device_id
+  m->page0[0x01] = 0x02; // revision_id
+  memcpy(m->ui, ui_status_ok, sizeof(ui_status_ok));
+}
+
+// Перестановка байтов в словах по 4 байта (как VL53L5CX_SwapBuffer)
+static void swap_words(uint8_t *buf, uint32_t size) {
+  for (uint32_t i = 0; i + 3 < size; i += 4) {
+    uint8_t b0 = buf[i], b1 = buf[i + 1];
+    buf[i] = buf[i + 3];
+    buf[i + 1] = buf[i + 2];
+    buf[i + 2] = b1;
+    buf[i + 3] = b0;
+  }
+}
+
+static SimDciEntry *dci_find(SimL5CX *m, uint16_t idx, int create) {
+  for (int i = 0; i < m->dci_count; i++) {
+    if (m->dci[i].idx == idx)
+      return &m->dci[i];
+  }
+  if (!create || m->dci_count >= SIM_L5CX_DCI_ENTRIES)
+    return NULL;
+  SimDciEntry *e = &m->dci[m->dci_count++];
+  memset(e, 0, sizeof(*e));
+  e->idx = idx;
+  return e;
+}
+
+// Слово (little-endian) из записи DCI
+static uint32_t dci_word(SimL5CX *m, uint16_t idx, int word) {
+  SimDciEntry *e = dci_find(m, idx, 0);
+  uint32_t v;
+
+  if (!e || e->size < (word + 1) * 4)
+    return 0;
+  memcpy(&v, &e->data[word * 4], 4);
+  return v;
+}
+
+static uint8_t l5cx_resolution(SimL5CX *m) {
+  SimDciEntry *e = dci_find(m, VL53L5CX_DCI_ZONE_CONFIG, 0);
+  uint8_t res = e ? e->data[0] * e->data[1] : 0;
+  return res ? res : VL53L5CX_RESOLUTION_4X4;
+}
+
+// Целей на зону в кадре (PIPE_CONTROL, vl53l5cx_set_nb_targets())
+static uint8_t l5cx_targets(SimL5CX *m) {
+  SimDciEntry *e = dci_find(m, VL53L5CX_DCI_PIPE_CONTROL, 0);
+  return e && e->data[0] ? e->data[0] : 1;
+}
+
+static int l5cx_closest_first(SimL5CX *m) {
+  SimDciEntry *e = dci_find(m, VL53L5CX_DCI_TARGET_ORDER, 0);
+  return e && e->data[0] == VL53L5CX_TARGET_ORDER_CLOSEST;
+}
+
+static uint32_t l5cx_frequency(SimL5CX *m) {
+  SimDciEntry *e = dci_find(m, VL53L5CX_DCI_FREQ_HZ, 0);
+  return e && e->data[1] ? e->data[1] : 1;
+}
+
+// Команда чтения DCI: ответ (заголовок, данные, футер) кладётся в 0x2C04
+static void dci_read(SimL5CX *m, const uint8_t *cmd) {
+  uint16_t idx = (cmd[0] << 8) | cmd[1];
+  uint16_t size = (cmd[2] << 4) | (cmd[3] >> 4);
+  uint8_t *resp = &m->ui[VL53L5CX_UI_CMD_START - L5CX_UI_BASE];
+  SimDciEntry *e = dci_find(m, idx, 0);
+
+  if ((uint32_t)size + 12 > L5CX_UI_SIZE - 4)
+    return;
+
+  memset(resp, 0, size + 12);
+  memcpy(resp, cmd, 4);
+  if (e)
+    memcpy(&resp[4], e->data, size < e->size ? size : e->size);
+
+  // Размер кадра, заданный драйвером в OUTPUT_CONFIG
+  if (idx == L5CX_DCI_UI_RANGE_DATA && size >= 12) {
+    uint16_t frame_size = dci_word(m, VL53L5CX_DCI_OUTPUT_CONFIG, 0);
+    memcpy(&resp[4 + 8], &frame_size, sizeof(frame_size));
+  }
+  swap_words(resp, size + 12);
+}
+
+// Команда записи DCI: заголовок, данные в формате прошивки, футер
+static void dci_write(SimL5CX *m, const uint8_t *buf, uint32_t count) {
+  uint16_t idx = (buf[0] << 8) | buf[1];
+  uint16_t size = (buf[2] << 4) | (buf[3] >> 4);
+  SimDciEntry *e;
+
+  if ((uint32_t)size + 12 != count || size > sizeof(e->data))
+    return;
+  e = dci_find(m, idx, 1);
+  if (!e)
+    return;
+  e->size = size;
+  memcpy(e->data, &buf[4], size);
+  swap_words(e->data, size);
+}
+
+// Запись, заканчивающаяся на 0x2FFF, — команда для прошивки
+static void ui_command(SimL5CX *m, uint16_t reg, uint32_t count) {
+  const uint8_t *buf = &m->ui[reg - L5CX_UI_BASE];
+
+  if (count == 4 && buf[1] == 0x03) {
+    // Запуск измерений
+    m->ranging = 1;
+    m->start_ns = sim_now_ns();
+    m->frame_idx = 0;
+    m->read_idx = 0;
+    m->frame_size = dci_word(m, VL53L5CX_DCI_OUTPUT_CONFIG, 0);
+  } else if (count == 12 && buf[9] == 0x02) {
+    dci_read(m, buf);
+  } else if (count > 12 && buf[count - 4] == 0x05 && buf[count - 3] == 0x01) {
+    dci_write(m, buf, count);
+  } else {
+    // NVM, калибровки и конфигурация по умолчанию: ответ из нулей
+    memset(&m->ui[VL53L5CX_UI_CMD_START - L5CX_UI_BASE], 0,
+           VL53L5CX_NVM_DATA_SIZE);
+  }
+  memcpy(m->ui, ui_status_ok, sizeof(ui_status_ok));
+}
+
+// Блоки с несколькими целями на зону приходят по другим адресам
+static uint16_t single_target_idx(uint16_t idx) {
+  switch (idx) {
+  case VL53L5CX_MT_NB_TARGET_DETECTED_IDX:
+    return VL53L5CX_NB_TARGET_DETECTED_IDX;
+  case VL53L5CX_MT_SIGNAL_RATE_IDX:
+    return VL53L5CX_SIGNAL_RATE_IDX;
+  case VL53L5CX_MT_RANGE_SIGMA_MM_IDX:
+    return VL53L5CX_RANGE_SIGMA_MM_IDX;
+  case VL53L5CX_MT_DISTANCE_IDX:
+    return VL53L5CX_DISTANCE_IDX;
+  case VL53L5CX_MT_REFLECTANCE_EST_PC_IDX:
+    return VL53L5CX_REFLECTANCE_EST_PC_IDX;
+  case VL53L5CX_MT_TARGET_STATUS_IDX:
+    return VL53L5CX_TARGET_STATUS_IDX;
+  case VL53L5CX_MT_MOTION_DETEC_IDX:
+    return VL53L5CX_MOTION_DETEC_IDX;
+  default:
+    return idx;
+  }
+}
+
+// Сцена зоны: стена и стекло на полпути до неё со слабым сигналом. Цели
+// идут по target_order: самая сильная первой (по умолчанию) или ближняя
+#define SIM_SCENE_TARGETS 2
+
+// Значение элемента блока для цели target зоны zone
+static uint32_t block_value(SimSensor *s, uint16_t idx, uint32_t zone,
+                            uint32_t target, uint64_t frame) {
+  uint32_t wall = 300 + 50 * s->index + 8 * zone + (frame * 5) % 200;
+  int glass = target == (uint32_t)l5cx_closest_first(&s->m.l5cx) ? 0 : 1;
+
+  if (target >= SIM_SCENE_TARGETS && idx != VL53L5CX_NB_TARGET_DETECTED_IDX &&
+      idx != VL53L5CX_AMBIENT_RATE_IDX && idx != VL53L5CX_SPAD_COUNT_IDX)
+    return 0;
+  switch (idx) {
+  case VL53L5CX_DISTANCE_IDX:
+    return (glass ? wall / 2 : wall) * 4;
+  case VL53L5CX_TARGET_STATUS_IDX:
+    return 5;
+  case VL53L5CX_NB_TARGET_DETECTED_IDX: {
+    uint8_t targets = l5cx_targets(&s->m.l5cx);
+    return targets < SIM_SCENE_TARGETS ? targets : SIM_SCENE_TARGETS;
+  }
+  case VL53L5CX_AMBIENT_RATE_IDX:
+    return 10 * 2048;
+  case VL53L5CX_SPAD_COUNT_IDX:
+    return 200;
+  case VL53L5CX_SIGNAL_RATE_IDX:
+    return (glass ? 300 : 1000) * 2048;
+  case VL53L5CX_RANGE_SIGMA_MM_IDX:
+    return (glass ? 12 : 5) * 128;
+  case VL53L5CX_REFLECTANCE_EST_PC_IDX:
+    return (glass ? 10 : 40) * 2;
+  default:
+    return 0;
+  }
+}
+
+// Блок индикатора движения (поле motion_indicator результатов): раз в 100
+// кадров на 15 кадров «человек» проходит через 4 соседних агрегата, от
+// прохода к проходу смещаясь. Число агрегатов — из конфигурации плагина,
+// без неё движения нет. Датчик отдаёт motion, умноженное на 65535
+#define L5CX_MOTION_SIZE 140
+
+static void motion_block(SimSensor *s, uint64_t frame, uint8_t *out) {
+  SimDciEntry *cfg =
+      dci_find(&s->m.l5cx, VL53L5CX_DCI_MOTION_DETECTOR_CFG, 0);
+  uint32_t aggregates = cfg ? cfg->data[20] : 0;
+  uint32_t words[L5CX_MOTION_SIZE / 4] = {0};
+  uint32_t detected = 0;
+
+  if (aggregates > 32)
+    aggregates = 32;
+  if (aggregates && frame % 100 < 15) {
+    uint32_t first = (uint32_t)(frame / 100 + s->index) % aggregates;
+    detected = aggregates < 4 ? aggregates : 4;
+    for (uint32_t i = 0; i < detected; i++)
+      words[3 + (first + i) % aggregates] = 200 * 65535u;
+    words[0] = detected * 200; // global_indicator_1
+  }
+  // status, nb_of_detected_aggregates, nb_of_aggregates, spare
+  words[2] = detected << 8 | aggregates << 16;
+  memcpy(out, words, sizeof(words));
+}
+
+// Сборка кадра frame: блоки в порядке OUTPUT_LIST для включённых выходов
+static void build_frame(SimSensor *s, uint64_t frame) {
+  SimL5CX *m = &s->m.l5cx;
+  uint8_t *buf = m->frame;
+  uint32_t size = m->frame_size;
+  uint32_t enables = dci_word(m, VL53L5CX_DCI_OUTPUT_ENABLES, 0);
+  uint8_t resolution = l5cx_resolution(m);
+  uint32_t pos = 16;
+  uint8_t motion[L5CX_MOTION_SIZE];
+
+  motion_block(s, frame, motion);
+  memset(buf, 0, size);
+  buf[0] = 0x10;
+  buf[1] = 0x05;
+  buf[2] = 0x05;
+  buf[3] = (frame - 1) % 255; // streamcount, 255 не используется
+  buf[8] = (frame >> 8) & 0xFF;
+  buf[9] = frame & 0xFF;
+
+  for (int i = 1; i < 12 && pos + 4 <= size - 12; i++) {
+    uint32_t header = dci_word(m, VL53L5CX_DCI_OUTPUT_LIST, i);
+    uint32_t type = header & 0xF;
+    uint32_t count = (header >> 4) & 0xFFF;
+    uint16_t idx = single_target_idx(header >> 16);
+    // Для типов 2..0xC size — число элементов по type байт, иначе — байты
+    uint32_t elem = (type > 1 && type < 0xD) ? type : 1;
+    uint32_t targets = count / resolution ? count / resolution : 1;
+
+    if (!(enables & (1u << i)) || header == 0)
+      continue;
+
+    memcpy(&buf[pos], &header, 4);
+    pos += 4;
+    for (uint32_t e = 0; e < count && pos + elem <= size - 12; e++) {
+      uint32_t v = idx == VL53L5CX_MOTION_DETEC_IDX
+                       ? (e < L5CX_MOTION_SIZE ? motion[e] : 0)
+                       : block_value(s, idx, e / targets, e % targets, frame);
+      memcpy(&buf[pos], &v, elem);
+      pos += elem;
+    }
+  }
+
+  // Футер: номер кадра совпадает с заголовком
+  buf[size - 4] = (frame >> 8) & 0xFF;
+  buf[size - 3] = frame & 0xFF;
+  swap_words(buf, size);
+}
+
+// Номер текущего кадра по частоте измерений (0 — кадров ещё нет)
+static uint64_t l5cx_frames(SimL5CX *m) {
+  if (!m->ranging || m->mcu_stopped)
+    return m->frame_idx;
+  return (sim_now_ns() - m->start_ns) * l5cx_frequency(m) / 1000000000ull;
+}
+
+static int page2_read(SimSensor *s, uint16_t reg, uint8_t *data,
+                      uint32_t count) {
+  SimL5CX *m = &s->m.l5cx;
+
+  if (reg >= L5CX_UI_BASE) {
+    if ((uint32_t)reg + count > L5CX_UI_BASE + L5CX_UI_SIZE)
+      return -1;
+    memcpy(data, &m->ui[reg - L5CX_UI_BASE], count);
+    return 0;
+  }
+
+  // Кадр по адресу 0
+  uint64_t frame = l5cx_frames(m);
+  if (frame == 0 || m->frame_size < 40 || m->frame_size > sizeof(m->frame)) {
+    memset(data, 0, count);
+    return 0;
+  }
+  if (frame != m->frame_idx) {
+    build_frame(s, frame);
+    m->frame_idx = frame;
+  }
+  memset(data, 0, count);
+  if (reg < m->frame_size)
+    memcpy(data, &m->frame[reg],
+           reg + count > m->frame_size ? m->frame_size - reg : count);
+  if (reg == 0 && count >= m->frame_size)
+    m->read_idx = frame;
+  return 0;
+}
+
+static int page0_read(SimL5CX *m, uint16_t reg, uint8_t *data,
+                      uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t r = reg + i;
+    if (r == 0x06)
+      data[i] = m->mcu_stopped ? 0x81 : 0x01; // GO2 status 0: MCU загружен
+    else if (r == 0x07)
+      data[i] = m->mcu_stopped ? 0x84 : 0x00; // GO2 status 1
+    else
+      data[i] = r < sizeof(m->page0) ? m->page0[r] : 0;
+  }
+  return 0;
+}
+
+static void page0_write(SimSensor *s, uint16_t reg, const uint8_t *data,
+                        uint32_t count) {
+  SimL5CX *m = &s->m.l5cx;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t r = reg + i;
+    if (r >= sizeof(m->page0))
+      continue;
+    m->page0[r] = data[i];
+    if (r == 0x04) {
+      s->addr = data[i] & 0x7F;
+    } else if (r == 0x14) {
+      // Остановка MCU из vl53l5cx_stop_ranging()
+      if (data[i] == 0x01 && m->ranging) {
+        m->frame_idx = l5cx_frames(m);
+        m->ranging = 0;
+      }
+      m->mcu_stopped = data[i] == 0x01;
+    }
+  }
+}
+
+int sim_l5cx_transfer(SimSensor *s, uint16_t reg, uint8_t *data,
+                      uint32_t count, int write_not_read) {
+  SimL5CX *m = &s->m.l5cx;
+
+  if (reg == L5CX_PAGE_REG) {
+    if (write_not_read)
+      m->page = data[0];
+    else
+      data[0] = m->page;
+    return 0;
+  }
+
+  if (!write_not_read) {
+    switch (m->page) {
+    case 0:
+      return page0_read(m, reg, data, count);
+    case 1:
+      memset(data, 0, count);
+      if (reg <= 0x21 && reg + count > 0x21)
+        data[0x21 - reg] = 0x10; // Доступ к прошивке открыт
+      return 0;
+    case 2:
+      return page2_read(s, reg, data, count);
+    default:
+      memset(data, 0, count);
+      return 0;
+    }
+  }
+
+  switch (m->page) {
+  case 0:
+    page0_write(s, reg, data, count);
+    break;
+  case 2:
+    if (reg >= L5CX_UI_BASE) {
+      if ((uint32_t)reg + count > L5CX_UI_BASE + L5CX_UI_SIZE)
+        return -1;
+      memcpy(&m->ui[reg - L5CX_UI_BASE], data, count);
+      if ((uint32_t)reg + count == VL53L5CX_UI_CMD_END + 1u)
+        ui_command(m, reg, count);
+    }
+    break;
+  default:
+    // Страницы 9..0x0b — загрузка прошивки, остальные не моделируются
+    break;
+  }
+  return 0;
+}
+
+// Пороги плагина detection thresholds: сработал ли порог расстояния в
+// кадре frame. Остальные величины модель не проверяет
+static int thresholds_hit(SimSensor *s, uint64_t frame) {
+  SimL5CX *m = &s->m.l5cx;
+  SimDciEntry *global = dci_find(m, VL53L5CX_DCI_DET_THRESH_GLOBAL_CONFIG, 0);
+  SimDciEntry *list = dci_find(m, VL53L5CX_DCI_DET_THRESH_START, 0);
+  int hit = 0;
+
+  if (!global || !global->data[1] || !list)
+    return 1;
+  for (int i = 0; i < VL53L5CX_NB_THRESHOLDS; i++) {
+    VL53L5CX_DetectionThresholds t;
+    memcpy(&t, &list->data[i * sizeof(t)], sizeof(t));
+    uint8_t zone = t.zone_num & ~VL53L5CX_LAST_THRESHOLD;
+    int32_t v = (int32_t)block_value(s, VL53L5CX_DISTANCE_IDX, zone, 0, frame);
+    int zone_hit = 0;
+    if (t.measurement == VL53L5CX_DISTANCE_MM) {
+      switch (t.type) {
+      case VL53L5CX_IN_WINDOW:
+        zone_hit = v >= t.param_low_thresh && v <= t.param_high_thresh;
+        break;
+      case VL53L5CX_OUT_OF_WINDOW:
+        zone_hit = v < t.param_low_thresh || v > t.param_high_thresh;
+        break;
+      case VL53L5CX_LESS_THAN_EQUAL_MIN_CHECKER:
+        zone_hit = v <= t.param_low_thresh;
+        break;
+      case VL53L5CX_GREATER_THAN_MAX_CHECKER:
+        zone_hit = v > t.param_high_thresh;
+        break;
+      }
+    }
+    if (i > 0 && t.mathematic_operation == VL53L5CX_OPERATION_AND)
+      hit &= zone_hit;
+    else
+      hit |= zone_hit;
+    if (t.zone_num & VL53L5CX_LAST_THRESHOLD)
+      break;
+  }
+  return hit;
+}
+
+// INT: низкий уровень, пока есть непрочитанный кадр; с порогами — только
+// если порог сработал в последнем кадре
+int sim_l5cx_int_level(SimSensor *s) {
+  SimL5CX *m = &s->m.l5cx;
+  uint64_t frames = l5cx_frames(m);
+  return frames > m->read_idx && thresholds_hit(s, frames) ? 0 : 1;
+}
+
+uint64_t sim_l5cx_ready_ns(SimSensor *s) {
+  SimL5CX *m = &s->m.l5cx;
+  uint64_t frames = l5cx_frames(m);
+  uint32_t hz = l5cx_frequency(m);
+
+  if (!frames || !m->ranging)
+    return 0;
+  // Кадр n готов в момент start + n / частота (округление вверх)
+  return m->start_ns + (frames * 1000000000ull + hz - 1) / hz;
+}
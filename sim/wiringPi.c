@@ -0,0 +1,22 @@
+#include "wiringPi.h"
+#include "sim_bus.h"
+
+#include <time.h>
+
+int wiringPiSetupGpio(void) { return 0; }
+
+void pinMode(int pin, int mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(int pin, int value) { sim_gpio_write(pin, value); }
+
+int digitalRead(int pin) { return sim_gpio_read(pin); }
+
+void delay(unsigned int ms) {
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000L;
+  nanosleep(&ts, NULL);
+}
@@ -0,0 +1,22 @@
+#ifndef SIM_WIRINGPI_H
+#define SIM_WIRINGPI_H
+
+// Заглушка wiringPi для сборки с симулятором: пины XSHUT управляют питанием
+// моделей датчиков, чтение пина XSHUT + SIM_INT_PIN_OFFSET возвращает INT
+
+#define INPUT 0
+#define OUTPUT 1
+
+#define LOW 0
+#define HIGH 1
+
+// Номера пинов виртуальные, настоящего ограничения 0..40 нет
+#define GPIO_PIN_MAX 999
+
+int wiringPiSetupGpio(void);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void delay(unsigned int ms);
+
+#endif
@@ -0,0 +1,34 @@
+#include "target_stack.h"
+
+#include <string.h>
+
+void target_stack_fill(TargetStack *out, const int16_t *distance_mm,
+                       const uint16_t *sigma_mm, const uint8_t *status,
+                       const uint8_t *detected, uint8_t resolution,
+                       uint8_t targets) {
+  if (resolution > TARGET_STACK_ZONES)
+    resolution = TARGET_STACK_ZONES;
+  if (targets > TARGET_STACK_MAX)
+    targets = TARGET_STACK_MAX;
+
+  out->resolution = resolution;
+  out->targets = targets;
+  memset(out->detected, 0, sizeof(out->detected));
+  memset(out->distance_mm, 0, sizeof(out->distance_mm));
+  memset(out->sigma_mm, 0, sizeof(out->sigma_mm));
+  memset(out->status, 255, sizeof(out->status));
+  if (detected)
+    memcpy(out->detected, detected, resolution);
+
+  // Шаг зоны в ULD — заданное число целей, в сегменте — всегда четыре
+  for (int z = 0; z < resolution; z++) {
+    for (int t = 0; t < targets; t++) {
+      int from = z * targets + t;
+      int to = z * TARGET_STACK_MAX + t;
+      out->distance_mm[to] = (uint16_t)distance_mm[from];
+      out->status[to] = status[from];
+      if (sigma_mm)
+        out->sigma_mm[to] = sigma_mm[from];
+    }
+  }
+}
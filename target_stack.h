@@ -0,0 +1,51 @@
+#ifndef TARGET_STACK_H
+#define TARGET_STACK_H
+
+// Несколько целей на зону VL53L5CX (опция targets= в конфиге): датчик
+// отдаёт до четырёх целей в каждой зоне — стекло и стену за ним, край
+// стола и пол — в порядке target_order= (ближняя или самая сильная
+// первой). В основной сегмент <имя> уходит первая цель зоны, стек целей
+// целиком — в сегмент <имя>_targets. Буферы ULD рассчитаны на четыре цели,
+// по I2C передаётся только заданное число.
+//
+// Цель t зоны z в сегменте — индекс z * TARGET_STACK_MAX + t при любом
+// числе целей; цели сверх найденных в зоне имеют статус 255.
+
+#include <stdint.h>
+
+#include "shm_layout.h"
+
+#define TARGET_STACK_MAGIC 0x47533253u // "S2SG"
+#define TARGET_STACK_VERSION 1
+#define TARGET_STACK_MAX 4
+#define TARGET_STACK_ZONES 64
+
+// Сегмент <имя>_targets, читается по seqlock (shm_seq_read)
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t resolution; // Зон в кадре: 16 или 64
+  uint8_t targets;    // Целей на зону (опция targets=)
+  uint32_t write_seq; // Счётчик seqlock, нечётный — идёт запись
+  uint32_t reserved;
+  FrameInfo frame;    // Смещение 16: номер публикации как у <имя>
+  // Смещение 56: целей найдено в зоне (0 и при выключенном выходе)
+  uint8_t detected[TARGET_STACK_ZONES];
+  // Смещение 120: расстояние, мм
+  uint16_t distance_mm[TARGET_STACK_ZONES * TARGET_STACK_MAX];
+  // Смещение 632: оценка погрешности расстояния, мм (0 — выход выключен)
+  uint16_t sigma_mm[TARGET_STACK_ZONES * TARGET_STACK_MAX];
+  // Смещение 1144: статус цели (5 и 9 — достоверна)
+  uint8_t status[TARGET_STACK_ZONES * TARGET_STACK_MAX];
+} TargetStack;
+
+// Стек целей кадра в out (без заголовка и frame) из массивов результатов
+// ULD, где цель t зоны z — индекс z * targets + t. sigma_mm и detected —
+// NULL, если выход выключен. Вызывается между shm_seq_write_begin() и
+// shm_seq_write_end()
+void target_stack_fill(TargetStack *out, const int16_t *distance_mm,
+                       const uint16_t *sigma_mm, const uint8_t *status,
+                       const uint8_t *detected, uint8_t resolution,
+                       uint8_t targets);
+
+#endif
@@ -0,0 +1,82 @@
+#include "trace.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+TraceRing *trace_ring = NULL;
+
+static size_t ring_size = 0;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int trace_open(uint32_t records, int sensor_count) {
+  uint32_t capacity = TRACE_MIN_RECORDS;
+  while (capacity < records && capacity < TRACE_MAX_RECORDS)
+    capacity <<= 1;
+
+  // Снимок прошлого запуска заменяется новым кольцом
+  shm_unlink(TRACE_SHM_NAME);
+  int fd = shm_open(TRACE_SHM_NAME, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return -1;
+
+  size_t size = sizeof(TraceRing) + (size_t)capacity * sizeof(TraceRecord);
+  fchmod(fd, 0644);
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    return -1;
+  }
+  TraceRing *ring =
+      mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED)
+    return -1;
+
+  // Файл после ftruncate заполнен нулями: все записи пустые (seq 0)
+  ring->version = TRACE_VERSION;
+  ring->sensor_count = sensor_count > TRACE_MAX_SENSORS ? TRACE_MAX_SENSORS
+                                                        : sensor_count;
+  ring->capacity = capacity;
+  __atomic_store_n(&ring->magic, TRACE_MAGIC, __ATOMIC_RELEASE);
+
+  ring_size = size;
+  trace_ring = ring;
+  return 0;
+}
+
+void trace_close(void) {
+  if (!trace_ring)
+    return;
+  TraceRing *ring = trace_ring;
+  trace_ring = NULL;
+  munmap(ring, ring_size);
+}
+
+void trace_set_sensor(int sensor, const char *name) {
+  if (trace_ring && sensor >= 0 && sensor < trace_ring->sensor_count)
+    strncpy(trace_ring->names[sensor], name,
+            sizeof(trace_ring->names[sensor]) - 1);
+}
+
+void trace_record(uint8_t sensor, uint8_t event, uint16_t arg,
+                  uint64_t timestamp_ns) {
+  uint32_t index = __atomic_fetch_add(&trace_ring->head, 1, __ATOMIC_RELAXED);
+  TraceRecord *r = &trace_ring->records[index & (trace_ring->capacity - 1)];
+
+  // Запись помечается недописанной раньше, чем меняются её поля
+  __atomic_store_n(&r->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  r->timestamp_ns = timestamp_ns ? timestamp_ns : now_ns();
+  r->sensor = sensor;
+  r->event = event;
+  r->arg = arg;
+  __atomic_store_n(&r->seq, index + 1, __ATOMIC_RELEASE);
+}
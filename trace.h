@@ -0,0 +1,86 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Трасса событий горячего пути (--trace N): кольцо из N записей в shared
+// memory (/sensors2shm_trace) — опрос датчика, готовность кадра, начало и
+// конец чтения, разбор, публикация, пауза основного цикла. Ничего не пишет
+// на SD-карту: снимок кольца — копия файла из /dev/shm, trace_to_chrome.py
+// переводит его в JSON для chrome://tracing и Perfetto.
+//
+// Писатели (основной цикл и потоки чтения) берут номер записи атомарным
+// счётчиком head и не ждут друг друга. Поле seq записи пишется последним и
+// равно номеру записи + 1: запись, у которой seq не совпадает с её местом
+// в кольце, не дописана или уже перезаписана. Без --trace каждое событие —
+// одна проверка указателя.
+
+#include <stdint.h>
+
+#define TRACE_SHM_NAME "/sensors2shm_trace"
+#define TRACE_MAGIC 0x54533253u // "S2ST"
+#define TRACE_VERSION 1
+#define TRACE_MAX_SENSORS 64
+
+// Размер кольца в записях: степень двойки в этих пределах
+#define TRACE_MIN_RECORDS 1024u
+#define TRACE_MAX_RECORDS (1u << 24)
+
+// Событие не относится к датчику (пауза основного цикла)
+#define TRACE_NO_SENSOR 255
+
+typedef enum {
+  TRACE_POLL_START = 1, // Опрос готовности кадра
+  TRACE_POLL_DONE,      // Ответ на опрос, arg — кадр готов (0/1)
+  TRACE_READ_START,     // Начало чтения кадра
+  TRACE_READ_END,       // Кадр прочитан, arg — байт
+  TRACE_PARSE_DONE,     // Разбор кадра, arg — статус драйвера
+  TRACE_PUBLISHED,      // Кадр в shared memory, arg — номер публикации
+  TRACE_SLEEP_START,    // Пауза основного цикла
+  TRACE_SLEEP_END,
+  TRACE_IRQ // Фронт INT (кадр из кольца модуля ядра), arg — байт
+} TraceEvent;
+
+typedef struct {
+  uint64_t timestamp_ns; // CLOCK_MONOTONIC
+  uint32_t seq;          // Номер записи + 1, 0 — запись не дописана
+  uint8_t sensor;        // Номер датчика или TRACE_NO_SENSOR
+  uint8_t event;         // TraceEvent
+  uint16_t arg;
+} TraceRecord;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t sensor_count;
+  uint32_t capacity; // Записей в кольце (степень двойки)
+  uint32_t head;     // Записей с запуска; следующая — head % capacity
+  char names[TRACE_MAX_SENSORS][32];
+  TraceRecord records[];
+} TraceRing;
+
+// NULL — трассировка выключена
+extern TraceRing *trace_ring;
+
+// Создание кольца не меньше чем на records записей. 0 — успех. Кольцо
+// остаётся в /dev/shm после завершения демона, чтобы снять его снимок
+int trace_open(uint32_t records, int sensor_count);
+void trace_close(void);
+
+void trace_set_sensor(int sensor, const char *name);
+
+// Запись события; timestamp_ns 0 — текущее время
+void trace_record(uint8_t sensor, uint8_t event, uint16_t arg,
+                  uint64_t timestamp_ns);
+
+static inline void trace_event(uint8_t sensor, TraceEvent event,
+                               uint16_t arg) {
+  if (trace_ring)
+    trace_record(sensor, event, arg, 0);
+}
+
+static inline void trace_event_at(uint8_t sensor, TraceEvent event,
+                                  uint16_t arg, uint64_t timestamp_ns) {
+  if (trace_ring)
+    trace_record(sensor, event, arg, timestamp_ns);
+}
+
+#endif
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+Перевод снимка трассы демона (--trace) в JSON для chrome://tracing и Perfetto
+Запуск: python3 trace_to_chrome.py [снимок] [-o trace.json]
+
+Снимок — копия /dev/shm/sensors2shm_trace (по умолчанию читается сам файл).
+Каждый датчик — отдельная дорожка: опрос готовности (check_ready), чтение
+кадра (read), разбор (parse), публикация (publish); пауза основного цикла —
+на дорожке main loop. Формат кольца описан в trace.h
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+TRACE_MAGIC = 0x54533253
+TRACE_VERSION = 1
+TRACE_MAX_SENSORS = 64
+TRACE_NO_SENSOR = 255
+
+HEADER = struct.Struct("<IHHII")
+NAME_SIZE = 32
+RECORD = struct.Struct("<QIBBH")
+
+(
+    POLL_START,
+    POLL_DONE,
+    READ_START,
+    READ_END,
+    PARSE_DONE,
+    PUBLISHED,
+    SLEEP_START,
+    SLEEP_END,
+    IRQ,
+) = range(1, 10)
+
+# Длительности: событие конца -> (событие начала, имя отрезка)
+SPANS = {
+    POLL_DONE: (POLL_START, "check_ready"),
+    READ_END: (READ_START, "read"),
+    PARSE_DONE: (READ_END, "parse"),
+    PUBLISHED: (PARSE_DONE, "publish"),
+    SLEEP_END: (SLEEP_START, "sleep"),
+}
+
+
+def load_ring(data: bytes):
+    """Заголовок, имена датчиков и дописанные записи в порядке номеров"""
+    magic, version, sensor_count, capacity, head = HEADER.unpack_from(data, 0)
+    if magic != TRACE_MAGIC or version != TRACE_VERSION:
+        raise ValueError("не снимок трассы sensors2shm")
+
+    names_offset = HEADER.size
+    records_offset = names_offset + TRACE_MAX_SENSORS * NAME_SIZE
+    names = []
+    for i in range(sensor_count):
+        raw = data[names_offset + i * NAME_SIZE : names_offset + (i + 1) * NAME_SIZE]
+        names.append(raw.split(b"\0", 1)[0].decode(errors="replace"))
+
+    records = []
+    count = min(head, capacity)
+    for n in range(head - count, head):
+        index = n & 0xFFFFFFFF
+        offset = records_offset + (index & (capacity - 1)) * RECORD.size
+        timestamp_ns, seq, sensor, event, arg = RECORD.unpack_from(data, offset)
+        # Не дописанная или перезаписанная во время снимка запись
+        if seq != (index + 1) & 0xFFFFFFFF:
+            continue
+        records.append((timestamp_ns, sensor, event, arg))
+    return names, records, head, capacity
+
+
+def to_chrome(names, records):
+    events = []
+    tracks = {TRACE_NO_SENSOR: "main loop"}
+    for i, name in enumerate(names):
+        tracks[i] = name or f"sensor {i}"
+    for tid, name in tracks.items():
+        events.append(
+            {"ph": "M", "name": "thread_name", "pid": 1, "tid": tid, "args": {"name": name}}
+        )
+
+    # Последнее событие каждого вида на дорожке — начало отрезка
+    last = {}
+    for timestamp_ns, sensor, event, arg in records:
+        ts = timestamp_ns / 1000.0
+        if event in SPANS:
+            start_event, name = SPANS[event]
+            start = last.get((sensor, start_event))
+            if start is not None and start <= ts:
+                events.append(
+                    {
+                        "ph": "X",
+                        "name": name,
+                        "pid": 1,
+                        "tid": sensor,
+                        "ts": start,
+                        "dur": ts - start,
+                        "args": {"arg": arg},
+                    }
+                )
+            last.pop((sensor, start_event), None)
+        if event == POLL_DONE and arg:
+            events.append(
+                {"ph": "i", "name": "data_ready", "pid": 1, "tid": sensor, "ts": ts, "s": "t"}
+            )
+        elif event == IRQ:
+            events.append(
+                {
+                    "ph": "i",
+                    "name": "irq",
+                    "pid": 1,
+                    "tid": sensor,
+                    "ts": ts,
+                    "s": "t",
+                    "args": {"bytes": arg},
+                }
+            )
+        last[(sensor, event)] = ts
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("snapshot", nargs="?", default="/dev/shm/sensors2shm_trace")
+    parser.add_argument("-o", "--output", default="trace.json")
+    args = parser.parse_args()
+
+    with open(args.snapshot, "rb") as f:
+        data = f.read()
+    try:
+        names, records, head, capacity = load_ring(data)
+    except (ValueError, struct.error) as e:
+        print(f"{args.snapshot}: {e}", file=sys.stderr)
+        return 1
+
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(names, records), f)
+    print(
+        f"{len(records)} событий из {head} (кольцо на {capacity}) -> {args.output}"
+    )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,144 @@
+#include "zone_filter.h"
+
+#include <string.h>
+
+// Шум измерения без range_sigma_mm
+#define DEFAULT_SIGMA_MM 10.0f
+
+static const struct {
+  const char *name;
+  ZoneFilterKind kind;
+} kind_names[] = {
+    {"median3", ZONE_FILTER_MEDIAN3},
+    {"median5", ZONE_FILTER_MEDIAN5},
+    {"ema", ZONE_FILTER_EMA},
+    {"kalman", ZONE_FILTER_KALMAN},
+};
+
+int zone_filter_parse_kind(const char *name, ZoneFilterKind *kind) {
+  for (size_t i = 0; i < sizeof(kind_names) / sizeof(kind_names[0]); i++) {
+    if (strcmp(name, kind_names[i].name) == 0) {
+      *kind = kind_names[i].kind;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void zone_filter_init(ZoneFilter *filter, const ZoneFilterParams *params) {
+  memset(filter, 0, sizeof(*filter));
+  filter->params = *params;
+}
+
+// Статусы VL53L5CX с достоверным расстоянием: 5 — измерение корректно,
+// 9 — корректно с широким импульсом
+static inline int zone_valid(uint8_t status) {
+  return status == 5 || status == 9;
+}
+
+static inline uint16_t min_u16(uint16_t a, uint16_t b) { return a < b ? a : b; }
+static inline uint16_t max_u16(uint16_t a, uint16_t b) { return a > b ? a : b; }
+
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+  return max_u16(min_u16(a, b), min_u16(max_u16(a, b), c));
+}
+
+static inline uint16_t median5(uint16_t a, uint16_t b, uint16_t c, uint16_t d,
+                               uint16_t e) {
+  return median3(e, max_u16(min_u16(a, b), min_u16(c, d)),
+                 min_u16(max_u16(a, b), max_u16(c, d)));
+}
+
+// Вход фильтра: недостоверная зона повторяет прошлый результат
+static void filter_input(const ZoneFilter *filter, uint8_t zones,
+                         const uint16_t *distances, const uint8_t *statuses,
+                         uint16_t *input) {
+  int first = filter->frames == 0;
+  for (int i = 0; i < zones; i++)
+    input[i] = zone_valid(statuses[i]) || first ? distances[i]
+                                                : filter->output[i];
+}
+
+static void apply_median(ZoneFilter *filter, uint8_t zones,
+                         const uint16_t *input, int length) {
+  // Первый кадр заполняет всю историю: медиана сразу определена
+  if (filter->frames == 0) {
+    for (int k = 0; k < length; k++)
+      memcpy(filter->history[k], input, zones * sizeof(*input));
+  } else {
+    memcpy(filter->history[filter->frames % length], input,
+           zones * sizeof(*input));
+  }
+
+  uint16_t(*h)[ZONE_FILTER_ZONES] = filter->history;
+  if (length == 3) {
+    for (int i = 0; i < zones; i++)
+      filter->output[i] = median3(h[0][i], h[1][i], h[2][i]);
+  } else {
+    for (int i = 0; i < zones; i++)
+      filter->output[i] = median5(h[0][i], h[1][i], h[2][i], h[3][i], h[4][i]);
+  }
+}
+
+static void apply_ema(ZoneFilter *filter, uint8_t zones,
+                      const uint16_t *input) {
+  float alpha = filter->frames == 0 ? 1.0f : filter->params.alpha;
+  for (int i = 0; i < zones; i++) {
+    filter->estimate[i] += alpha * ((float)input[i] - filter->estimate[i]);
+    filter->output[i] = (uint16_t)(filter->estimate[i] + 0.5f);
+  }
+}
+
+static void apply_kalman(ZoneFilter *filter, uint8_t zones,
+                         const uint16_t *distances, const uint8_t *statuses,
+                         const uint16_t *sigma_mm) {
+  float q = filter->params.process_noise_mm * filter->params.process_noise_mm;
+  for (int i = 0; i < zones; i++) {
+    float sigma = sigma_mm ? (float)sigma_mm[i] : DEFAULT_SIGMA_MM;
+    float r = sigma < 1.0f ? 1.0f : sigma * sigma;
+    float z = (float)distances[i];
+    float p = filter->variance[i];
+    int valid = zone_valid(statuses[i]);
+
+    // Зона без оценки принимает первое достоверное измерение целиком
+    float p_pred = p > 0.0f ? p + q : 0.0f;
+    float gain = valid ? (p > 0.0f ? p_pred / (p_pred + r) : 1.0f) : 0.0f;
+    filter->estimate[i] += gain * (z - filter->estimate[i]);
+    filter->variance[i] = valid ? (p > 0.0f ? (1.0f - gain) * p_pred : r)
+                                : p_pred;
+    filter->output[i] = filter->variance[i] > 0.0f
+                            ? (uint16_t)(filter->estimate[i] + 0.5f)
+                            : distances[i];
+  }
+}
+
+void zone_filter_apply(ZoneFilter *filter, uint8_t zones,
+                       const uint16_t *distances, const uint8_t *statuses,
+                       const uint16_t *sigma_mm, uint16_t *out) {
+  uint16_t input[ZONE_FILTER_ZONES];
+
+  if (zones > ZONE_FILTER_ZONES)
+    zones = ZONE_FILTER_ZONES;
+
+  switch (filter->params.kind) {
+  case ZONE_FILTER_MEDIAN3:
+  case ZONE_FILTER_MEDIAN5:
+    filter_input(filter, zones, distances, statuses, input);
+    apply_median(filter, zones, input,
+                 filter->params.kind == ZONE_FILTER_MEDIAN3 ? 3 : 5);
+    break;
+  case ZONE_FILTER_EMA:
+    filter_input(filter, zones, distances, statuses, input);
+    apply_ema(filter, zones, input);
+    break;
+  case ZONE_FILTER_KALMAN:
+    apply_kalman(filter, zones, distances, statuses, sigma_mm);
+    break;
+  case ZONE_FILTER_NONE:
+    memcpy(filter->output, distances, zones * sizeof(*distances));
+    break;
+  }
+
+  filter->frames++;
+  memcpy(out, filter->output, zones * sizeof(*out));
+}
@@ -0,0 +1,53 @@
+#ifndef ZONE_FILTER_H
+#define ZONE_FILTER_H
+
+// Фильтр расстояний по зонам VL53L5CX между кадрами (опция filter= в
+// конфиге): медиана 3 или 5 кадров, экспоненциальное сглаживание или
+// одномерный фильтр Калмана с шумом измерения из range_sigma_mm. Зоны
+// с недостоверным статусом не входят в фильтр: для них держится прошлое
+// значение. Циклы идут по всем зонам без ветвлений и векторизуются
+// компилятором (сборки o3 и pgo).
+
+#include <stdint.h>
+
+#define ZONE_FILTER_ZONES 64
+#define ZONE_FILTER_MAX_HISTORY 5
+
+typedef enum {
+  ZONE_FILTER_NONE,
+  ZONE_FILTER_MEDIAN3,
+  ZONE_FILTER_MEDIAN5,
+  ZONE_FILTER_EMA,
+  ZONE_FILTER_KALMAN
+} ZoneFilterKind;
+
+typedef struct {
+  ZoneFilterKind kind;
+  float alpha;            // Вес нового кадра для EMA (0..1]
+  float process_noise_mm; // Калман: ожидаемое изменение расстояния за кадр
+} ZoneFilterParams;
+
+#define ZONE_FILTER_DEFAULT_ALPHA 0.3f
+#define ZONE_FILTER_DEFAULT_NOISE_MM 20.0f
+
+typedef struct {
+  ZoneFilterParams params;
+  uint32_t frames; // Кадров пропущено через фильтр
+  uint16_t history[ZONE_FILTER_MAX_HISTORY][ZONE_FILTER_ZONES];
+  float estimate[ZONE_FILTER_ZONES]; // EMA и Калман: текущая оценка
+  float variance[ZONE_FILTER_ZONES]; // Калман: дисперсия оценки
+  uint16_t output[ZONE_FILTER_ZONES];
+} ZoneFilter;
+
+// Имя фильтра из конфига: median3, median5, ema, kalman. 0 — успех
+int zone_filter_parse_kind(const char *name, ZoneFilterKind *kind);
+
+void zone_filter_init(ZoneFilter *filter, const ZoneFilterParams *params);
+
+// Кадр из zones зон; sigma_mm нужна только Калману (NULL — 10 мм для всех
+// зон). Результат — в out
+void zone_filter_apply(ZoneFilter *filter, uint8_t zones,
+                       const uint16_t *distances, const uint8_t *statuses,
+                       const uint16_t *sigma_mm, uint16_t *out);
+
+#endif